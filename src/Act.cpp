@@ -5,7 +5,8 @@
 
 Act::Act(const std::string &name, std::string timeStr, int length,
            bool isRigid)
-    : name(name),
+    : id(0),
+      name(name),
       startStr(timeStr),
       length(length),
       actLength(0),
@@ -16,7 +17,8 @@ Act::Act(const std::string &name, std::string timeStr, int length,
   setStartTime(timeStr);
 }
 Act::Act(const std::string &name, int length, bool isRigid)
-    : name(name),
+    : id(0),
+      name(name),
       startStr("09:00"),
       length(length),
       actLength(0),
@@ -86,17 +88,28 @@ void Act::setCurrentTime() {
   void Act::setRigid(bool isRigid) { rigid = isRigid; }
   void Act::setFixed() { fixed = !fixed; }
   void Act::toggleFrozen() { frozen = !frozen; }
+  void Act::setFrozen(bool isFrozen) { frozen = isFrozen; }
+  void Act::setId(uint64_t taskId) { id = taskId; }
   void Act::setName(const std::string& newName) { name = newName; }
   void Act::setLength(int newLength) { length = newLength; }
   int Act::getLength() const { return length; }
   int Act::getActLength() const { return static_cast<int>(actLength); }
+  int Act::getFrozenLength() const { return frozenLength; }
   int Act::getStartInt() const { return startInt; }
   std::string Act::getStartStr() const {return startStr;}
   bool Act::isRigid() const { return rigid; }
   bool Act::isFixed() const { return fixed; }
   bool Act::isFrozen() const { return frozen; }
   std::string Act::getName() const { return name; }
-  void Act::displayTask() {
+  uint64_t Act::getId() const { return id; }
+  size_t Act::getHeapBytes() const {
+    const size_t inlineCapacity = std::string().capacity();
+    auto heapBytes = [inlineCapacity](const std::string& text) {
+      return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+    };
+    return heapBytes(name) + heapBytes(startStr);
+  }
+  void Act::displayTask() const {
     std::cout << "Task: " << name << ", Start Time: " << startStr
               << ", Length: " << length << " minutes"
               << ", ActLen: " << actLength << " minutes" << std::endl;
@@ -1,10 +1,12 @@
 #ifndef TASK_H
 #define TASK_H
 
+#include <cstdint>
 #include <string>
 
 class Act {
  private:
+  uint64_t id;  // Stable identity assigned by TaskManager, 0 until then
   std::string name;
 
   int startInt;
@@ -22,7 +24,7 @@ class Act {
   Act(const std::string &name, std::string timeStr, int length, bool isRigid);
   Act(const std::string &name, int length, bool isRigid);
   int timeStringToMinutes(const std::string &timeStr);
-  std::string minutesToTime(int totalMinutes);
+  static std::string minutesToTime(int totalMinutes);
   void setStartTime(std::string timeStr);
   void setStartTime(int Minutes);
   void setCurrentTime();
@@ -33,17 +35,22 @@ class Act {
   void setRigid(bool isRigid);
   void setFixed();
   void toggleFrozen();
+  void setFrozen(bool isFrozen);
+  void setId(uint64_t taskId);
   void setName(const std::string& newName);
   void setLength(int newLength);
   int getLength() const;
   int getActLength() const;
+  int getFrozenLength() const;
   int getStartInt() const;
   std::string getStartStr() const;
   bool isRigid() const;
   bool isFixed() const;
   bool isFrozen() const;
   std::string getName() const;
-  void displayTask();
+  uint64_t getId() const;
+  size_t getHeapBytes() const;  // Storage of the strings beyond the object itself
+  void displayTask() const;
 };
 
 #endif  // TASK_H
@@ -0,0 +1,462 @@
+#include "ArchiveStore.h"
+#include "ContentHash.h"
+#include "ContentStore.h"
+#include "DateRange.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x52414c50;  // "PLAR"
+constexpr uint32_t LEAF_PAGE = 1;
+constexpr uint32_t INTERNAL_PAGE = 2;
+constexpr uint32_t MAX_DEPTH = 16;
+
+// Page layout: u32 type, u32 count, u64 next leaf (0 = none), u64 checksum
+// of the page with this field zeroed, then the entries
+constexpr size_t PAGE_HEADER = 24;
+constexpr size_t CHECKSUM_AT = 16;
+constexpr size_t LEAF_ENTRY = 32;      // i64 day, u64 offset, u32 unused, i32 saved day, u64 ordering key
+constexpr size_t INTERNAL_ENTRY = 16;  // i64 smallest day below, u64 child page
+constexpr size_t LEAF_CAPACITY = (ArchiveStore::PAGE_SIZE - PAGE_HEADER) / LEAF_ENTRY;
+constexpr size_t INTERNAL_CAPACITY = (ArchiveStore::PAGE_SIZE - PAGE_HEADER) / INTERNAL_ENTRY;
+
+// Header page: u32 magic, u32 version, u32 page size, u32 depth, u64 root
+// page, u64 day count, u64 page count, u64 ordering count, u64 task record
+// count, u64 checksum of the first 56 bytes
+constexpr size_t HEADER_CHECKSUM_AT = 56;
+
+// Version 1 kept whole data files: the header ended with its checksum at 40,
+// leaves held i64 day, u64 offset, u32 length, u32 unused, u64 checksum,
+// and each record was i64 day, u32 length, content
+constexpr size_t V1_HEADER_CHECKSUM_AT = 40;
+constexpr size_t V1_RECORD_HEADER = 12;
+
+// Each object: u64 key (the hash of its bytes), u32 length, u32 reference
+// count, the bytes, then one u64 offset per reference (an ordering's task
+// records, in order). Archives never leave the machine, so host byte order
+// is fine throughout.
+constexpr size_t OBJECT_HEADER = 16;
+constexpr uint32_t MAX_REFERENCES = 1 << 20;
+
+template <typename T>
+void put(std::string& buffer, size_t at, T value) {
+  std::memcpy(&buffer[at], &value, sizeof(value));
+}
+
+template <typename T>
+T get(const std::string& buffer, size_t at) {
+  T value;
+  std::memcpy(&value, buffer.data() + at, sizeof(value));
+  return value;
+}
+
+uint64_t pageChecksum(std::string page, size_t checksumAt) {
+  put<uint64_t>(page, checksumAt, 0);
+  return hashContent(page);
+}
+
+void sealPage(std::string& page) {
+  put<uint64_t>(page, CHECKSUM_AT, pageChecksum(page, CHECKSUM_AT));
+}
+
+}  // namespace
+
+ArchiveStore::ArchiveStore(const std::string& path)
+    : path(path), valid(false), version(0), depth(0), rootPage(0), dayCount(0), pageCount(0), orderingCount(0), taskCount(0) {}
+
+bool ArchiveStore::open() {
+  valid = false;
+  file.close();
+  file.clear();
+  file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::string header(PAGE_SIZE, '\0');
+  if (!file.read(&header[0], PAGE_SIZE) || get<uint32_t>(header, 0) != MAGIC ||
+      (get<uint32_t>(header, 4) != VERSION && get<uint32_t>(header, 4) != 1) ||
+      get<uint32_t>(header, 8) != PAGE_SIZE) {
+    return false;
+  }
+  version = get<uint32_t>(header, 4);
+  size_t checksumAt = version == 1 ? V1_HEADER_CHECKSUM_AT : HEADER_CHECKSUM_AT;
+  if (get<uint64_t>(header, checksumAt) != pageChecksum(header, checksumAt)) {
+    return false;
+  }
+
+  depth = get<uint32_t>(header, 12);
+  rootPage = get<uint64_t>(header, 16);
+  dayCount = get<uint64_t>(header, 24);
+  pageCount = get<uint64_t>(header, 32);
+  orderingCount = version == 1 ? dayCount : get<uint64_t>(header, 40);
+  taskCount = version == 1 ? 0 : get<uint64_t>(header, 48);
+  valid = depth <= MAX_DEPTH && (dayCount == 0 || (depth > 0 && rootPage > 0 && rootPage < pageCount));
+  return valid;
+}
+
+bool ArchiveStore::isOpen() const {
+  return valid;
+}
+
+size_t ArchiveStore::size() const {
+  return valid ? static_cast<size_t>(dayCount) : 0;
+}
+
+size_t ArchiveStore::distinctDays() const {
+  return valid ? static_cast<size_t>(orderingCount) : 0;
+}
+
+size_t ArchiveStore::distinctTasks() const {
+  return valid ? static_cast<size_t>(taskCount) : 0;
+}
+
+bool ArchiveStore::readPage(uint64_t page, std::string& buffer) {
+  if (page == 0 || page >= pageCount) {
+    return false;
+  }
+  buffer.assign(PAGE_SIZE, '\0');
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(page * PAGE_SIZE));
+  return file.read(&buffer[0], PAGE_SIZE) &&
+         get<uint64_t>(buffer, CHECKSUM_AT) == pageChecksum(buffer, CHECKSUM_AT);
+}
+
+bool ArchiveStore::findLeaf(int64_t day, uint64_t& page) {
+  if (!valid || dayCount == 0) {
+    return false;
+  }
+
+  std::string buffer;
+  page = rootPage;
+  for (uint32_t level = 1; level < depth; level++) {
+    if (!readPage(page, buffer) || get<uint32_t>(buffer, 0) != INTERNAL_PAGE) {
+      return false;
+    }
+    uint32_t count = std::min<uint32_t>(get<uint32_t>(buffer, 4), INTERNAL_CAPACITY);
+    if (count == 0) {
+      return false;
+    }
+
+    // Last child whose smallest day is not after day; the first one for
+    // days before everything archived
+    uint32_t low = 0, high = count;
+    while (high - low > 1) {
+      uint32_t middle = (low + high) / 2;
+      if (get<int64_t>(buffer, PAGE_HEADER + middle * INTERNAL_ENTRY) <= day) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    page = get<uint64_t>(buffer, PAGE_HEADER + low * INTERNAL_ENTRY + 8);
+  }
+  return true;
+}
+
+const ArchiveStore::Object* ArchiveStore::readObject(uint64_t offset, std::unordered_map<uint64_t, Object>& cache) {
+  auto cached = cache.find(offset);
+  if (cached != cache.end()) {
+    return &cached->second;
+  }
+
+  std::string header(OBJECT_HEADER, '\0');
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(offset));
+  if (offset < PAGE_SIZE || !file.read(&header[0], OBJECT_HEADER)) {
+    return nullptr;
+  }
+  Object object;
+  object.key = get<uint64_t>(header, 0);
+  uint32_t length = get<uint32_t>(header, 8);
+  uint32_t referenceCount = get<uint32_t>(header, 12);
+  if (referenceCount > MAX_REFERENCES ||
+      offset + OBJECT_HEADER + length + referenceCount * 8ull > pageCount * PAGE_SIZE) {
+    return nullptr;
+  }
+
+  object.bytes.assign(length, '\0');
+  std::string references(referenceCount * 8ull, '\0');
+  if ((length > 0 && !file.read(&object.bytes[0], length)) ||
+      (referenceCount > 0 && !file.read(&references[0], static_cast<std::streamsize>(references.size()))) ||
+      hashContent(object.bytes) != object.key) {
+    return nullptr;
+  }
+  for (uint32_t i = 0; i < referenceCount; i++) {
+    object.references.push_back(get<uint64_t>(references, i * 8ull));
+  }
+  return &cache.emplace(offset, std::move(object)).first->second;
+}
+
+bool ArchiveStore::readRecord(const Location& location, std::string& content) {
+  std::string header(V1_RECORD_HEADER, '\0');
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(location.offset));
+  if (location.offset < PAGE_SIZE || location.offset + V1_RECORD_HEADER + location.length > pageCount * PAGE_SIZE ||
+      !file.read(&header[0], V1_RECORD_HEADER) || get<int64_t>(header, 0) != location.day ||
+      get<uint32_t>(header, 8) != location.length) {
+    return false;
+  }
+  content.assign(location.length, '\0');
+  return (location.length == 0 || file.read(&content[0], location.length)) && hashContent(content) == location.key;
+}
+
+bool ArchiveStore::read(const std::string& date, std::string& content) {
+  std::vector<std::pair<std::string, std::string>> days;
+  if (!scan(date, date, days) || days.empty()) {
+    return false;
+  }
+  content = std::move(days.front().second);
+  return true;
+}
+
+bool ArchiveStore::dayKey(const std::string& date, uint64_t& key) {
+  int64_t day = 0;
+  std::vector<Location> locations;
+  if (!DateRange::toDayNumber(date, day) || !findLocations(day, day, locations, true) || locations.empty()) {
+    return false;
+  }
+  if (version == 1) {
+    // Leaves only checksum the whole file there
+    std::string content;
+    return readRecord(locations.front(), content) && ContentStore::dayKey(content, key);
+  }
+  key = locations.front().key;
+  return true;
+}
+
+bool ArchiveStore::findLocations(int64_t firstDay, int64_t lastDay, std::vector<Location>& locations,
+                                 bool strict) {
+  uint64_t page = 0;
+  if (!findLeaf(firstDay, page)) {
+    return false;
+  }
+
+  // Walk the leaf chain from the first day on; at most dayCount entries
+  std::string buffer;
+  for (uint64_t visited = 0; page != 0 && visited <= dayCount; ) {
+    if (!readPage(page, buffer) || get<uint32_t>(buffer, 0) != LEAF_PAGE) {
+      return !strict;
+    }
+    uint32_t count = std::min<uint32_t>(get<uint32_t>(buffer, 4), LEAF_CAPACITY);
+    for (uint32_t i = 0; i < count; i++, visited++) {
+      size_t at = PAGE_HEADER + i * LEAF_ENTRY;
+      int64_t day = get<int64_t>(buffer, at);
+      if (day > lastDay) {
+        page = 0;
+        break;
+      }
+      if (day >= firstDay) {
+        locations.push_back({day, get<uint64_t>(buffer, at + 8), get<int32_t>(buffer, at + 20),
+                             get<uint64_t>(buffer, at + 24), get<uint32_t>(buffer, at + 16)});
+      }
+    }
+    if (page != 0) {
+      page = get<uint64_t>(buffer, 8);
+    }
+  }
+  return true;
+}
+
+bool ArchiveStore::readDay(const Location& location, std::unordered_map<uint64_t, Object>& cache,
+                           std::string& content) {
+  if (version == 1) {
+    return readRecord(location, content);
+  }
+
+  const Object* ordering = readObject(location.offset, cache);
+  if (!ordering || ordering->key != location.key) {
+    return false;
+  }
+  DayObjects day;
+  day.ordering = ordering->bytes;
+  for (uint64_t reference : ordering->references) {
+    const Object* task = readObject(reference, cache);
+    if (!task) {
+      return false;
+    }
+    day.tasks.push_back(task->bytes);
+  }
+  if (location.savedDay != NO_SAVED_DAY) {
+    day.savedDate = DateRange::fromDayNumber(location.savedDay);
+  }
+  return ContentStore::joinDay(day, content);
+}
+
+bool ArchiveStore::scanDays(const std::string& first, const std::string& last,
+                            std::vector<std::pair<std::string, std::string>>& days, bool strict) {
+  days.clear();
+  int64_t firstDay = 0, lastDay = 0;
+  std::vector<Location> locations;
+  if (!DateRange::toDayNumber(first, firstDay) || !DateRange::toDayNumber(last, lastDay) ||
+      !findLocations(firstDay, lastDay, locations, strict)) {
+    return false;
+  }
+
+  // Days repeating a routine share its objects, which are read once per scan
+  std::unordered_map<uint64_t, Object> cache;
+  for (const Location& location : locations) {
+    std::string content;
+    if (!readDay(location, cache, content)) {
+      if (strict) {
+        return false;
+      }
+      continue;  // Reads as a missing day
+    }
+    days.emplace_back(DateRange::fromDayNumber(location.day), std::move(content));
+  }
+  return true;
+}
+
+bool ArchiveStore::scan(const std::string& first, const std::string& last,
+                        std::vector<std::pair<std::string, std::string>>& days) {
+  return scanDays(first, last, days, false);
+}
+
+bool ArchiveStore::scanIntact(const std::string& first, const std::string& last,
+                              std::vector<std::pair<std::string, std::string>>& days) {
+  return scanDays(first, last, days, true);
+}
+
+bool ArchiveStore::write(const std::string& path, const std::map<std::string, std::string>& days) {
+  std::string tempPath = path + ".tmp";
+  std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    return false;
+  }
+
+  // Objects first, right after the header page, each the first time a day
+  // in date order (the map's order, since dates are YYYY-MM-DD) uses it
+  ContentStore objects;
+  std::unordered_map<uint64_t, uint64_t> offsets;  // Key -> where it was written
+  uint64_t orderingCount = 0;
+  uint64_t offset = PAGE_SIZE;
+  auto writeObject = [&](uint64_t key, const std::string& bytes, const std::vector<uint64_t>& references) {
+    if (objects.contains(key)) {
+      return objects.put(key, bytes);  // False: a different object with the same hash
+    }
+    if (bytes.size() > UINT32_MAX || references.size() > MAX_REFERENCES) {
+      return false;
+    }
+    objects.put(key, bytes);
+    offsets[key] = offset;
+    std::string header(OBJECT_HEADER, '\0');
+    put<uint64_t>(header, 0, key);
+    put<uint32_t>(header, 8, static_cast<uint32_t>(bytes.size()));
+    put<uint32_t>(header, 12, static_cast<uint32_t>(references.size()));
+    out.write(header.data(), OBJECT_HEADER);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    for (uint64_t reference : references) {
+      out.write(reinterpret_cast<const char*>(&reference), sizeof(reference));
+    }
+    offset += OBJECT_HEADER + bytes.size() + references.size() * sizeof(uint64_t);
+    return true;
+  };
+
+  std::vector<Location> locations;
+  locations.reserve(days.size());
+  out.seekp(static_cast<std::streamoff>(offset));
+  for (const auto& [date, content] : days) {
+    int64_t day = 0;
+    int64_t savedDay = 0;
+    DayObjects objectsOfDay;
+    if (!DateRange::toDayNumber(date, day) || !ContentStore::splitDay(content, objectsOfDay)) {
+      return false;
+    }
+    if (!objectsOfDay.savedDate.empty() &&
+        (!DateRange::toDayNumber(objectsOfDay.savedDate, savedDay) || savedDay <= NO_SAVED_DAY ||
+         savedDay > INT32_MAX)) {
+      return false;
+    }
+
+    std::vector<uint64_t> references;
+    for (size_t i = 0; i < objectsOfDay.tasks.size(); i++) {
+      if (!writeObject(objectsOfDay.taskKeys[i], objectsOfDay.tasks[i], {})) {
+        return false;
+      }
+      references.push_back(offsets[objectsOfDay.taskKeys[i]]);
+    }
+    bool newOrdering = !objects.contains(objectsOfDay.orderingKey);
+    if (!writeObject(objectsOfDay.orderingKey, objectsOfDay.ordering, references)) {
+      return false;
+    }
+    orderingCount += newOrdering ? 1 : 0;
+    locations.push_back({day, offsets[objectsOfDay.orderingKey],
+                         objectsOfDay.savedDate.empty() ? NO_SAVED_DAY : static_cast<int32_t>(savedDay),
+                         objectsOfDay.orderingKey, 0});
+  }
+  uint64_t nextPage = (offset + PAGE_SIZE - 1) / PAGE_SIZE;
+
+  // Bulk-load the tree bottom up: full leaves, then full internal levels
+  // until one page is left
+  std::vector<std::pair<int64_t, uint64_t>> level;  // Smallest day, page
+  uint32_t depth = 0;
+  for (size_t start = 0; start < locations.size(); start += LEAF_CAPACITY) {
+    size_t count = std::min(LEAF_CAPACITY, locations.size() - start);
+    bool lastLeaf = start + count == locations.size();
+    std::string page(PAGE_SIZE, '\0');
+    put<uint32_t>(page, 0, LEAF_PAGE);
+    put<uint32_t>(page, 4, static_cast<uint32_t>(count));
+    put<uint64_t>(page, 8, lastLeaf ? 0 : nextPage + 1);
+    for (size_t i = 0; i < count; i++) {
+      const Location& location = locations[start + i];
+      size_t at = PAGE_HEADER + i * LEAF_ENTRY;
+      put<int64_t>(page, at, location.day);
+      put<uint64_t>(page, at + 8, location.offset);
+      put<int32_t>(page, at + 20, location.savedDay);
+      put<uint64_t>(page, at + 24, location.key);
+    }
+    sealPage(page);
+    out.seekp(static_cast<std::streamoff>(nextPage * PAGE_SIZE));
+    out.write(page.data(), PAGE_SIZE);
+    level.emplace_back(locations[start].day, nextPage++);
+  }
+  if (!level.empty()) {
+    depth = 1;
+  }
+  while (level.size() > 1) {
+    std::vector<std::pair<int64_t, uint64_t>> parents;
+    for (size_t start = 0; start < level.size(); start += INTERNAL_CAPACITY) {
+      size_t count = std::min(INTERNAL_CAPACITY, level.size() - start);
+      std::string page(PAGE_SIZE, '\0');
+      put<uint32_t>(page, 0, INTERNAL_PAGE);
+      put<uint32_t>(page, 4, static_cast<uint32_t>(count));
+      for (size_t i = 0; i < count; i++) {
+        put<int64_t>(page, PAGE_HEADER + i * INTERNAL_ENTRY, level[start + i].first);
+        put<uint64_t>(page, PAGE_HEADER + i * INTERNAL_ENTRY + 8, level[start + i].second);
+      }
+      sealPage(page);
+      out.seekp(static_cast<std::streamoff>(nextPage * PAGE_SIZE));
+      out.write(page.data(), PAGE_SIZE);
+      parents.emplace_back(level[start].first, nextPage++);
+    }
+    level = std::move(parents);
+    depth++;
+  }
+
+  std::string header(PAGE_SIZE, '\0');
+  put<uint32_t>(header, 0, MAGIC);
+  put<uint32_t>(header, 4, VERSION);
+  put<uint32_t>(header, 8, PAGE_SIZE);
+  put<uint32_t>(header, 12, depth);
+  put<uint64_t>(header, 16, level.empty() ? 0 : level.front().second);
+  put<uint64_t>(header, 24, locations.size());
+  put<uint64_t>(header, 32, std::max<uint64_t>(nextPage, 1));
+  put<uint64_t>(header, 40, orderingCount);
+  put<uint64_t>(header, 48, objects.objectCount() - orderingCount);
+  put<uint64_t>(header, HEADER_CHECKSUM_AT, pageChecksum(header, HEADER_CHECKSUM_AT));
+  out.seekp(0);
+  out.write(header.data(), PAGE_SIZE);
+  out.close();
+  if (!out) {
+    return false;
+  }
+
+  // Rename so a crash mid-write never leaves a half-written archive behind
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  return !ec;
+}
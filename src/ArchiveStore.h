@@ -0,0 +1,101 @@
+#ifndef ARCHIVESTORE_H
+#define ARCHIVESTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Single file holding the data files of many past days (`plan archive`), so
+// old history costs one inode instead of one per day. The file is made of
+// fixed-size pages: a header page, the days' objects (see ContentStore)
+// packed back to back, then a B+tree over the dates whose leaves point at
+// each day's ordering object. Task records and orderings are written once
+// however many days repeat them, so a day that copies a routine costs a leaf
+// entry. Looking up a day reads one page per tree level plus its objects.
+// Pages and objects carry checksums, and a damaged part reads as missing
+// rather than as garbage.
+//
+// An archive is never modified in place: adding days writes a new one next
+// to it and renames it over the old.
+class ArchiveStore {
+ public:
+  static constexpr uint32_t PAGE_SIZE = 4096;
+  static constexpr uint32_t VERSION = 2;
+
+  explicit ArchiveStore(const std::string& path);
+
+  // False if there is no archive or its header is damaged
+  bool open();
+  bool isOpen() const;
+  size_t size() const;  // Days archived
+  size_t distinctDays() const;   // Orderings stored
+  size_t distinctTasks() const;  // Task records stored
+
+  // A day's data file as archived (date is YYYY-MM-DD), formatted the way
+  // saveToFile writes it
+  bool read(const std::string& date, std::string& content);
+
+  // The day's ContentStore key, from the tree alone; equal keys mean equal tasks
+  bool dayKey(const std::string& date, uint64_t& key);
+
+  // Every archived day from first to last inclusive, oldest first. Days
+  // whose objects or record are damaged are left out, as are those after a
+  // damaged leaf; false only if the tree cannot be entered at all
+  bool scan(const std::string& first, const std::string& last,
+            std::vector<std::pair<std::string, std::string>>& days);
+  // scan, but false if any day in the range is damaged: for rewriting the
+  // archive, which must not lose days
+  bool scanIntact(const std::string& first, const std::string& last,
+                  std::vector<std::pair<std::string, std::string>>& days);
+
+  // Replace the archive at path with exactly these days (date -> data file
+  // bytes). False if it could not be written; the old archive stays intact.
+  static bool write(const std::string& path, const std::map<std::string, std::string>& days);
+
+ private:
+  struct Location {
+    int64_t day;  // Days since 1970-01-01
+    uint64_t offset;  // Of the ordering object
+    int32_t savedDay;  // The file's save date, NO_SAVED_DAY if it had none
+    uint64_t key;      // Of the ordering object
+    uint32_t length;   // Version 1: the day's record, whose checksum key is
+  };
+  struct Object {
+    uint64_t key;  // The hash of bytes, once read back
+    std::string bytes;
+    std::vector<uint64_t> references;  // Offsets of the objects an ordering lists
+  };
+  static constexpr int32_t NO_SAVED_DAY = INT32_MIN;
+
+  std::string path;
+  std::ifstream file;
+  bool valid;
+  uint32_t version;   // 1: whole data files as records, still readable
+  uint32_t depth;     // Tree levels, leaves included
+  uint64_t rootPage;
+  uint64_t dayCount;
+  uint64_t pageCount;
+  uint64_t orderingCount;
+  uint64_t taskCount;
+
+  bool readPage(uint64_t page, std::string& buffer);
+  // Leaf that holds day, or would if it were archived
+  bool findLeaf(int64_t day, uint64_t& page);
+  bool readRecord(const Location& location, std::string& content);  // Version 1
+  // Leaf entries for the days in range; a damaged leaf ends the walk, with
+  // false if strict
+  bool findLocations(int64_t firstDay, int64_t lastDay, std::vector<Location>& locations, bool strict);
+  // A day's data file rebuilt from its location; false if anything is damaged
+  bool readDay(const Location& location, std::unordered_map<uint64_t, Object>& cache, std::string& content);
+  bool scanDays(const std::string& first, const std::string& last,
+                std::vector<std::pair<std::string, std::string>>& days, bool strict);
+  // The object at offset if its bytes still match its key; objects already
+  // in cache (by offset) are not read again
+  const Object* readObject(uint64_t offset, std::unordered_map<uint64_t, Object>& cache);
+};
+
+#endif  // ARCHIVESTORE_H
@@ -0,0 +1,574 @@
+#include "ColumnStore.h"
+#include "ArchiveStore.h"
+#include "ContentHash.h"
+#include "DateRange.h"
+#include "PackStore.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x53434c50;  // "PLCS"
+
+// Header: u32 magic, u32 version, u64 checksum of the rest, then u64 counts
+// of names, sources, blocks, rows and active rows. The sections follow in
+// that order, host byte order like the other sidecars.
+constexpr size_t HEADER_SIZE = 56;
+
+template <typename T>
+void append(std::string& buffer, T value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void appendColumn(std::string& buffer, const std::vector<T>& column) {
+  buffer.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+void appendString(std::string& buffer, const std::string& value) {
+  append<uint32_t>(buffer, static_cast<uint32_t>(value.size()));
+  buffer += value;
+}
+
+// Reads what append() wrote; a read past the end makes ok false for good
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : data(data), position(0), ok(true) {}
+
+  template <typename T>
+  T get() {
+    T value{};
+    if (ok && data.size() - position >= sizeof(T)) {
+      std::memcpy(&value, data.data() + position, sizeof(T));
+      position += sizeof(T);
+    } else {
+      ok = false;
+    }
+    return value;
+  }
+
+  template <typename T>
+  void getColumn(std::vector<T>& column, uint64_t count) {
+    if (!ok || (data.size() - position) / sizeof(T) < count) {
+      ok = false;
+      return;
+    }
+    column.resize(count);
+    std::memcpy(column.data(), data.data() + position, count * sizeof(T));
+    position += count * sizeof(T);
+  }
+
+  std::string getString() {
+    uint32_t length = get<uint32_t>();
+    if (!ok || data.size() - position < length) {
+      ok = false;
+      return "";
+    }
+    std::string value = data.substr(position, length);
+    position += length;
+    return value;
+  }
+
+  const std::string& data;
+  size_t position;
+  bool ok;
+};
+
+int64_t modificationTime(const std::filesystem::path& path) {
+  std::error_code ec;
+  auto time = std::filesystem::last_write_time(path, ec);
+  return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+}  // namespace
+
+std::string ColumnStore::storePath(const std::string& dataDir) {
+  return dataDir + "/.stats.cols";
+}
+
+ColumnStore::ColumnStore(const std::string& path) : path(path), activeRows(0), checksum(0) {}
+
+void ColumnStore::clear() {
+  names.clear();
+  sources.clear();
+  blocks.clear();
+  activeRows = 0;
+  checksum = 0;
+  dates.clear();
+  nameIds.clear();
+  starts.clear();
+  lengths.clear();
+  actLengths.clear();
+  flags.clear();
+}
+
+bool ColumnStore::load() {
+  clear();
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+  // One read: with millions of rows the file runs to tens of megabytes
+  std::string data(static_cast<size_t>(std::max<std::streamoff>(file.tellg(), 0)), '\0');
+  file.seekg(0);
+  if (!file.read(&data[0], static_cast<std::streamsize>(data.size()))) {
+    return false;
+  }
+
+  Reader reader(data);
+  if (reader.get<uint32_t>() != MAGIC || reader.get<uint32_t>() != VERSION || data.size() < HEADER_SIZE) {
+    return false;
+  }
+  uint64_t stored = reader.get<uint64_t>();
+  if (stored != hashContent(data.data() + 16, data.size() - 16)) {
+    return false;
+  }
+  uint64_t nameCount = reader.get<uint64_t>();
+  uint64_t sourceCount = reader.get<uint64_t>();
+  uint64_t blockCount = reader.get<uint64_t>();
+  uint64_t rows = reader.get<uint64_t>();
+  uint64_t active = reader.get<uint64_t>();
+
+  // Every entry takes at least a byte, so counts beyond the file are damage
+  if (nameCount > data.size() || sourceCount > data.size() || blockCount > data.size() || rows > data.size() ||
+      active > rows) {
+    return false;
+  }
+  for (uint64_t i = 0; i < nameCount && reader.ok; i++) {
+    names.push_back(reader.getString());
+  }
+  for (uint64_t i = 0; i < sourceCount && reader.ok; i++) {
+    Source source;
+    source.kind = reader.get<uint32_t>();
+    source.path = reader.getString();
+    source.size = reader.get<uint64_t>();
+    source.modified = reader.get<int64_t>();
+    sources.push_back(std::move(source));
+  }
+  for (uint64_t i = 0; i < blockCount && reader.ok; i++) {
+    Block block;
+    block.day = reader.get<int32_t>();
+    block.source = reader.get<uint32_t>();
+    block.rowStart = reader.get<uint64_t>();
+    block.rowCount = reader.get<uint32_t>();
+    block.active = reader.get<uint8_t>() != 0;
+    blocks.push_back(block);
+  }
+  reader.getColumn(dates, rows);
+  reader.getColumn(nameIds, rows);
+  reader.getColumn(starts, rows);
+  reader.getColumn(lengths, rows);
+  reader.getColumn(actLengths, rows);
+  reader.getColumn(flags, rows);
+  activeRows = static_cast<size_t>(active);
+
+  bool consistent = reader.ok && reader.position == data.size();
+  for (const Block& block : blocks) {
+    consistent = consistent && block.source < sources.size() && block.rowStart + block.rowCount <= rows;
+  }
+  for (size_t i = 0; i < rows && consistent; i++) {
+    consistent = nameIds[i] < names.size();
+  }
+  if (!consistent) {
+    clear();
+    return false;
+  }
+  checksum = stored;
+  return true;
+}
+
+bool ColumnStore::save() {
+  std::string body;
+  append<uint64_t>(body, names.size());
+  append<uint64_t>(body, sources.size());
+  append<uint64_t>(body, blocks.size());
+  append<uint64_t>(body, dates.size());
+  append<uint64_t>(body, activeRows);
+  for (const std::string& name : names) {
+    appendString(body, name);
+  }
+  for (const Source& source : sources) {
+    append<uint32_t>(body, source.kind);
+    appendString(body, source.path);
+    append<uint64_t>(body, source.size);
+    append<int64_t>(body, source.modified);
+  }
+  for (const Block& block : blocks) {
+    append<int32_t>(body, block.day);
+    append<uint32_t>(body, block.source);
+    append<uint64_t>(body, block.rowStart);
+    append<uint32_t>(body, block.rowCount);
+    append<uint8_t>(body, block.active ? 1 : 0);
+  }
+  appendColumn(body, dates);
+  appendColumn(body, nameIds);
+  appendColumn(body, starts);
+  appendColumn(body, lengths);
+  appendColumn(body, actLengths);
+  appendColumn(body, flags);
+
+  uint64_t bodyChecksum = hashContent(body);
+  std::string header;
+  append<uint32_t>(header, MAGIC);
+  append<uint32_t>(header, VERSION);
+  append<uint64_t>(header, bodyChecksum);
+
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return false;
+    }
+    out << header << body;
+    if (!out) {
+      return false;
+    }
+  }
+
+  // Rename so a crash mid-write never leaves a truncated store behind
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    return false;
+  }
+  checksum = bodyChecksum;
+  return true;
+}
+
+uint64_t ColumnStore::generation() const {
+  return checksum;
+}
+
+bool ColumnStore::refresh(const std::string& dataDir, const std::string& extension, const std::string& archivePath,
+                          const DayExtractor& extract, size_t threads, size_t& daysRead) {
+  daysRead = 0;
+
+  // The sources as they are now
+  std::vector<Source> current;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(dataDir, ec)) {
+    std::string name = entry.path().filename().string();
+    std::string month;
+    int64_t day = 0;
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    if (name.size() == 16 + extension.size() && name.compare(0, 6, "tasks_") == 0 &&
+        name.compare(16, std::string::npos, extension) == 0 && DateRange::toDayNumber(name.substr(6, 10), day)) {
+      current.push_back({DAY_FILE, entry.path().string(), entry.file_size(ec), modificationTime(entry.path())});
+    } else if (PackStore::monthOf(name, month)) {
+      current.push_back({PACK, entry.path().string(), entry.file_size(ec), modificationTime(entry.path())});
+    }
+  }
+  if (std::filesystem::is_regular_file(archivePath, ec)) {
+    current.push_back({ARCHIVE, archivePath, std::filesystem::file_size(archivePath, ec), modificationTime(archivePath)});
+  }
+  std::sort(current.begin(), current.end(), [](const Source& a, const Source& b) { return a.path < b.path; });
+
+  std::unordered_map<std::string, size_t> previous;  // Path -> index in sources
+  for (size_t i = 0; i < sources.size(); i++) {
+    previous[sources[i].path] = i;
+  }
+
+  // A day's rows before they go into the columns; names as new ids
+  struct Row {
+    uint32_t name;
+    int32_t start;
+    int32_t length;
+    int32_t actLength;
+    uint8_t flags;
+  };
+  struct DayRows {
+    int32_t day;
+    uint32_t source;
+    std::vector<Row> rows;
+  };
+  std::vector<std::string> newNames;
+  std::unordered_map<std::string, uint32_t> nameIndex;
+  auto intern = [&](const std::string& name) {
+    auto [found, added] = nameIndex.try_emplace(name, static_cast<uint32_t>(newNames.size()));
+    if (added) {
+      newNames.push_back(name);
+    }
+    return found->second;
+  };
+
+  // Which sources are still as the rows were taken from them
+  std::vector<size_t> unchanged(current.size(), SIZE_MAX);
+  bool changed = current.size() != sources.size();
+  for (size_t index = 0; index < current.size(); index++) {
+    auto old = previous.find(current[index].path);
+    if (old != previous.end() && sources[old->second].kind == current[index].kind &&
+        sources[old->second].size == current[index].size && sources[old->second].modified == current[index].modified) {
+      unchanged[index] = old->second;
+    }
+    changed = changed || unchanged[index] != index;
+  }
+  if (!changed) {
+    return false;
+  }
+
+  // Unchanged sources keep their rows; the days of the others are read again
+  std::vector<DayRows> days;
+  std::vector<uint32_t> renamed(names.size(), UINT32_MAX);
+  struct Job {
+    int32_t day;
+    uint32_t source;
+    std::string content;
+    std::string filename;
+  };
+  std::vector<Job> jobs;
+  for (uint32_t index = 0; index < current.size(); index++) {
+    const Source& source = current[index];
+    if (unchanged[index] != SIZE_MAX) {
+      for (const Block& block : blocks) {
+        if (block.source != unchanged[index]) {
+          continue;
+        }
+        DayRows day{block.day, index, {}};
+        for (uint64_t row = block.rowStart; row < block.rowStart + block.rowCount; row++) {
+          uint32_t& name = renamed[nameIds[row]];
+          if (name == UINT32_MAX) {
+            name = intern(names[nameIds[row]]);
+          }
+          day.rows.push_back({name, starts[row], lengths[row], actLengths[row], flags[row]});
+        }
+        days.push_back(std::move(day));
+      }
+      continue;
+    }
+
+    std::filesystem::path sourcePath(source.path);
+    if (source.kind == DAY_FILE) {
+      std::ifstream file(sourcePath, std::ios::binary);
+      std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      int64_t day = 0;
+      DateRange::toDayNumber(sourcePath.filename().string().substr(6, 10), day);
+      jobs.push_back({static_cast<int32_t>(day), index, std::move(content), source.path});
+    } else {
+      std::vector<std::pair<std::string, std::string>> contents;
+      if (source.kind == PACK) {
+        std::map<std::string, std::string> packed;
+        PackStore pack(source.path);
+        if (pack.open() && pack.readAll(packed)) {
+          contents.assign(packed.begin(), packed.end());
+        }
+      } else {
+        ArchiveStore archive(source.path);
+        if (archive.open()) {
+          archive.scan("0000-01-01", "9999-12-31", contents);
+        }
+      }
+      for (auto& [date, content] : contents) {
+        int64_t day = 0;
+        DateRange::toDayNumber(date, day);
+        jobs.push_back({static_cast<int32_t>(day), index, std::move(content),
+                        (sourcePath.parent_path() / ("tasks_" + date + extension)).string()});
+      }
+    }
+  }
+
+  // Extract the changed days on the pool, in batches to keep the queue short
+  {
+    ThreadPool pool(std::min(threads, std::max<size_t>(jobs.size(), 1)));
+    constexpr size_t BATCH = 64;
+    std::vector<std::future<std::vector<std::pair<size_t, std::vector<Task>>>>> results;
+    for (size_t first = 0; first < jobs.size(); first += BATCH) {
+      size_t last = std::min(first + BATCH, jobs.size());
+      results.push_back(pool.submit([&jobs, &extract, first, last]() {
+        std::vector<std::pair<size_t, std::vector<Task>>> extracted;
+        for (size_t i = first; i < last; i++) {
+          std::vector<Task> tasks;
+          if (extract(jobs[i].content, jobs[i].filename, tasks)) {
+            extracted.emplace_back(i, std::move(tasks));
+          }
+        }
+        return extracted;
+      }));
+    }
+    for (auto& result : results) {
+      for (auto& [i, tasks] : result.get()) {
+        DayRows day{jobs[i].day, jobs[i].source, {}};
+        for (const Task& task : tasks) {
+          day.rows.push_back({intern(task.name), task.start, task.length, task.actLength,
+                              static_cast<uint8_t>((task.fixed ? FIXED : 0) | (task.rigid ? RIGID : 0))});
+        }
+        days.push_back(std::move(day));
+        daysRead++;
+      }
+    }
+  }
+
+  // The day in effect comes from the first source in lookup order
+  std::sort(days.begin(), days.end(), [&current](const DayRows& a, const DayRows& b) {
+    if (a.day != b.day) {
+      return a.day < b.day;
+    }
+    return current[a.source].kind < current[b.source].kind;
+  });
+  std::vector<bool> inEffect(days.size());
+  for (size_t i = 0; i < days.size(); i++) {
+    inEffect[i] = i == 0 || days[i].day != days[i - 1].day;
+  }
+
+  sources = std::move(current);
+  names = std::move(newNames);
+  checksum = 0;
+  blocks.clear();
+  dates.clear();
+  nameIds.clear();
+  starts.clear();
+  lengths.clear();
+  actLengths.clear();
+  flags.clear();
+  for (bool active : {true, false}) {
+    for (size_t i = 0; i < days.size(); i++) {
+      if (inEffect[i] != active) {
+        continue;
+      }
+      blocks.push_back({days[i].day, days[i].source, dates.size(), static_cast<uint32_t>(days[i].rows.size()), active});
+      for (const Row& row : days[i].rows) {
+        dates.push_back(days[i].day);
+        nameIds.push_back(row.name);
+        starts.push_back(row.start);
+        lengths.push_back(row.length);
+        actLengths.push_back(row.actLength);
+        flags.push_back(row.flags);
+      }
+    }
+    if (active) {
+      activeRows = dates.size();
+    }
+  }
+  return true;
+}
+
+size_t ColumnStore::rowCount() const {
+  return activeRows;
+}
+
+size_t ColumnStore::dayCount() const {
+  return static_cast<size_t>(std::count_if(blocks.begin(), blocks.end(), [](const Block& block) { return block.active; }));
+}
+
+const std::vector<std::string>& ColumnStore::getNames() const {
+  return names;
+}
+
+void ColumnStore::forEachDay(const std::function<void(int32_t, const uint32_t*, size_t)>& visit) const {
+  for (const Block& block : blocks) {
+    if (!block.active) {
+      break;
+    }
+    visit(block.day, nameIds.data() + block.rowStart, block.rowCount);
+  }
+}
+
+bool ColumnStore::taskAt(int64_t day, uint32_t position, Task& task) const {
+  auto activeEnd = std::partition_point(blocks.begin(), blocks.end(), [](const Block& block) { return block.active; });
+  auto block = std::lower_bound(blocks.begin(), activeEnd, day,
+                                [](const Block& block, int64_t value) { return block.day < value; });
+  if (block == activeEnd || block->day != day || position >= block->rowCount) {
+    return false;
+  }
+  size_t row = block->rowStart + position;
+  task = {names[nameIds[row]], starts[row], lengths[row], actLengths[row], (flags[row] & FIXED) != 0,
+          (flags[row] & RIGID) != 0};
+  return true;
+}
+
+ColumnStore::Columns ColumnStore::columns(int64_t firstDay, int64_t lastDay) const {
+  // Active rows are sorted by date: the range is one contiguous run
+  auto begin = dates.begin();
+  auto end = dates.begin() + static_cast<std::ptrdiff_t>(activeRows);
+  size_t first = static_cast<size_t>(std::lower_bound(begin, end, firstDay) - begin);
+  size_t last = static_cast<size_t>(std::upper_bound(begin, end, lastDay) - begin);
+  return {dates.data() + first, nameIds.data() + first, starts.data() + first, lengths.data() + first,
+          actLengths.data() + first, flags.data() + first, last - first, &names};
+}
+
+std::vector<ColumnStore::NameSummary> ColumnStore::summarize(int64_t firstDay, int64_t lastDay,
+                                                             const std::string& name) const {
+  // Active rows are sorted by date: the range is one contiguous run
+  auto begin = dates.begin();
+  auto end = dates.begin() + static_cast<std::ptrdiff_t>(activeRows);
+  size_t first = static_cast<size_t>(std::lower_bound(begin, end, firstDay) - begin);
+  size_t last = static_cast<size_t>(std::upper_bound(begin, end, lastDay) - begin);
+
+  uint32_t only = UINT32_MAX;
+  if (!name.empty()) {
+    auto found = std::find(names.begin(), names.end(), name);
+    if (found == names.end()) {
+      return {};
+    }
+    only = static_cast<uint32_t>(found - names.begin());
+  }
+
+  // One pass for counts, minutes and distinct days (rows come in date order)
+  std::vector<size_t> counts(names.size(), 0);
+  std::vector<size_t> dayCounts(names.size(), 0);
+  std::vector<int64_t> minutes(names.size(), 0);
+  std::vector<int32_t> lastSeen(names.size(), INT32_MIN);
+  const uint32_t* ids = nameIds.data();
+  const int32_t* days = dates.data();
+  const int32_t* act = actLengths.data();
+  for (size_t row = first; row < last; row++) {
+    uint32_t id = ids[row];
+    counts[id]++;
+    minutes[id] += act[row];
+    dayCounts[id] += lastSeen[id] != days[row];
+    lastSeen[id] = days[row];
+  }
+
+  // Then the lengths grouped by name (counting sort) for the distributions
+  std::vector<size_t> offsets(names.size() + 1, 0);
+  for (size_t id = 0; id < names.size(); id++) {
+    offsets[id + 1] = offsets[id] + counts[id];
+  }
+  std::vector<int32_t> grouped(offsets.back());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t row = first; row < last; row++) {
+    grouped[fill[ids[row]]++] = act[row];
+  }
+
+  std::vector<NameSummary> summaries;
+  for (uint32_t id = 0; id < names.size(); id++) {
+    if (counts[id] == 0 || (only != UINT32_MAX && id != only)) {
+      continue;
+    }
+    NameSummary summary;
+    summary.name = names[id];
+    summary.count = counts[id];
+    summary.days = dayCounts[id];
+    summary.minutes = minutes[id];
+
+    auto lengthsBegin = grouped.begin() + static_cast<std::ptrdiff_t>(offsets[id]);
+    auto lengthsEnd = grouped.begin() + static_cast<std::ptrdiff_t>(offsets[id + 1]);
+    auto [shortest, longest] = std::minmax_element(lengthsBegin, lengthsEnd);
+    summary.shortest = *shortest;
+    summary.longest = *longest;
+    auto median = lengthsBegin + static_cast<std::ptrdiff_t>(counts[id] / 2);
+    std::nth_element(lengthsBegin, median, lengthsEnd);
+    summary.median = *median;
+    auto p90 = lengthsBegin + static_cast<std::ptrdiff_t>(counts[id] * 9 / 10);
+    std::nth_element(lengthsBegin, p90, lengthsEnd);
+    summary.p90 = *p90;
+
+    summary.histogram.assign(static_cast<size_t>(std::max(summary.longest, 0) / HISTOGRAM_BUCKET) + 1, 0);
+    for (auto length = lengthsBegin; length != lengthsEnd; ++length) {
+      summary.histogram[static_cast<size_t>(std::max(*length, 0) / HISTOGRAM_BUCKET)]++;
+    }
+    summaries.push_back(std::move(summary));
+  }
+
+  std::sort(summaries.begin(), summaries.end(), [](const NameSummary& a, const NameSummary& b) {
+    return a.minutes != b.minutes ? a.minutes > b.minutes : a.name < b.name;
+  });
+  return summaries;
+}
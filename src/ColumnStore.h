@@ -0,0 +1,133 @@
+#ifndef COLUMNSTORE_H
+#define COLUMNSTORE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Every task of every day on record (day files, monthly packs and the
+// archive) as columns, for `plan stats --by-name/--name`. A row is one task
+// of one day: date, name id, start, length, actLength and flags, each in an
+// array of its own, with the rows of the days in effect first and sorted by
+// date. A date range is then a binary search and the aggregation a straight
+// pass over a few arrays.
+//
+// The store lives in data/.stats.cols. Each refresh compares the sources
+// with the ones the rows were read from (path, size, modification time), so
+// only new or changed files are read again. A day in several sources counts
+// once, from the one loadFromFile would read: its day file, then its
+// month's pack, then the archive.
+class ColumnStore {
+ public:
+  // Bump whenever the file layout or what a row holds changes
+  static constexpr uint32_t VERSION = 1;
+  static constexpr int HISTOGRAM_BUCKET = 15;  // Minutes per histogram bar
+  static constexpr uint8_t FIXED = 1;  // Bits of the flags column
+  static constexpr uint8_t RIGID = 2;
+
+  // One task of a day as the extractor computes it
+  struct Task {
+    std::string name;
+    int start;
+    int length;
+    int actLength;
+    bool fixed;
+    bool rigid;
+  };
+  // A day's tasks after calcActLen/calcStartTimes, from its data file's bytes;
+  // false if they don't load. Called from several threads at once.
+  using DayExtractor =
+      std::function<bool(const std::string& content, const std::string& filename, std::vector<Task>& tasks)>;
+
+  // Read-only view of `count` consecutive rows, for Query
+  struct Columns {
+    const int32_t* dates;
+    const uint32_t* nameIds;
+    const int32_t* starts;
+    const int32_t* lengths;
+    const int32_t* actLengths;
+    const uint8_t* flags;
+    size_t count;
+    const std::vector<std::string>* names;  // Indexed by nameIds
+  };
+
+  struct NameSummary {
+    std::string name;
+    size_t count = 0;  // Rows
+    size_t days = 0;   // Distinct days
+    int64_t minutes = 0;
+    int shortest = 0;
+    int median = 0;
+    int p90 = 0;
+    int longest = 0;
+    std::vector<size_t> histogram;  // actLength in HISTOGRAM_BUCKET buckets
+  };
+
+  // data-dir/.stats.cols
+  static std::string storePath(const std::string& dataDir);
+
+  explicit ColumnStore(const std::string& path);
+
+  bool load();  // False if missing or damaged; the store is then empty
+  bool save();
+  // Checksum of the rows as last loaded or saved; 0 after a refresh until
+  // saved. Stores derived from the rows (SearchIndex) are stamped with it.
+  uint64_t generation() const;
+
+  // Re-read the sources in dataDir that changed since the rows were taken,
+  // on `threads` workers (0: one per hardware thread). True if the rows
+  // changed and want saving; daysRead counts the days extracted.
+  bool refresh(const std::string& dataDir, const std::string& extension, const std::string& archivePath,
+               const DayExtractor& extract, size_t threads, size_t& daysRead);
+
+  size_t rowCount() const;  // Rows of the days in effect
+  size_t dayCount() const;
+  const std::vector<std::string>& getNames() const;
+
+  // Each day in effect, oldest first, with the name ids of its tasks in order
+  void forEachDay(const std::function<void(int32_t day, const uint32_t* nameIds, size_t count)>& visit) const;
+  // Task `position` of a day in effect
+  bool taskAt(int64_t day, uint32_t position, Task& task) const;
+  // The rows of the days in effect within firstDay..lastDay, in date order
+  Columns columns(int64_t firstDay, int64_t lastDay) const;
+
+  // Per name over firstDay..lastDay (days since 1970-01-01), most minutes
+  // first; a non-empty name keeps only that one (matched exactly)
+  std::vector<NameSummary> summarize(int64_t firstDay, int64_t lastDay, const std::string& name = "") const;
+
+ private:
+  enum SourceKind : uint32_t { DAY_FILE = 0, PACK = 1, ARCHIVE = 2 };  // Lookup order
+  struct Source {
+    uint32_t kind;
+    std::string path;
+    uint64_t size;
+    int64_t modified;
+  };
+  struct Block {  // One day of one source
+    int32_t day;
+    uint32_t source;
+    uint64_t rowStart;
+    uint32_t rowCount;
+    bool active;  // The day counts from this source
+  };
+
+  std::string path;
+  std::vector<std::string> names;
+  std::vector<Source> sources;
+  std::vector<Block> blocks;  // Those in effect first, in date order
+  size_t activeRows;
+  uint64_t checksum;
+
+  // Columns, active rows first in date order, then the shadowed ones
+  std::vector<int32_t> dates;
+  std::vector<uint32_t> nameIds;
+  std::vector<int32_t> starts;
+  std::vector<int32_t> lengths;
+  std::vector<int32_t> actLengths;
+  std::vector<uint8_t> flags;
+
+  void clear();
+};
+
+#endif  // COLUMNSTORE_H
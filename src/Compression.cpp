@@ -0,0 +1,172 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t LAST_LITERALS = 5;  // The block always ends in literals...
+constexpr size_t MATCH_MARGIN = 12;  // ...and no match starts this close to the end
+constexpr int HASH_BITS = 14;
+
+uint32_t hashAt(const char* position) {
+  uint32_t value;
+  std::memcpy(&value, position, sizeof(value));
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths past a token nibble's 15 continue in bytes of 255 plus a remainder
+void writeLength(std::string& out, size_t length) {
+  while (length >= 255) {
+    out.push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  out.push_back(static_cast<char>(length));
+}
+
+bool readLength(std::string_view block, size_t& position, size_t& length) {
+  uint8_t byte = 0;
+  do {
+    if (position >= block.size()) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(block[position++]);
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+void writeSequence(std::string& out, const char* literals, size_t literalLength, size_t offset,
+                   size_t matchLength) {
+  size_t matchCode = matchLength - MIN_MATCH;
+  out.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+  if (literalLength >= 15) {
+    writeLength(out, literalLength - 15);
+  }
+  out.append(literals, literalLength);
+  out.push_back(static_cast<char>(offset & 0xff));
+  out.push_back(static_cast<char>(offset >> 8));
+  if (matchCode >= 15) {
+    writeLength(out, matchCode - 15);
+  }
+}
+
+void writeLastLiterals(std::string& out, const char* literals, size_t literalLength) {
+  out.push_back(static_cast<char>(std::min<size_t>(literalLength, 15) << 4));
+  if (literalLength >= 15) {
+    writeLength(out, literalLength - 15);
+  }
+  out.append(literals, literalLength);
+}
+
+}  // namespace
+
+std::string lzCompress(std::string_view input, std::string_view dictionary) {
+  if (dictionary.size() > MAX_OFFSET) {
+    dictionary = dictionary.substr(dictionary.size() - MAX_OFFSET);
+  }
+
+  // Matches are found in dictionary + input; only the input part is encoded
+  std::string window;
+  window.reserve(dictionary.size() + input.size());
+  window.append(dictionary);
+  window.append(input);
+  const char* base = window.data();
+  size_t start = dictionary.size();
+  size_t end = window.size();
+
+  std::vector<int64_t> table(size_t(1) << HASH_BITS, -1);
+  for (size_t position = 0; position < start && position + MIN_MATCH <= end; position++) {
+    table[hashAt(base + position)] = static_cast<int64_t>(position);
+  }
+
+  std::string out;
+  out.reserve(input.size() / 2 + 16);
+  size_t anchor = start;
+  size_t position = start;
+  size_t matchStartLimit = end > MATCH_MARGIN ? end - MATCH_MARGIN : 0;
+  while (position < matchStartLimit) {
+    uint32_t hash = hashAt(base + position);
+    int64_t candidate = table[hash];
+    table[hash] = static_cast<int64_t>(position);
+    if (candidate < 0 || position - static_cast<size_t>(candidate) > MAX_OFFSET ||
+        std::memcmp(base + candidate, base + position, MIN_MATCH) != 0) {
+      position++;
+      continue;
+    }
+
+    size_t length = MIN_MATCH;
+    while (position + length < end - LAST_LITERALS && base[candidate + length] == base[position + length]) {
+      length++;
+    }
+    writeSequence(out, base + anchor, position - anchor, position - static_cast<size_t>(candidate), length);
+
+    // Remember the positions inside the match too; repeated records align better
+    for (size_t inside = position + 1; inside < position + length && inside + MIN_MATCH <= end; inside++) {
+      table[hashAt(base + inside)] = static_cast<int64_t>(inside);
+    }
+    position += length;
+    anchor = position;
+  }
+  writeLastLiterals(out, base + anchor, end - anchor);
+  return out;
+}
+
+bool lzDecompress(std::string_view block, size_t originalSize, std::string& output, std::string_view dictionary) {
+  if (dictionary.size() > MAX_OFFSET) {
+    dictionary = dictionary.substr(dictionary.size() - MAX_OFFSET);
+  }
+
+  std::string window;
+  window.reserve(dictionary.size() + originalSize);
+  window.append(dictionary);
+  size_t limit = dictionary.size() + originalSize;
+
+  size_t position = 0;
+  while (position < block.size()) {
+    uint8_t token = static_cast<uint8_t>(block[position++]);
+
+    size_t literalLength = token >> 4;
+    if (literalLength == 15 && !readLength(block, position, literalLength)) {
+      return false;
+    }
+    if (literalLength > block.size() - position || literalLength > limit - window.size()) {
+      return false;
+    }
+    window.append(block.data() + position, literalLength);
+    position += literalLength;
+    if (position == block.size()) {
+      break;  // The last sequence has no match
+    }
+
+    if (block.size() - position < 2) {
+      return false;
+    }
+    size_t offset = static_cast<uint8_t>(block[position]) | (static_cast<size_t>(static_cast<uint8_t>(block[position + 1])) << 8);
+    position += 2;
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !readLength(block, position, matchLength)) {
+      return false;
+    }
+    matchLength += MIN_MATCH;
+    if (offset == 0 || offset > window.size() || matchLength > limit - window.size()) {
+      return false;
+    }
+
+    // Byte by byte: a match may overlap the bytes it produces
+    size_t from = window.size() - offset;
+    for (size_t i = 0; i < matchLength; i++) {
+      window.push_back(window[from + i]);
+    }
+  }
+
+  if (window.size() != limit) {
+    return false;
+  }
+  output.assign(window, dictionary.size(), std::string::npos);
+  return true;
+}
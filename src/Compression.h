@@ -0,0 +1,21 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <string_view>
+
+// LZ4-style block codec: byte-aligned sequences of literals and back-references
+// into a 64KB window, with a greedy single-probe hash matcher. It trades ratio
+// for speed and needs no external library. Pretty-printed task JSON repeats a
+// lot of structure, most of all against a dictionary of similar days.
+//
+// A block may be compressed against a dictionary: its back-references can then
+// reach into the dictionary, so the same dictionary must be supplied to
+// decompress it. Only the last 64KB of a dictionary are used.
+std::string lzCompress(std::string_view input, std::string_view dictionary = {});
+
+// False if the block is malformed or doesn't expand to exactly originalSize bytes
+bool lzDecompress(std::string_view block, size_t originalSize, std::string& output,
+                  std::string_view dictionary = {});
+
+#endif  // COMPRESSION_H
@@ -21,21 +21,40 @@ void Config::setDefaults() {
     settings["show-warnings"] = "true";
     settings["default-start-time"] = "09:00";
     settings["time-format"] = "24h";  // 24h or 12h
+    settings["day-cache-size"] = "7";  // Days kept loaded for [ and ] in the TUI
 
     // File settings
     settings["file-extension"] = ".json";
     settings["backup-enabled"] = "false";
     settings["max-backup-files"] = "5";
+    settings["range-threads"] = "0";  // Threads loading days for date ranges, 0 = one per core
+    settings["archive-file"] = "archive.plan";  // In data-dir, written by `plan archive`
 
     // Display settings
     settings["table-width"] = "full";  // full or auto
     settings["status-messages"] = "true";
 
+    // Undo history limits
+    settings["undo-max-entries"] = "100";
+    settings["undo-max-bytes"] = "1048576";  // 1MB
+    settings["undo-persist"] = "true";       // Keep history in a sidecar across sessions
+    settings["undo-cache-bytes"] = "4194304";  // 4MB of other files' histories kept in memory
+    settings["undo-merge-ms"] = "1000";      // Same-field edits this close together undo as one
+    settings["undo-checkpoint-interval"] = "16";  // Full task snapshot every N undo tree levels
+
+    // Hooks (shell commands run at task boundaries, empty = disabled)
+    settings["hook-task-start"] = "";
+    settings["hook-task-end"] = "";
+
     // Session state (not saved to config file, managed separately)
     settings["last-opened-file"] = "";
 }
 
 bool Config::loadFromFile() {
+    return loadFromFile(std::vector<std::string>());
+}
+
+bool Config::loadFromFile(const std::vector<std::string>& onlyKeys) {
     std::ifstream file(configFilePath);
     if (!file.is_open()) {
         std::cout << "Config file not found: " << configFilePath << ". Using defaults." << std::endl;
@@ -44,6 +63,7 @@ bool Config::loadFromFile() {
 
     std::string line;
     int lineNumber = 0;
+    size_t keysFound = 0;
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -70,8 +90,16 @@ bool Config::loadFromFile() {
         value.erase(0, value.find_first_not_of(" \t"));
         value.erase(value.find_last_not_of(" \t") + 1);
 
-        if (!key.empty()) {
+        if (key.empty()) {
+            continue;
+        }
+        if (onlyKeys.empty()) {
+            settings[key] = value;
+        } else if (std::find(onlyKeys.begin(), onlyKeys.end(), key) != onlyKeys.end()) {
             settings[key] = value;
+            if (++keysFound == onlyKeys.size()) {
+                break;
+            }
         }
     }
 
@@ -99,16 +127,31 @@ bool Config::saveToFile() const {
     file << "auto-save: " << settings.at("auto-save") << "\n";
     file << "show-warnings: " << settings.at("show-warnings") << "\n";
     file << "default-start-time: " << settings.at("default-start-time") << "\n";
-    file << "time-format: " << settings.at("time-format") << "\n\n";
+    file << "time-format: " << settings.at("time-format") << "\n";
+    file << "day-cache-size: " << settings.at("day-cache-size") << "\n\n";
 
     file << "# File Settings\n";
     file << "file-extension: " << settings.at("file-extension") << "\n";
     file << "backup-enabled: " << settings.at("backup-enabled") << "\n";
-    file << "max-backup-files: " << settings.at("max-backup-files") << "\n\n";
+    file << "max-backup-files: " << settings.at("max-backup-files") << "\n";
+    file << "range-threads: " << settings.at("range-threads") << "\n";
+    file << "archive-file: " << settings.at("archive-file") << "\n\n";
 
     file << "# Display Settings\n";
     file << "table-width: " << settings.at("table-width") << "\n";
-    file << "status-messages: " << settings.at("status-messages") << "\n";
+    file << "status-messages: " << settings.at("status-messages") << "\n\n";
+
+    file << "# Undo History\n";
+    file << "undo-max-entries: " << settings.at("undo-max-entries") << "\n";
+    file << "undo-max-bytes: " << settings.at("undo-max-bytes") << "\n";
+    file << "undo-persist: " << settings.at("undo-persist") << "\n";
+    file << "undo-cache-bytes: " << settings.at("undo-cache-bytes") << "\n";
+    file << "undo-merge-ms: " << settings.at("undo-merge-ms") << "\n";
+    file << "undo-checkpoint-interval: " << settings.at("undo-checkpoint-interval") << "\n\n";
+
+    file << "# Hooks\n";
+    file << "hook-task-start: " << settings.at("hook-task-start") << "\n";
+    file << "hook-task-end: " << settings.at("hook-task-end") << "\n";
 
     file.close();
     return true;
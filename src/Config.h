@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 class Config {
 private:
@@ -18,6 +19,10 @@ public:
     // Load configuration from file
     bool loadFromFile();
 
+    // Load only the given keys, stopping as soon as all of them were seen
+    // (used by the CLI fast path, which needs little more than data-dir)
+    bool loadFromFile(const std::vector<std::string>& onlyKeys);
+
     // Save configuration to file
     bool saveToFile() const;
 
@@ -0,0 +1,14 @@
+#include "ContentHash.h"
+
+uint64_t hashContent(const std::string& data) {
+  return hashContent(data.data(), data.size());
+}
+
+uint64_t hashContent(const char* data, size_t size, uint64_t seed) {
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
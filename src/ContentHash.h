@@ -0,0 +1,11 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a over raw bytes; used to key caches and sidecars to file contents
+uint64_t hashContent(const std::string& data);
+uint64_t hashContent(const char* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+#endif  // CONTENTHASH_H
@@ -0,0 +1,102 @@
+#include "ContentStore.h"
+#include "ContentHash.h"
+#include "DateRange.h"
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+bool ContentStore::put(uint64_t key, const std::string& bytes) {
+  auto [existing, added] = objects.try_emplace(key, bytes);
+  if (added) {
+    this->bytes += bytes.size();
+    return true;
+  }
+  return existing->second == bytes;
+}
+
+bool ContentStore::contains(uint64_t key) const {
+  return objects.count(key) > 0;
+}
+
+const std::string* ContentStore::get(uint64_t key) const {
+  auto found = objects.find(key);
+  return found == objects.end() ? nullptr : &found->second;
+}
+
+size_t ContentStore::objectCount() const {
+  return objects.size();
+}
+
+size_t ContentStore::byteCount() const {
+  return bytes;
+}
+
+bool ContentStore::splitDay(const std::string& content, DayObjects& day) {
+  json document = json::parse(content, nullptr, false);
+  if (document.is_discarded() || !document.is_object() || !document.contains("dayLength") ||
+      !document.contains("tasks") || !document["tasks"].is_array()) {
+    return false;
+  }
+
+  day = DayObjects();
+  int64_t savedDay = 0;
+  auto date = document.find("date");
+  if (date != document.end() && date->is_string() && DateRange::toDayNumber(date->get<std::string>(), savedDay)) {
+    day.savedDate = date->get<std::string>();
+    document.erase(date);
+  }
+
+  // Compact dumps are canonical: nlohmann keeps object keys sorted
+  json keys = json::array();
+  for (json& task : document["tasks"]) {
+    if (task.is_object()) {
+      task.erase("id");
+    }
+    std::string record = task.dump();
+    uint64_t key = hashContent(record);
+    keys.push_back(key);
+    day.taskKeys.push_back(key);
+    day.tasks.push_back(std::move(record));
+  }
+  document["tasks"] = std::move(keys);
+  day.ordering = document.dump();
+  day.orderingKey = hashContent(day.ordering);
+  return true;
+}
+
+bool ContentStore::joinDay(const DayObjects& day, std::string& content) {
+  json document = json::parse(day.ordering, nullptr, false);
+  if (document.is_discarded() || !document.is_object() || !document.contains("tasks") ||
+      !document["tasks"].is_array() || document["tasks"].size() != day.tasks.size()) {
+    return false;
+  }
+
+  json tasks = json::array();
+  for (size_t i = 0; i < day.tasks.size(); i++) {
+    const json& key = document["tasks"][i];
+    if (!key.is_number_unsigned() || key.get<uint64_t>() != hashContent(day.tasks[i])) {
+      return false;
+    }
+    json task = json::parse(day.tasks[i], nullptr, false);
+    if (task.is_discarded()) {
+      return false;
+    }
+    tasks.push_back(std::move(task));
+  }
+  document["tasks"] = std::move(tasks);
+  if (!day.savedDate.empty()) {
+    document["date"] = day.savedDate;
+  }
+  content = document.dump(2);
+  return true;
+}
+
+bool ContentStore::dayKey(const std::string& content, uint64_t& key) {
+  DayObjects day;
+  if (!splitDay(content, day)) {
+    return false;
+  }
+  key = day.orderingKey;
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef CONTENTSTORE_H
+#define CONTENTSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A day's data file taken apart into content-addressed objects: one per task
+// record, plus the day's ordering (dayLength, any other settings, and the
+// task records' keys in order). An object's key is the hash of its bytes
+// (hashContent), so a routine that repeats across days is stored once and
+// each repetition costs a reference, and two days hold the same tasks in the
+// same order exactly when their ordering keys are equal.
+//
+// The file's save date is kept out of the ordering and task ids out of the
+// records: both differ between days that are otherwise copies of each other.
+// A day read back gets fresh task ids when it is loaded, as a file saved
+// before tasks had ids does.
+struct DayObjects {
+  std::string ordering;
+  uint64_t orderingKey = 0;
+  std::vector<std::string> tasks;
+  std::vector<uint64_t> taskKeys;
+  std::string savedDate;  // YYYY-MM-DD, or empty if the file has none
+};
+
+// Objects by key, each stored once. Keys are plain content hashes, so a
+// different object under a key already taken is refused rather than
+// renamed; callers treat it like any other write failure.
+class ContentStore {
+ public:
+  // False only for a hash collision with a different object
+  bool put(uint64_t key, const std::string& bytes);
+  bool contains(uint64_t key) const;
+  const std::string* get(uint64_t key) const;
+
+  size_t objectCount() const;
+  size_t byteCount() const;  // Of the distinct objects
+
+  // False if content is not a data file (the same checks loadFromContent makes)
+  static bool splitDay(const std::string& content, DayObjects& day);
+  // The data file again, as saveToFile formats it but without task ids.
+  // Every task key of the ordering must have a matching entry in day.tasks.
+  static bool joinDay(const DayObjects& day, std::string& content);
+
+  // Key of a day's tasks, ignoring its save date and formatting; false if
+  // content is not a data file
+  static bool dayKey(const std::string& content, uint64_t& key);
+
+ private:
+  std::unordered_map<uint64_t, std::string> objects;
+  size_t bytes = 0;
+};
+
+#endif  // CONTENTSTORE_H
@@ -0,0 +1,342 @@
+#include "Daemon.h"
+#include "Config.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool fillSocketAddress(const std::string& path, sockaddr_un& addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+bool writeAll(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Milliseconds until local midnight, when "today" moves to the next file
+int millisecondsUntilMidnight() {
+  auto now = std::time(nullptr);
+  auto tm = *std::localtime(&now);
+  int secondsToday = tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+  return (24 * 3600 - secondsToday) * 1000 + 500;
+}
+
+}  // namespace
+
+std::string getDaemonSocketPath(const std::string& configPath) {
+  const char* socketOverride = std::getenv("PLAN_SOCKET");
+  if (socketOverride && std::strlen(socketOverride) > 0) {
+    return socketOverride;
+  }
+
+  std::ostringstream name;
+  name << "plan-" << std::hex << (std::hash<std::string>{}(configPath) & 0xffffffffu) << ".sock";
+
+  const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+  if (runtimeDir && std::strlen(runtimeDir) > 0) {
+    return std::string(runtimeDir) + "/" + name.str();
+  }
+  return "/tmp/" + std::to_string(getuid()) + "-" + name.str();
+}
+
+bool queryDaemon(const std::string& socketPath, const std::string& request, std::string& response) {
+  sockaddr_un addr;
+  if (!fillSocketAddress(socketPath, addr)) {
+    return false;
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      !writeAll(fd, request + "\n")) {
+    ::close(fd);
+    return false;
+  }
+  ::shutdown(fd, SHUT_WR);
+
+  response.clear();
+  char buffer[4096];
+  while (true) {
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    response.append(buffer, static_cast<size_t>(n));
+  }
+  ::close(fd);
+
+  // An empty reply means the daemon went away mid-request
+  return !response.empty();
+}
+
+bool isDaemonRunning(const std::string& socketPath) {
+  std::string response;
+  return queryDaemon(socketPath, "ping", response);
+}
+
+ScheduleDaemon::ScheduleDaemon(Config* cfg, const std::string& cfgPath, const std::string& sockPath,
+                               FilenameResolver resolver, ScheduleLoader loader)
+    : config(cfg),
+      configPath(cfgPath),
+      socketPath(sockPath),
+      resolveFilename(std::move(resolver)),
+      loadSchedule(std::move(loader)),
+      listenFd(-1),
+      notifier(*cfg) {}
+
+ScheduleDaemon::~ScheduleDaemon() {
+  if (listenFd >= 0) {
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+  }
+}
+
+bool ScheduleDaemon::start() {
+  sockaddr_un addr;
+  if (!fillSocketAddress(socketPath, addr)) {
+    std::cerr << "Error: Socket path too long: " << socketPath << std::endl;
+    return false;
+  }
+
+  // Refuse to steal the socket from a live daemon, but clean up stale ones
+  if (isDaemonRunning(socketPath)) {
+    std::cerr << "Error: A plan daemon is already listening on " << socketPath << std::endl;
+    return false;
+  }
+  ::unlink(socketPath.c_str());
+
+  listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0 ||
+      ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listenFd, 16) != 0) {
+    std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  if (!files.open()) {
+    std::cerr << "Warning: inotify unavailable, schedules will be reloaded on every request" << std::endl;
+  }
+
+  files.watch(directoryOf(configPath));
+  std::string dataDir = config->getString("data-dir", "data");
+  try {
+    std::filesystem::create_directories(dataDir);
+  } catch (const std::exception& e) {
+    std::cerr << "Warning: Could not create data directory " << dataDir << ": " << e.what() << std::endl;
+  }
+  files.watch(absolutePath(dataDir));
+
+  if (notifier.hasHooks()) {
+    notifier.start();
+  }
+  publisher.open(getScheduleShmName(configPath));
+  loadToday();
+
+  return true;
+}
+
+void ScheduleDaemon::handleFileEvents() {
+  bool configChanged = false;
+  std::string configName = std::filesystem::path(configPath).filename().string();
+  std::vector<std::string> dropped;
+
+  files.drain([&](const std::string& dir, const std::string& name) {
+    if (name == configName && dir == directoryOf(configPath)) {
+      configChanged = true;
+      return;
+    }
+
+    // Drop every cached day backed by this file
+    for (auto it = cache.begin(); it != cache.end();) {
+      std::filesystem::path cached(it->first);
+      if (cached.filename() == name && directoryOf(it->first) == dir) {
+        dropped.push_back(it->first);
+        it = cache.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  });
+
+  if (configChanged) {
+    reloadConfig();
+  } else if (notifier.hasHooks()) {
+    // Reload changed days right away so their hooks follow the edit
+    for (const auto& filename : dropped) {
+      getSchedule(filename);
+    }
+  }
+  loadToday();
+}
+
+void ScheduleDaemon::reloadConfig() {
+  reloadConfigFile(*config, configPath);
+  cache.clear();
+  notifier.setHooks(config->getString("hook-task-start", ""), config->getString("hook-task-end", ""));
+  if (notifier.hasHooks()) {
+    notifier.start();
+  }
+  files.watch(absolutePath(config->getString("data-dir", "data")));
+}
+
+void ScheduleDaemon::loadToday() {
+  std::string filename = absolutePath(resolveFilename(""));
+  const Schedule& schedule = getSchedule(filename);
+  if (publisher.isOpen()) {
+    publisher.publish(schedule, filename);
+  }
+}
+
+const Schedule& ScheduleDaemon::getSchedule(const std::string& filename) {
+  auto it = cache.find(filename);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  Schedule schedule = loadSchedule(filename);
+  // A missing file is shown with demo tasks, which should not run hooks
+  if (std::filesystem::exists(filename)) {
+    notifier.setSchedule(filename, schedule);
+  } else {
+    notifier.removeSchedule(filename);
+  }
+
+  // Only keep days we are told about when they change
+  if (files.watch(directoryOf(filename))) {
+    return cache[filename] = std::move(schedule);
+  }
+  uncachedSchedule = std::move(schedule);
+  return uncachedSchedule;
+}
+
+std::string ScheduleDaemon::answer(const std::string& request) {
+  std::string command = request;
+  std::string argument;
+  size_t space = request.find(' ');
+  if (space != std::string::npos) {
+    command = request.substr(0, space);
+    argument = request.substr(space + 1);
+  }
+
+  if (command == "ping") {
+    return "pong\n";
+  }
+  if (command != "now" && command != "next" && command != "list") {
+    return "Unknown command: " + command + "\n";
+  }
+
+  const Schedule& schedule = getSchedule(absolutePath(resolveFilename(argument)));
+  if (command == "now") {
+    return schedule.describeCurrent(getCurrentTimeInMinutes()) + "\n";
+  } else if (command == "next") {
+    return schedule.describeNext(getCurrentTimeInMinutes()) + "\n";
+  }
+  return schedule.describeList();
+}
+
+void ScheduleDaemon::handleClient(int clientFd) {
+  // Local clients send a single short line; don't let a stuck one stall the loop
+  timeval timeout{1, 0};
+  ::setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buffer[256];
+  while (request.find('\n') == std::string::npos && request.size() < 4096) {
+    ssize_t n = ::read(clientFd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    request.append(buffer, static_cast<size_t>(n));
+  }
+
+  size_t newline = request.find('\n');
+  if (newline != std::string::npos) {
+    request.erase(newline);
+  }
+  if (!request.empty() && request.back() == '\r') {
+    request.pop_back();
+  }
+
+  try {
+    writeAll(clientFd, answer(request));
+  } catch (const std::exception& e) {
+    writeAll(clientFd, std::string("Error: ") + e.what() + "\n");
+  }
+}
+
+int ScheduleDaemon::run() {
+  installStopHandler();
+  std::signal(SIGPIPE, SIG_IGN);
+
+  std::cout << "plan daemon listening on " << socketPath << std::endl;
+
+  while (!stopRequested()) {
+    pollfd fds[2];
+    nfds_t count = 0;
+    fds[count++] = {listenFd, POLLIN, 0};
+    if (files.getFd() >= 0) {
+      fds[count++] = {files.getFd(), POLLIN, 0};
+    }
+
+    int ready = ::poll(fds, count, millisecondsUntilMidnight());
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+      return 1;
+    }
+    if (ready == 0) {
+      loadToday();  // A new day started
+      continue;
+    }
+
+    if (count > 1 && (fds[1].revents & POLLIN)) {
+      handleFileEvents();
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int clientFd = ::accept(listenFd, nullptr, nullptr);
+      if (clientFd >= 0) {
+        // Drain file events queued since poll() so a write that finished
+        // before the client connected is always reflected in the reply
+        if (files.getFd() >= 0) {
+          handleFileEvents();
+        } else {
+          cache.clear();
+        }
+        handleClient(clientFd);
+        ::close(clientFd);
+      }
+    }
+  }
+
+  std::cout << "plan daemon stopped" << std::endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include "Schedule.h"
+#include "ScheduleShm.h"
+#include "Notifier.h"
+#include "Service.h"
+
+class Config;
+
+// Socket path for the daemon serving a given config file. $PLAN_SOCKET wins,
+// otherwise the socket lives in $XDG_RUNTIME_DIR (or /tmp) and its name is
+// derived from the config path, so daemons for different configs never mix.
+std::string getDaemonSocketPath(const std::string& configPath);
+
+// Thin client: send one request line ("now", "list 2024-01-15", ...) and read
+// the whole reply. Returns false when no daemon is listening.
+bool queryDaemon(const std::string& socketPath, const std::string& request, std::string& response);
+
+// True if a daemon answers on socketPath
+bool isDaemonRunning(const std::string& socketPath);
+
+// Long-running server that keeps computed schedules in memory and answers
+// now/next/list over a Unix domain socket. Clients name the day by absolute
+// path, since the daemon's working directory need not be theirs. Cached days
+// are dropped as soon as their file (or the config file) changes on disk, and
+// today's schedule is mirrored into shared memory for readers that cannot
+// afford a round trip. Upcoming boundaries of every loaded day drive the
+// configured task hooks.
+class ScheduleDaemon {
+ public:
+  using FilenameResolver = std::function<std::string(const std::string&)>;
+  using ScheduleLoader = std::function<Schedule(const std::string&)>;
+
+ private:
+  Config* config;
+  std::string configPath;
+  std::string socketPath;
+  FilenameResolver resolveFilename;
+  ScheduleLoader loadSchedule;
+  int listenFd;
+  DirectoryWatcher files;
+  std::map<std::string, Schedule> cache;   // absolute filename -> computed schedule
+  Schedule uncachedSchedule;               // Last reply for a day we could not watch
+  SchedulePublisher publisher;
+  BoundaryNotifier notifier;  // Hooks for every day the daemon has loaded
+
+  void handleFileEvents();
+  void handleClient(int clientFd);
+  void reloadConfig();
+  void loadToday();  // Registers today's hooks and publishes it, shared memory or not
+  const Schedule& getSchedule(const std::string& filename);
+  std::string answer(const std::string& request);
+
+ public:
+  ScheduleDaemon(Config* cfg, const std::string& cfgPath, const std::string& sockPath,
+                 FilenameResolver resolver, ScheduleLoader loader);
+  ~ScheduleDaemon();
+
+  bool start();  // Bind the socket and set up file watches
+  int run();     // Serve until SIGINT/SIGTERM, returns the process exit code
+};
+
+#endif  // DAEMON_H
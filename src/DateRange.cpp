@@ -0,0 +1,102 @@
+#include "DateRange.h"
+
+#include <cstdio>
+
+namespace {
+
+// Howard Hinnant's days_from_civil / civil_from_days
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+  unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+  days += 719468;
+  int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+  unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+  day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+  month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+}  // namespace
+
+bool DateRange::looksLikeRange(const std::string& arg) {
+  return arg.find("..") != std::string::npos;
+}
+
+bool DateRange::parse(const std::string& arg, DateRange& range) {
+  size_t separator = arg.find("..");
+  if (separator == std::string::npos) {
+    return false;
+  }
+
+  int64_t first = 0, last = 0;
+  if (!toDayNumber(arg.substr(0, separator), first) || !toDayNumber(arg.substr(separator + 2), last) ||
+      first > last) {
+    return false;
+  }
+  range.firstDay = first;
+  range.lastDay = last;
+  return true;
+}
+
+bool DateRange::toDayNumber(const std::string& date, int64_t& day) {
+  if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+    return false;
+  }
+  for (size_t i = 0; i < date.size(); i++) {
+    if (i != 4 && i != 7 && (date[i] < '0' || date[i] > '9')) {
+      return false;
+    }
+  }
+
+  int64_t year = std::stoi(date.substr(0, 4));
+  unsigned month = static_cast<unsigned>(std::stoi(date.substr(5, 2)));
+  unsigned dayOfMonth = static_cast<unsigned>(std::stoi(date.substr(8, 2)));
+  if (month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > 31) {
+    return false;
+  }
+
+  // 2024-02-30 comes back as March 1st
+  day = daysFromCivil(year, month, dayOfMonth);
+  return fromDayNumber(day) == date;
+}
+
+std::string DateRange::fromDayNumber(int64_t day) {
+  int64_t year = 0;
+  unsigned month = 0, dayOfMonth = 0;
+  civilFromDays(day, year, month, dayOfMonth);
+
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(year), month, dayOfMonth);
+  return buffer;
+}
+
+int64_t DateRange::first() const {
+  return firstDay;
+}
+
+int64_t DateRange::last() const {
+  return lastDay;
+}
+
+size_t DateRange::size() const {
+  return static_cast<size_t>(lastDay - firstDay + 1);
+}
+
+std::vector<std::string> DateRange::days() const {
+  std::vector<std::string> result;
+  result.reserve(size());
+  for (int64_t day = firstDay; day <= lastDay; day++) {
+    result.push_back(fromDayNumber(day));
+  }
+  return result;
+}
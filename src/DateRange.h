@@ -0,0 +1,33 @@
+#ifndef DATERANGE_H
+#define DATERANGE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Inclusive span of days given on the command line as FIRST..LAST
+// (2024-01-01..2024-03-31). Days are counted on the Gregorian calendar
+// rather than through mktime, so the local time zone and DST never shift
+// them.
+class DateRange {
+ private:
+  int64_t firstDay;  // Days since 1970-01-01
+  int64_t lastDay;
+
+ public:
+  // Anything with ".." in it is meant as a range, valid or not
+  static bool looksLikeRange(const std::string& arg);
+  // False unless both ends are real dates and FIRST <= LAST
+  static bool parse(const std::string& arg, DateRange& range);
+
+  // Days since 1970-01-01 for a YYYY-MM-DD date; false if it is not one
+  static bool toDayNumber(const std::string& date, int64_t& day);
+  static std::string fromDayNumber(int64_t day);
+
+  int64_t first() const;  // As day numbers
+  int64_t last() const;
+  size_t size() const;
+  std::vector<std::string> days() const;  // YYYY-MM-DD, oldest first
+};
+
+#endif  // DATERANGE_H
@@ -0,0 +1,79 @@
+#include "DayCache.h"
+
+#include <chrono>
+#include <system_error>
+
+DayCache::DayCache(const Config& config, size_t capacity)
+    : config(config), capacity(std::max<size_t>(capacity, 1)), loader(1) {}
+
+DayCache::Loaded DayCache::load(const std::string& filename) {
+  Loaded loaded;
+  std::error_code error;
+  loaded.hadFile = std::filesystem::exists(filename, error);
+  loaded.written = loaded.hadFile ? std::filesystem::last_write_time(filename, error)
+                                  : std::filesystem::file_time_type();
+
+  auto day = std::make_shared<TaskManager>(&config);
+  if (day->loadExisting(filename, true)) {
+    day->calcActLen();
+    day->calcStartTimes();
+    loaded.day = std::move(day);
+  }
+  return loaded;
+}
+
+bool DayCache::isCurrent(const std::string& filename, const Loaded& loaded) const {
+  std::error_code error;
+  bool hasFile = std::filesystem::exists(filename, error);
+  return hasFile == loaded.hadFile &&
+         (!hasFile || std::filesystem::last_write_time(filename, error) == loaded.written);
+}
+
+void DayCache::insert(const std::string& filename, std::shared_future<Loaded> loaded) {
+  recent.push_front(filename);
+  entries[filename] = {std::move(loaded), recent.begin()};
+
+  // A load still in flight when evicted finishes on its own and is dropped
+  while (entries.size() > capacity) {
+    entries.erase(recent.back());
+    recent.pop_back();
+  }
+}
+
+void DayCache::prefetch(const std::string& filename) {
+  auto entry = entries.find(filename);
+  if (entry != entries.end()) {
+    // Queued or loaded; only a load that finished before the file changed is redone
+    const auto& loaded = entry->second.loaded;
+    if (loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+        isCurrent(filename, loaded.get())) {
+      return;
+    }
+    recent.erase(entry->second.recent);
+    entries.erase(entry);
+  }
+  insert(filename, loader.submit([this, filename]() { return load(filename); }).share());
+}
+
+std::shared_ptr<TaskManager> DayCache::get(const std::string& filename) {
+  auto entry = entries.find(filename);
+  if (entry != entries.end()) {
+    Loaded loaded = entry->second.loaded.get();
+    if (isCurrent(filename, loaded)) {
+      recent.splice(recent.begin(), recent, entry->second.recent);
+      return loaded.day;
+    }
+    recent.erase(entry->second.recent);
+    entries.erase(entry);
+  }
+
+  std::promise<Loaded> now;
+  now.set_value(load(filename));
+  std::shared_future<Loaded> loaded = now.get_future().share();
+  insert(filename, loaded);
+  return loaded.get().day;
+}
+
+size_t DayCache::size() const {
+  return entries.size();
+}
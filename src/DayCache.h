@@ -0,0 +1,59 @@
+#ifndef DAYCACHE_H
+#define DAYCACHE_H
+
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Config.h"
+#include "TaskManager.h"
+#include "ThreadPool.h"
+
+// Days for the TUI's [ and ], loaded ahead of time. The neighbours of the
+// open day are loaded on a background thread, each into a TaskManager of
+// its own, so flipping to one takes over its tasks instead of reading and
+// parsing the file then. The `day-cache-size` most recently used days are
+// kept. A day whose file changed since it was loaded (saved when it was
+// left, say) is loaded again.
+class DayCache {
+ public:
+  DayCache(const Config& config, size_t capacity);
+
+  DayCache(const DayCache&) = delete;
+  DayCache& operator=(const DayCache&) = delete;
+
+  // Start loading the day behind filename unless it is cached or on its way
+  void prefetch(const std::string& filename);
+
+  // The day behind filename with lengths and start times computed, null if
+  // no day file, pack or archive holds it. Waits for a prefetch in flight
+  // and loads the day right away if it was never asked for.
+  std::shared_ptr<TaskManager> get(const std::string& filename);
+
+  size_t size() const;
+
+ private:
+  struct Loaded {
+    std::shared_ptr<TaskManager> day;
+    bool hadFile;  // The day file as it was just before it was read
+    std::filesystem::file_time_type written;
+  };
+  struct Entry {
+    std::shared_future<Loaded> loaded;
+    std::list<std::string>::iterator recent;
+  };
+
+  Config config;  // Own copy: the loader must not read the TUI's while that changes
+  size_t capacity;
+  std::list<std::string> recent;  // Most recently used first
+  std::unordered_map<std::string, Entry> entries;
+  ThreadPool loader;  // Last, so it finishes its jobs before the rest goes
+
+  Loaded load(const std::string& filename);
+  bool isCurrent(const std::string& filename, const Loaded& loaded) const;
+  void insert(const std::string& filename, std::shared_future<Loaded> loaded);
+};
+
+#endif  // DAYCACHE_H
@@ -0,0 +1,83 @@
+#include "FreeSlots.h"
+
+#include <algorithm>
+
+FreeSlots::FreeSlots(const std::vector<ScheduleEntry>& entries, int windowStart, int windowEnd) : leaves(1) {
+  for (const auto& entry : entries) {
+    if ((entry.fixed || entry.rigid) && entry.actLength > 0) {
+      busy.push_back({entry.start, entry.end()});
+    }
+  }
+  std::sort(busy.begin(), busy.end(), [](const Span& a, const Span& b) { return a.start < b.start; });
+  std::vector<Span> merged;
+  for (const Span& span : busy) {
+    if (!merged.empty() && span.start <= merged.back().end) {
+      merged.back().end = std::max(merged.back().end, span.end);
+    } else {
+      merged.push_back(span);
+    }
+  }
+  busy = std::move(merged);
+
+  int cursor = windowStart;
+  for (const Span& span : busy) {
+    if (span.start > cursor && cursor < windowEnd) {
+      gaps.push_back({cursor, std::min(span.start, windowEnd)});
+    }
+    cursor = std::max(cursor, span.end);
+  }
+  if (cursor < windowEnd) {
+    gaps.push_back({cursor, windowEnd});
+  }
+
+  while (leaves < gaps.size()) {
+    leaves *= 2;
+  }
+  longest.assign(2 * leaves, 0);
+  for (size_t i = 0; i < gaps.size(); i++) {
+    longest[leaves + i] = gaps[i].length();
+  }
+  for (size_t node = leaves - 1; node > 0; node--) {
+    longest[node] = std::max(longest[2 * node], longest[2 * node + 1]);
+  }
+}
+
+// First gap index >= from of at least `minutes` under node, gaps.size() if none
+size_t FreeSlots::firstFitting(size_t node, size_t nodeFirst, size_t nodeEnd, size_t from, int minutes) const {
+  if (nodeEnd <= from || longest[node] < minutes) {
+    return gaps.size();
+  }
+  if (node >= leaves) {
+    return nodeFirst;
+  }
+  size_t middle = (nodeFirst + nodeEnd) / 2;
+  size_t left = firstFitting(2 * node, nodeFirst, middle, from, minutes);
+  return left < gaps.size() ? left : firstFitting(2 * node + 1, middle, nodeEnd, from, minutes);
+}
+
+bool FreeSlots::earliest(int minutes, int from, Span& gap) const {
+  // The gap open at `from` only counts from there on; later ones whole
+  auto open = std::upper_bound(gaps.begin(), gaps.end(), from, [](int time, const Span& span) { return time < span.end; });
+  if (open == gaps.end()) {
+    return false;
+  }
+  size_t index = static_cast<size_t>(open - gaps.begin());
+  if (open->end - std::max(open->start, from) >= minutes) {
+    gap = {std::max(open->start, from), open->end};
+    return true;
+  }
+  index = firstFitting(1, 0, leaves, index + 1, minutes);
+  if (index == gaps.size()) {
+    return false;
+  }
+  gap = gaps[index];
+  return true;
+}
+
+const std::vector<FreeSlots::Span>& FreeSlots::getBusy() const {
+  return busy;
+}
+
+const std::vector<FreeSlots::Span>& FreeSlots::getGaps() const {
+  return gaps;
+}
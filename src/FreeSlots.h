@@ -0,0 +1,40 @@
+#ifndef FREESLOTS_H
+#define FREESLOTS_H
+
+#include <vector>
+#include "Schedule.h"
+
+// Free time of one day around its fixed and rigid tasks, for `plan free`
+// and the TUI's F. The busy spans are sorted and merged once; the gaps
+// between them, clipped to the working window, get a max segment tree over
+// their lengths. The earliest gap of at least N minutes from a given time
+// is then a binary search plus one descent of the tree, O(log n).
+class FreeSlots {
+ public:
+  struct Span {
+    int start;  // Minutes since midnight
+    int end;
+
+    int length() const { return end - start; }
+  };
+
+  // Flexible tasks stretch to fill the day, so only fixed and rigid ones block time
+  FreeSlots(const std::vector<ScheduleEntry>& entries, int windowStart, int windowEnd);
+
+  // Earliest gap of at least `minutes` still open at `from`, starting no
+  // earlier than it; false if the day has none
+  bool earliest(int minutes, int from, Span& gap) const;
+
+  const std::vector<Span>& getBusy() const;
+  const std::vector<Span>& getGaps() const;
+
+ private:
+  std::vector<Span> busy;  // Merged, in time order
+  std::vector<Span> gaps;  // In time order
+  size_t leaves;
+  std::vector<int> longest;  // Segment tree: node i covers children 2i and 2i+1, leaves from `leaves` on
+
+  size_t firstFitting(size_t node, size_t nodeFirst, size_t nodeEnd, size_t from, int minutes) const;
+};
+
+#endif  // FREESLOTS_H
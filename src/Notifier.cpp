@@ -0,0 +1,265 @@
+#include "Notifier.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+uint64_t currentMinute() {
+  return static_cast<uint64_t>(std::time(nullptr)) / 60;
+}
+
+// Minutes since the epoch for a local date and a minute offset into it;
+// mktime takes care of DST and of offsets past midnight
+uint64_t epochMinute(const std::string& date, int minutes) {
+  std::tm tm = {};
+  tm.tm_year = std::stoi(date.substr(0, 4)) - 1900;
+  tm.tm_mon = std::stoi(date.substr(5, 2)) - 1;
+  tm.tm_mday = std::stoi(date.substr(8, 2));
+  tm.tm_min = minutes;
+  tm.tm_isdst = -1;
+  return static_cast<uint64_t>(std::mktime(&tm)) / 60;
+}
+
+bool isDate(const std::string& str) {
+  if (str.size() != 10 || str[4] != '-' || str[7] != '-') return false;
+  for (int i = 0; i < 10; i++) {
+    if (i != 4 && i != 7 && !std::isdigit(static_cast<unsigned char>(str[i]))) return false;
+  }
+  return true;
+}
+
+// tasks_2024-01-15.json is for 2024-01-15; any other file is taken as today's
+std::string dateForFile(const std::string& filename) {
+  std::string name = std::filesystem::path(filename).filename().string();
+  if (name.rfind("tasks_", 0) == 0 && name.size() >= 16 && isDate(name.substr(6, 10))) {
+    return name.substr(6, 10);
+  }
+
+  auto now = std::time(nullptr);
+  char buffer[11];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", std::localtime(&now));
+  return buffer;
+}
+
+}  // namespace
+
+BoundaryNotifier::BoundaryNotifier(const std::string& startCommand, const std::string& endCommand)
+    : startHook(startCommand),
+      endHook(endCommand),
+      stopping(false),
+      wheel(currentMinute()),
+      nextId(1) {}
+
+BoundaryNotifier::BoundaryNotifier(const Config& config)
+    : BoundaryNotifier(config.getString("hook-task-start", ""), config.getString("hook-task-end", "")) {}
+
+BoundaryNotifier::~BoundaryNotifier() {
+  stop();
+}
+
+bool BoundaryNotifier::hasHooks() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return !startHook.empty() || !endHook.empty();
+}
+
+void BoundaryNotifier::setHooks(const std::string& startCommand, const std::string& endCommand) {
+  std::lock_guard<std::mutex> lock(mutex);
+  startHook = startCommand;
+  endHook = endCommand;
+}
+
+void BoundaryNotifier::setSkipCheck(std::function<bool()> check) {
+  skipCheck = std::move(check);
+}
+
+void BoundaryNotifier::start() {
+  if (worker.joinable()) {
+    return;
+  }
+  stopping = false;
+  worker = std::thread(&BoundaryNotifier::run, this);
+}
+
+void BoundaryNotifier::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void BoundaryNotifier::setSchedule(const std::string& filename, const Schedule& schedule) {
+  std::string date = dateForFile(filename);
+  uint64_t now = currentMinute();
+
+  // Everything still ahead of us, keyed so that unchanged boundaries compare equal
+  std::map<std::string, std::pair<Boundary, uint64_t>> wanted;
+  for (const auto& entry : schedule.getEntries()) {
+    for (const auto& boundary : {std::make_pair("start", entry.start), std::make_pair("end", entry.end())}) {
+      uint64_t expiry = epochMinute(date, boundary.second);
+      if (expiry <= now) continue;
+      std::string key = std::string(boundary.first) + "@" + std::to_string(boundary.second) + ":" + entry.name;
+      wanted[key] = {{filename, date, boundary.first, entry.name, boundary.second, key}, expiry};
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& known = boundariesByFile[filename];
+
+    for (auto it = known.begin(); it != known.end();) {
+      if (wanted.count(it->first) == 0) {
+        wheel.cancel(it->second);
+        pending.erase(it->second);
+        it = known.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    for (auto& entry : wanted) {
+      if (known.count(entry.first) > 0) continue;
+      uint64_t id = nextId++;
+      pending[id] = std::move(entry.second.first);
+      wheel.schedule(id, entry.second.second);
+      known[entry.first] = id;
+    }
+
+    if (known.empty()) {
+      boundariesByFile.erase(filename);
+    }
+  }
+  wakeup.notify_all();
+}
+
+void BoundaryNotifier::removeSchedule(const std::string& filename) {
+  setSchedule(filename, Schedule());
+}
+
+size_t BoundaryNotifier::pendingCount() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return pending.size();
+}
+
+void BoundaryNotifier::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    std::vector<uint64_t> expired;
+    wheel.advance(currentMinute(), expired);
+
+    std::vector<Boundary> firing;
+    for (uint64_t id : expired) {
+      auto it = pending.find(id);
+      if (it == pending.end()) continue;
+      auto known = boundariesByFile.find(it->second.filename);
+      if (known != boundariesByFile.end()) {
+        known->second.erase(it->second.key);
+      }
+      firing.push_back(std::move(it->second));
+      pending.erase(it);
+    }
+
+    if (!firing.empty()) {
+      lock.unlock();
+      if (!skipCheck || !skipCheck()) {
+        for (const auto& boundary : firing) {
+          spawnHook(boundary);
+        }
+      }
+      lock.lock();
+    }
+    reapChildren();
+
+    // Sleep until the next boundary; poll once a second while hooks still run
+    uint64_t next = wheel.nextExpiry();
+    auto deadline = std::chrono::system_clock::time_point::max();
+    if (next != UINT64_MAX) {
+      deadline = std::chrono::system_clock::time_point(std::chrono::minutes(next));
+    }
+    if (!children.empty()) {
+      deadline = std::min(deadline, std::chrono::system_clock::now() + std::chrono::seconds(1));
+    }
+
+    if (deadline == std::chrono::system_clock::time_point::max()) {
+      wakeup.wait(lock);
+    } else {
+      wakeup.wait_until(lock, deadline);
+    }
+  }
+}
+
+void BoundaryNotifier::spawnHook(const Boundary& boundary) {
+  std::string command;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    command = boundary.event == "start" ? startHook : endHook;
+  }
+  if (command.empty()) {
+    return;
+  }
+
+  // Our variables first so they shadow any inherited ones
+  std::vector<std::string> variables = {
+    "PLAN_EVENT=" + boundary.event,
+    "PLAN_TASK=" + boundary.task,
+    "PLAN_TIME=" + minutesToTimeString(boundary.minutes),
+    "PLAN_DATE=" + boundary.date,
+    "PLAN_FILE=" + boundary.filename,
+  };
+  std::vector<char*> envp;
+  for (auto& variable : variables) {
+    envp.push_back(&variable[0]);
+  }
+  for (char** inherited = environ; inherited && *inherited; inherited++) {
+    envp.push_back(*inherited);
+  }
+  envp.push_back(nullptr);
+
+  std::string shell = "/bin/sh";
+  std::string flag = "-c";
+  char* argv[] = {&shell[0], &flag[0], &command[0], nullptr};
+
+  // Keep hook output off the terminal, the TUI owns it
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+  pid_t pid = 0;
+  int result = posix_spawn(&pid, shell.c_str(), &actions, nullptr, argv, envp.data());
+  posix_spawn_file_actions_destroy(&actions);
+  if (result != 0) {
+    std::cerr << "Warning: Could not run " << boundary.event << " hook: " << std::strerror(result) << std::endl;
+    return;
+  }
+  children.push_back(pid);
+}
+
+void BoundaryNotifier::reapChildren() {
+  for (auto it = children.begin(); it != children.end();) {
+    pid_t result = ::waitpid(*it, nullptr, WNOHANG);
+    if (result == *it || (result < 0 && errno == ECHILD)) {
+      it = children.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,84 @@
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "Schedule.h"
+#include "TimerWheel.h"
+
+class Config;
+
+// Runs the user's hook commands when a task starts or ends. Upcoming
+// boundaries of every schedule handed in (one per data file) sit in a timer
+// wheel; a background thread sleeps until the earliest one and starts hooks
+// with posix_spawn without waiting for them, so callers never block.
+//
+// Hooks run as `/bin/sh -c <command>` with PLAN_EVENT (start|end), PLAN_TASK,
+// PLAN_TIME (HH:MM), PLAN_DATE and PLAN_FILE set in their environment.
+class BoundaryNotifier {
+ private:
+  struct Boundary {
+    std::string filename;
+    std::string date;
+    std::string event;  // "start" or "end"
+    std::string task;
+    int minutes;        // Since midnight of `date`
+    std::string key;    // Identity within boundariesByFile[filename]
+  };
+
+  std::string startHook;
+  std::string endHook;
+  std::function<bool()> skipCheck;  // Set before start(), only called by the worker
+
+  mutable std::mutex mutex;
+  std::condition_variable wakeup;
+  std::thread worker;
+  bool stopping;
+
+  TimerWheel wheel;
+  uint64_t nextId;
+  std::unordered_map<uint64_t, Boundary> pending;  // timer id -> boundary
+  // filename -> boundary key -> timer id, diffed on every update
+  std::map<std::string, std::map<std::string, uint64_t>> boundariesByFile;
+  std::vector<pid_t> children;  // Hooks still running, reaped without blocking
+
+  void run();
+  void spawnHook(const Boundary& boundary);
+  void reapChildren();
+
+ public:
+  BoundaryNotifier(const std::string& startCommand, const std::string& endCommand);
+  explicit BoundaryNotifier(const Config& config);  // hook-task-start / hook-task-end
+  ~BoundaryNotifier();
+
+  BoundaryNotifier(const BoundaryNotifier&) = delete;
+  BoundaryNotifier& operator=(const BoundaryNotifier&) = delete;
+
+  bool hasHooks() const;
+  void setHooks(const std::string& startCommand, const std::string& endCommand);
+
+  // Asked on the background thread whenever boundaries come due; while it
+  // returns true they pass without running hooks. Set it before start().
+  void setSkipCheck(std::function<bool()> check);
+
+  void start();  // Launch the background thread
+  void stop();
+
+  // Replace the boundaries known for a data file with those of its new
+  // schedule. Only boundaries that appeared or disappeared touch the wheel;
+  // boundaries already in the past are never scheduled.
+  void setSchedule(const std::string& filename, const Schedule& schedule);
+  void removeSchedule(const std::string& filename);
+
+  size_t pendingCount() const;
+};
+
+#endif  // NOTIFIER_H
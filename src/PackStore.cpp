@@ -0,0 +1,208 @@
+#include "PackStore.h"
+#include "Compression.h"
+#include "ContentHash.h"
+#include "DateRange.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x4b504c50;  // "PLPK"
+constexpr size_t HEADER_SIZE = 32;
+constexpr size_t CHECKSUM_AT = 24;
+constexpr size_t ENTRY_SIZE = 32;
+constexpr uint32_t MAX_DAYS = 31;
+
+template <typename T>
+void put(std::string& buffer, size_t at, T value) {
+  std::memcpy(&buffer[at], &value, sizeof(value));
+}
+
+template <typename T>
+T get(const std::string& buffer, size_t at) {
+  T value;
+  std::memcpy(&value, buffer.data() + at, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+std::string PackStore::packPath(const std::string& dataDir, const std::string& month) {
+  return dataDir + "/tasks_" + month + ".pack";
+}
+
+bool PackStore::monthOf(const std::string& packFilename, std::string& month) {
+  int64_t day = 0;
+  if (packFilename.size() != 18 || packFilename.compare(0, 6, "tasks_") != 0 ||
+      packFilename.compare(13, std::string::npos, ".pack") != 0 ||
+      !DateRange::toDayNumber(packFilename.substr(6, 7) + "-01", day)) {
+    return false;
+  }
+  month = packFilename.substr(6, 7);
+  return true;
+}
+
+PackStore::PackStore(const std::string& path)
+    : path(path), valid(false), dictionaryOffset(0), dictionaryLength(0), dictionaryBlockLength(0),
+      dictionaryLoaded(false) {}
+
+bool PackStore::open() {
+  valid = false;
+  dictionaryLoaded = false;
+  entries.clear();
+  file.close();
+  file.clear();
+  file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::string header(HEADER_SIZE, '\0');
+  if (!file.read(&header[0], HEADER_SIZE) || get<uint32_t>(header, 0) != MAGIC ||
+      get<uint32_t>(header, 4) != VERSION || get<uint32_t>(header, 8) > MAX_DAYS) {
+    return false;
+  }
+  uint32_t dayCount = get<uint32_t>(header, 8);
+  dictionaryLength = get<uint32_t>(header, 12);
+  dictionaryBlockLength = get<uint32_t>(header, 16);
+
+  std::string table(dayCount * ENTRY_SIZE, '\0');
+  if (dayCount > 0 && !file.read(&table[0], static_cast<std::streamsize>(table.size()))) {
+    return false;
+  }
+  uint64_t checksum = get<uint64_t>(header, CHECKSUM_AT);
+  put<uint64_t>(header, CHECKSUM_AT, 0);
+  if (hashContent(header + table) != checksum) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < dayCount; i++) {
+    size_t at = i * ENTRY_SIZE;
+    entries.push_back({get<int64_t>(table, at), get<uint64_t>(table, at + 8), get<uint32_t>(table, at + 16),
+                       get<uint32_t>(table, at + 20), get<uint64_t>(table, at + 24)});
+  }
+  dictionaryOffset = HEADER_SIZE + table.size();
+  valid = true;
+  return true;
+}
+
+std::vector<std::string> PackStore::dates() const {
+  std::vector<std::string> result;
+  for (const Entry& entry : entries) {
+    result.push_back(DateRange::fromDayNumber(entry.day));
+  }
+  return result;
+}
+
+bool PackStore::loadDictionary() {
+  if (dictionaryLoaded) {
+    return true;
+  }
+  std::string block(dictionaryBlockLength, '\0');
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(dictionaryOffset));
+  if (dictionaryBlockLength > 0 && !file.read(&block[0], dictionaryBlockLength)) {
+    return false;
+  }
+  dictionaryLoaded = lzDecompress(block, dictionaryLength, dictionary);
+  return dictionaryLoaded;
+}
+
+bool PackStore::readEntry(const Entry& entry, std::string& content) {
+  if (!loadDictionary()) {
+    return false;
+  }
+  std::string block(entry.blockLength, '\0');
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(entry.offset));
+  if (entry.blockLength > 0 && !file.read(&block[0], entry.blockLength)) {
+    return false;
+  }
+  return lzDecompress(block, entry.length, content, dictionary) && hashContent(content) == entry.checksum;
+}
+
+bool PackStore::read(const std::string& date, std::string& content) {
+  int64_t day = 0;
+  if (!valid || !DateRange::toDayNumber(date, day)) {
+    return false;
+  }
+  auto found = std::lower_bound(entries.begin(), entries.end(), day,
+                                [](const Entry& entry, int64_t value) { return entry.day < value; });
+  return found != entries.end() && found->day == day && readEntry(*found, content);
+}
+
+bool PackStore::readAll(std::map<std::string, std::string>& days) {
+  if (!valid) {
+    return false;
+  }
+  for (const Entry& entry : entries) {
+    std::string content;
+    if (!readEntry(entry, content)) {
+      return false;
+    }
+    days[DateRange::fromDayNumber(entry.day)] = std::move(content);
+  }
+  return true;
+}
+
+bool PackStore::write(const std::string& path, const std::map<std::string, std::string>& days) {
+  if (days.size() > MAX_DAYS) {
+    return false;
+  }
+
+  // The month's first days, up to DICTIONARY_BYTES, stand for its routine
+  std::string dictionary;
+  for (const auto& [date, content] : days) {
+    if (dictionary.size() + content.size() > DICTIONARY_BYTES) {
+      break;
+    }
+    dictionary += content;
+  }
+  std::string dictionaryBlock = lzCompress(dictionary);
+
+  std::string table(days.size() * ENTRY_SIZE, '\0');
+  std::string blocks;
+  uint64_t offset = HEADER_SIZE + table.size() + dictionaryBlock.size();
+  size_t index = 0;
+  for (const auto& [date, content] : days) {
+    int64_t day = 0;
+    if (!DateRange::toDayNumber(date, day) || content.size() > UINT32_MAX) {
+      return false;
+    }
+    std::string block = lzCompress(content, dictionary);
+    size_t at = index++ * ENTRY_SIZE;
+    put<int64_t>(table, at, day);
+    put<uint64_t>(table, at + 8, offset + blocks.size());
+    put<uint32_t>(table, at + 16, static_cast<uint32_t>(block.size()));
+    put<uint32_t>(table, at + 20, static_cast<uint32_t>(content.size()));
+    put<uint64_t>(table, at + 24, hashContent(content));
+    blocks += block;
+  }
+
+  std::string header(HEADER_SIZE, '\0');
+  put<uint32_t>(header, 0, MAGIC);
+  put<uint32_t>(header, 4, VERSION);
+  put<uint32_t>(header, 8, static_cast<uint32_t>(days.size()));
+  put<uint32_t>(header, 12, static_cast<uint32_t>(dictionary.size()));
+  put<uint32_t>(header, 16, static_cast<uint32_t>(dictionaryBlock.size()));
+  put<uint64_t>(header, CHECKSUM_AT, hashContent(header + table));
+
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return false;
+    }
+    out << header << table << dictionaryBlock << blocks;
+    if (!out) {
+      return false;
+    }
+  }
+
+  // Rename so a crash mid-write never leaves a truncated pack behind
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  return !ec;
+}
@@ -0,0 +1,66 @@
+#ifndef PACKSTORE_H
+#define PACKSTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// One month of day files compressed into data/tasks_YYYY-MM.pack (`plan
+// pack`). Days of a month are mostly the same routine, so the first few of
+// them form a shared dictionary and every day is compressed on its own
+// against it (see lzCompress). Reading one day decompresses the dictionary
+// and that day's block, found through the offset table after the header;
+// the other days are never touched.
+//
+// Layout: u32 magic, u32 version, u32 day count, u32 dictionary size,
+// u32 dictionary block size, u32 unused, u64 checksum of the header and
+// table, then one table entry per day (i64 day, u64 offset, u32 block size,
+// u32 size, u64 checksum of the day's bytes), the dictionary block and the
+// day blocks. Host byte order, like the other sidecars.
+class PackStore {
+ public:
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t DICTIONARY_BYTES = 32 * 1024;
+
+  // dataDir, 2024-01 -> dataDir/tasks_2024-01.pack
+  static std::string packPath(const std::string& dataDir, const std::string& month);
+  // tasks_2024-01.pack -> 2024-01; false for any other name
+  static bool monthOf(const std::string& packFilename, std::string& month);
+
+  explicit PackStore(const std::string& path);
+
+  bool open();  // Reads the header and offset table; false if missing or damaged
+  std::vector<std::string> dates() const;  // YYYY-MM-DD, oldest first
+
+  bool read(const std::string& date, std::string& content);
+  bool readAll(std::map<std::string, std::string>& days);
+
+  // Replace the pack at path with exactly these days (date -> data file bytes)
+  static bool write(const std::string& path, const std::map<std::string, std::string>& days);
+
+ private:
+  struct Entry {
+    int64_t day;  // Days since 1970-01-01
+    uint64_t offset;
+    uint32_t blockLength;
+    uint32_t length;
+    uint64_t checksum;
+  };
+
+  std::string path;
+  std::ifstream file;
+  bool valid;
+  std::vector<Entry> entries;  // Sorted by day
+  uint64_t dictionaryOffset;
+  uint32_t dictionaryLength;
+  uint32_t dictionaryBlockLength;
+  std::string dictionary;  // Decompressed on first read
+  bool dictionaryLoaded;
+
+  bool loadDictionary();
+  bool readEntry(const Entry& entry, std::string& content);
+};
+
+#endif  // PACKSTORE_H
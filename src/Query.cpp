@@ -0,0 +1,453 @@
+#include "Query.h"
+#include "DateRange.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iterator>
+#include <regex>
+
+namespace {
+
+constexpr size_t BLOCK_ROWS = 4096;  // Rows per evaluation block
+using Bits = std::array<uint64_t, BLOCK_ROWS / 64>;
+
+struct Token {
+  enum Type { WORD, STRING, OP, OPEN, CLOSE, END } type;
+  std::string text;
+};
+
+std::string lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return text;
+}
+
+bool tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error) {
+  static const std::string operatorChars = "=!<>~";
+  size_t i = 0;
+  while (i < text.size()) {
+    char c = text[i];
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      i++;
+    } else if (c == '(' || c == ')') {
+      tokens.push_back({c == '(' ? Token::OPEN : Token::CLOSE, std::string(1, c)});
+      i++;
+    } else if (c == '\'' || c == '"') {
+      size_t end = text.find(c, i + 1);
+      if (end == std::string::npos) {
+        error = "unterminated string " + text.substr(i);
+        return false;
+      }
+      tokens.push_back({Token::STRING, text.substr(i + 1, end - i - 1)});
+      i = end + 1;
+    } else if (operatorChars.find(c) != std::string::npos) {
+      char next = i + 1 < text.size() ? text[i + 1] : '\0';
+      size_t length = next == '=' || (c == '!' && next == '~') ? 2 : 1;
+      tokens.push_back({Token::OP, text.substr(i, length)});
+      i += length;
+    } else {
+      size_t start = i;
+      while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) && text[i] != '(' &&
+             text[i] != ')' && text[i] != '\'' && text[i] != '"' && operatorChars.find(text[i]) == std::string::npos) {
+        i++;
+      }
+      tokens.push_back({Token::WORD, text.substr(start, i - start)});
+    }
+  }
+  tokens.push_back({Token::END, ""});
+  return true;
+}
+
+// Minutes from 90, 90m, 2h or 1h30(m); a time of day from 9:30 or 09:30
+bool parseMinutes(const std::string& text, bool timeOfDay, int64_t& minutes) {
+  static const std::regex duration("(\\d+)h(\\d+)?m?|(\\d+)m?");
+  static const std::regex time("(\\d{1,2}):(\\d{2})");
+  std::smatch match;
+  if (timeOfDay && std::regex_match(text, match, time)) {
+    minutes = std::stoll(match[1]) * 60 + std::stoll(match[2]);
+    return std::stoll(match[1]) < 24 && std::stoll(match[2]) < 60;
+  }
+  if (text.size() > 9 || !std::regex_match(text, match, duration)) {
+    return false;
+  }
+  minutes = match[3].matched ? std::stoll(match[3])
+                             : std::stoll(match[1]) * 60 + (match[2].matched ? std::stoll(match[2]) : 0);
+  return true;
+}
+
+// First and last day of 2024, 2024-Q1, 2024-01, 2024-01-15 or FIRST..LAST
+bool parsePeriod(const std::string& text, int64_t& first, int64_t& last) {
+  static const std::regex year("\\d{4}");
+  static const std::regex quarter("(\\d{4})-[Qq]([1-4])");
+  static const std::regex month("(\\d{4})-(\\d{2})");
+  std::smatch match;
+  auto span = [&](const std::string& year, int firstMonth, int months) {
+    std::string next = std::to_string(std::stoi(year) + (firstMonth - 1 + months) / 12);
+    int nextMonth = (firstMonth - 1 + months) % 12 + 1;
+    int64_t end = 0;
+    auto monthStart = [](const std::string& y, int m) { return y + (m < 10 ? "-0" : "-") + std::to_string(m) + "-01"; };
+    if (!DateRange::toDayNumber(monthStart(year, firstMonth), first) ||
+        !DateRange::toDayNumber(monthStart(next, nextMonth), end)) {
+      return false;
+    }
+    last = end - 1;
+    return true;
+  };
+
+  if (std::regex_match(text, match, year)) {
+    return span(text, 1, 12);
+  }
+  if (std::regex_match(text, match, quarter)) {
+    return span(match[1], (std::stoi(match[2]) - 1) * 3 + 1, 3);
+  }
+  if (std::regex_match(text, match, month)) {
+    int number = std::stoi(match[2]);
+    return number >= 1 && number <= 12 && span(match[1], number, 1);
+  }
+  if (DateRange::looksLikeRange(text)) {
+    DateRange range;
+    if (!DateRange::parse(text, range)) {
+      return false;
+    }
+    first = range.first();
+    last = range.last();
+    return true;
+  }
+  if (!DateRange::toDayNumber(text, first)) {
+    return false;
+  }
+  last = first;
+  return true;
+}
+
+template <typename Test>
+void fill(Bits& bits, size_t rows, Test test) {
+  bits.fill(0);
+  for (size_t base = 0; base < rows; base += 64) {
+    size_t count = std::min<size_t>(64, rows - base);
+    uint64_t word = 0;
+    for (size_t bit = 0; bit < count; bit++) {
+      word |= static_cast<uint64_t>(test(base + bit)) << bit;
+    }
+    bits[base / 64] = word;
+  }
+}
+
+template <typename T>
+void compare(Bits& bits, const T* column, size_t rows, int op, int64_t value) {
+  enum { EQ, NE, LT, LE, GT, GE };  // Order of Query::Op
+  switch (op) {
+    case EQ: fill(bits, rows, [&](size_t i) { return column[i] == value; }); break;
+    case NE: fill(bits, rows, [&](size_t i) { return column[i] != value; }); break;
+    case LT: fill(bits, rows, [&](size_t i) { return column[i] < value; }); break;
+    case LE: fill(bits, rows, [&](size_t i) { return column[i] <= value; }); break;
+    case GT: fill(bits, rows, [&](size_t i) { return column[i] > value; }); break;
+    default: fill(bits, rows, [&](size_t i) { return column[i] >= value; }); break;
+  }
+}
+
+}  // namespace
+
+// Recursive descent over the tokens: or-chains of and-chains of unary terms
+class QueryParser {
+ public:
+  QueryParser(Query& query, std::vector<Token> tokens) : query(query), tokens(std::move(tokens)), at(0) {}
+
+  bool parse(std::string& error) {
+    int root = parseOr();
+    if (root >= 0 && tokens[at].type != Token::END) {
+      fail("unexpected '" + tokens[at].text + "'");
+    }
+    if (!problem.empty()) {
+      error = problem;
+      return false;
+    }
+    query.root = root;
+    narrow(root);
+    return true;
+  }
+
+ private:
+  Query& query;
+  std::vector<Token> tokens;
+  size_t at;
+  std::string problem;
+
+  using Node = Query::Node;
+  using Op = Query::Op;
+  using Field = Query::Field;
+
+  int fail(const std::string& message) {
+    if (problem.empty()) {
+      problem = message;
+    }
+    return -1;
+  }
+
+  bool keyword(const char* word) {
+    if (tokens[at].type == Token::WORD && lowercase(tokens[at].text) == word) {
+      at++;
+      return true;
+    }
+    return false;
+  }
+
+  int add(Node node) {
+    query.nodes.push_back(std::move(node));
+    return static_cast<int>(query.nodes.size()) - 1;
+  }
+
+  int join(Node::Kind kind, int left, int right) {
+    Node node{kind};
+    node.left = left;
+    node.right = right;
+    return add(node);
+  }
+
+  int parseOr() {
+    int left = parseAnd();
+    while (left >= 0 && keyword("or")) {
+      int right = parseAnd();
+      left = right < 0 ? -1 : join(Node::OR, left, right);
+    }
+    return left;
+  }
+
+  int parseAnd() {
+    int left = parseUnary();
+    while (left >= 0 && keyword("and")) {
+      int right = parseUnary();
+      left = right < 0 ? -1 : join(Node::AND, left, right);
+    }
+    return left;
+  }
+
+  int parseUnary() {
+    if (keyword("not")) {
+      int operand = parseUnary();
+      return operand < 0 ? -1 : join(Node::NOT, operand, -1);
+    }
+    if (tokens[at].type == Token::OPEN) {
+      at++;
+      int inner = parseOr();
+      if (inner >= 0 && tokens[at].type != Token::CLOSE) {
+        return fail(tokens[at].type == Token::END ? "missing ')'" : "expected ')' before '" + tokens[at].text + "'");
+      }
+      at++;
+      return inner;
+    }
+    return parseCondition();
+  }
+
+  int parseCondition() {
+    if (tokens[at].type != Token::WORD) {
+      return fail(tokens[at].type == Token::END ? "query ends early" : "unexpected '" + tokens[at].text + "'");
+    }
+    std::string field = lowercase(tokens[at++].text);
+    if (field == "fixed" || field == "rigid") {
+      Node node{Node::FLAG};
+      node.flag = field == "fixed" ? ColumnStore::FIXED : ColumnStore::RIGID;
+      return add(node);
+    }
+    if (field != "name" && field != "date" && field != "start" && field != "length" && field != "actlength") {
+      return fail("unknown field '" + field + "' (name, date, start, length, actlength, fixed, rigid)");
+    }
+
+    std::string op;
+    if (field == "date" && keyword("in")) {
+      op = "in";
+    } else if (tokens[at].type == Token::OP) {
+      op = tokens[at++].text;
+    } else {
+      return fail("expected an operator after '" + field + "'");
+    }
+    if (tokens[at].type != Token::WORD && tokens[at].type != Token::STRING) {
+      return fail("expected a value after '" + field + " " + op + "'");
+    }
+    std::string value = tokens[at++].text;
+
+    if (field == "name") {
+      if (op != "=" && op != "==" && op != "!=" && op != "~" && op != "!~") {
+        return fail("names compare with =, !=, ~ or !~");
+      }
+      bool contains = op == "~" || op == "!~";
+      Node node{contains ? Node::NAME_HAS : Node::NAME_IS};
+      node.text = contains ? lowercase(value) : value;
+      int condition = add(node);
+      return op[0] == '!' ? join(Node::NOT, condition, -1) : condition;
+    }
+
+    Op comparison;
+    if (op == "=" || op == "==" || op == "in") {
+      comparison = Op::EQ;
+    } else if (op == "!=") {
+      comparison = Op::NE;
+    } else if (op == "<") {
+      comparison = Op::LT;
+    } else if (op == "<=") {
+      comparison = Op::LE;
+    } else if (op == ">") {
+      comparison = Op::GT;
+    } else if (op == ">=") {
+      comparison = Op::GE;
+    } else {
+      return fail("'" + op + "' does not apply to " + field);
+    }
+
+    if (field != "date") {
+      Node node{Node::COMPARE};
+      node.field = field == "start" ? Field::START : (field == "length" ? Field::LENGTH : Field::ACT_LENGTH);
+      node.op = comparison;
+      if (!parseMinutes(value, field == "start", node.value)) {
+        return fail("'" + value + "' is not " + (field == "start" ? "a time or minutes" : "minutes"));
+      }
+      return add(node);
+    }
+
+    // A date compares against a whole period: before its first day, through its last, ...
+    int64_t first = 0, last = 0;
+    if (!parsePeriod(value, first, last)) {
+      return fail("'" + value + "' is not a date, month, quarter, year or range");
+    }
+    auto bound = [&](Op op, int64_t day) {
+      Node node{Node::COMPARE};
+      node.field = Field::DATE;
+      node.op = op;
+      node.value = day;
+      return add(node);
+    };
+    switch (comparison) {
+      case Op::LT: return bound(Op::LT, first);
+      case Op::LE: return bound(Op::LE, last);
+      case Op::GT: return bound(Op::GT, last);
+      case Op::GE: return bound(Op::GE, first);
+      default: {
+        int within = join(Node::AND, bound(Op::GE, first), bound(Op::LE, last));
+        return comparison == Op::NE ? join(Node::NOT, within, -1) : within;
+      }
+    }
+  }
+
+  // Date bounds every match must meet, from the and-chain at the top
+  void narrow(int index) {
+    const Node& node = query.nodes[index];
+    if (node.kind == Node::AND) {
+      narrow(node.left);
+      narrow(node.right);
+    } else if (node.kind == Node::COMPARE && node.field == Field::DATE) {
+      int64_t& first = query.first;
+      int64_t& last = query.last;
+      switch (node.op) {
+        case Op::EQ: first = std::max(first, node.value); last = std::min(last, node.value); break;
+        case Op::LT: last = std::min(last, node.value - 1); break;
+        case Op::LE: last = std::min(last, node.value); break;
+        case Op::GT: first = std::max(first, node.value + 1); break;
+        case Op::GE: first = std::max(first, node.value); break;
+        default: break;
+      }
+    }
+  }
+};
+
+bool Query::parse(const std::string& text, Query& query, std::string& error) {
+  query = Query();
+  std::vector<Token> tokens;
+  if (!tokenize(text, tokens, error)) {
+    return false;
+  }
+  return QueryParser(query, std::move(tokens)).parse(error);
+}
+
+int64_t Query::firstDay() const {
+  return first;
+}
+
+int64_t Query::lastDay() const {
+  return last;
+}
+
+void Query::run(const ColumnStore::Columns& columns, const std::function<void(size_t row)>& match) const {
+  // Name conditions become one lookup per row: a table over the distinct names
+  const std::vector<std::string>& names = *columns.names;
+  std::vector<std::vector<uint8_t>> nameTables(nodes.size());
+  std::vector<std::string> lowerNames;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i].kind == Node::NAME_IS) {
+      nameTables[i].resize(names.size());
+      for (size_t id = 0; id < names.size(); id++) {
+        nameTables[i][id] = names[id] == nodes[i].text;
+      }
+    } else if (nodes[i].kind == Node::NAME_HAS) {
+      if (lowerNames.empty()) {
+        std::transform(names.begin(), names.end(), std::back_inserter(lowerNames), lowercase);
+      }
+      nameTables[i].resize(names.size());
+      for (size_t id = 0; id < names.size(); id++) {
+        nameTables[i][id] = lowerNames[id].find(nodes[i].text) != std::string::npos;
+      }
+    }
+  }
+
+  std::function<void(int, size_t, size_t, Bits&)> evaluate = [&](int index, size_t start, size_t rows, Bits& bits) {
+    const Node& node = nodes[index];
+    switch (node.kind) {
+      case Node::AND:
+      case Node::OR: {
+        evaluate(node.left, start, rows, bits);
+        bool settled = std::all_of(bits.begin(), bits.end(), [&](uint64_t word) {
+          return node.kind == Node::AND ? word == 0 : word == ~uint64_t{0};
+        });
+        if (settled) {
+          return;
+        }
+        Bits other;
+        evaluate(node.right, start, rows, other);
+        for (size_t word = 0; word < bits.size(); word++) {
+          bits[word] = node.kind == Node::AND ? bits[word] & other[word] : bits[word] | other[word];
+        }
+        return;
+      }
+      case Node::NOT:
+        evaluate(node.left, start, rows, bits);
+        for (size_t base = 0; base < BLOCK_ROWS; base += 64) {
+          size_t valid = rows > base ? std::min<size_t>(64, rows - base) : 0;
+          uint64_t mask = valid == 64 ? ~uint64_t{0} : (uint64_t{1} << valid) - 1;
+          bits[base / 64] = ~bits[base / 64] & mask;
+        }
+        return;
+      case Node::COMPARE: {
+        const int32_t* column = node.field == Field::DATE     ? columns.dates
+                                : node.field == Field::START  ? columns.starts
+                                : node.field == Field::LENGTH ? columns.lengths
+                                                              : columns.actLengths;
+        compare(bits, column + start, rows, static_cast<int>(node.op), node.value);
+        return;
+      }
+      case Node::NAME_IS:
+      case Node::NAME_HAS: {
+        const uint8_t* table = nameTables[index].data();
+        const uint32_t* ids = columns.nameIds + start;
+        fill(bits, rows, [&](size_t i) { return table[ids[i]] != 0; });
+        return;
+      }
+      case Node::FLAG: {
+        const uint8_t* flags = columns.flags + start;
+        uint8_t flag = node.flag;
+        fill(bits, rows, [&](size_t i) { return (flags[i] & flag) != 0; });
+        return;
+      }
+    }
+  };
+
+  Bits bits;
+  for (size_t start = 0; start < columns.count; start += BLOCK_ROWS) {
+    size_t rows = std::min(BLOCK_ROWS, columns.count - start);
+    evaluate(root, start, rows, bits);
+    for (size_t word = 0; word < bits.size(); word++) {
+      for (uint64_t set = bits[word]; set != 0; set &= set - 1) {
+        match(start + word * 64 + static_cast<size_t>(__builtin_ctzll(set)));
+      }
+    }
+  }
+}
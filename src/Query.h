@@ -0,0 +1,61 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ColumnStore.h"
+
+// Filter over task rows for `plan query`, e.g.
+//
+//   rigid and length>=60 and name~'review' and date in 2024-Q1
+//
+// Conditions: name = / != (exact), name ~ / !~ (contains, ignoring case);
+// start, length and actlength compared with = != < <= > >= against minutes
+// (90, 1h30) or, for start, a time (09:30); date compared the same way, or
+// `date in`, against a day (2024-01-15), month (2024-01), quarter (2024-Q1),
+// year (2024) or range (FIRST..LAST); the flags fixed and rigid. They combine
+// with and, or, not and parentheses, and bind in that order.
+//
+// parse() builds the expression tree once. run() first turns every name
+// condition into a table over the distinct names, then evaluates the tree
+// over blocks of rows, each node filling a bitset from one column, and
+// calls back for the rows whose bits survive.
+class Query {
+ public:
+  // False with a message naming the offending word if text is not a query
+  static bool parse(const std::string& text, Query& query, std::string& error);
+
+  // Narrowest span of days (since 1970-01-01) the query's top-level date
+  // conditions allow; INT64_MIN/INT64_MAX when unbounded
+  int64_t firstDay() const;
+  int64_t lastDay() const;
+
+  // match(row) for each matching row of columns, in row order
+  void run(const ColumnStore::Columns& columns, const std::function<void(size_t row)>& match) const;
+
+ private:
+  enum class Field { DATE, START, LENGTH, ACT_LENGTH };
+  enum class Op { EQ, NE, LT, LE, GT, GE };
+  struct Node {
+    enum Kind { AND, OR, NOT, COMPARE, NAME_IS, NAME_HAS, FLAG } kind;
+    explicit Node(Kind kind) : kind(kind) {}
+    Field field = Field::DATE;
+    Op op = Op::EQ;
+    int64_t value = 0;
+    std::string text;  // Name to match; lowercase for NAME_HAS
+    uint8_t flag = 0;
+    int left = -1;  // Operands of AND/OR, left alone for NOT
+    int right = -1;
+  };
+
+  std::vector<Node> nodes;
+  int root = -1;
+  int64_t first = INT64_MIN;
+  int64_t last = INT64_MAX;
+
+  friend class QueryParser;
+};
+
+#endif  // QUERY_H
@@ -0,0 +1,128 @@
+#include "Schedule.h"
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+Schedule::Schedule(const std::vector<Act>& tasks) {
+  entries.reserve(tasks.size());
+  for (const auto& task : tasks) {
+    entries.push_back({task.getName(), task.getStartInt(), task.getActLength(),
+                       task.isFixed(), task.isRigid()});
+  }
+}
+
+void Schedule::addEntry(const ScheduleEntry& entry) {
+  entries.push_back(entry);
+}
+
+const std::vector<ScheduleEntry>& Schedule::getEntries() const {
+  return entries;
+}
+
+size_t Schedule::size() const {
+  return entries.size();
+}
+
+bool Schedule::empty() const {
+  return entries.empty();
+}
+
+bool Schedule::operator==(const Schedule& other) const {
+  return entries == other.entries;
+}
+
+bool Schedule::operator!=(const Schedule& other) const {
+  return !(*this == other);
+}
+
+std::string Schedule::describeCurrent(int minutes) const {
+  const ScheduleEntry* entry = entryAt(minutes);
+  if (entry) {
+    int remainingMinutes = entry->end() - minutes;
+    return entry->name + " (ends at " + minutesToTimeString(entry->end()) +
+           ", " + std::to_string(remainingMinutes) + " min remaining)";
+  }
+
+  return "No active task at current time (" + minutesToTimeString(minutes) + ")";
+}
+
+std::string Schedule::describeNext(int minutes) const {
+  // Find the next task that starts after the given time
+  for (const auto& entry : entries) {
+    if (entry.start > minutes) {
+      int minutesUntil = entry.start - minutes;
+      return entry.name + " (starts at " + minutesToTimeString(entry.start) +
+             ", in " + std::to_string(minutesUntil) + " minutes)";
+    }
+  }
+
+  return "No upcoming tasks today";
+}
+
+std::string Schedule::describeList(const std::string& heading) const {
+  std::ostringstream out;
+  out << heading << ":\n";
+  out << std::string(heading.size(), '=') << "\n";
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    const auto& entry = entries[i];
+    out << (i + 1) << ". " << entry.name
+        << " " << (entry.fixed ? "[FIXED]" : "[FLEX]")
+        << " (" << minutesToTimeString(entry.start) << " - " << minutesToTimeString(entry.end())
+        << ", " << entry.actLength << " min)\n";
+  }
+
+  return out.str();
+}
+
+std::string Schedule::describeCurrentSpan(int minutes) const {
+  const ScheduleEntry* entry = entryAt(minutes);
+  if (entry) {
+    return entry->name + " (" + minutesToTimeString(entry->start) + " - " +
+           minutesToTimeString(entry->end()) + ")";
+  }
+
+  for (const auto& next : entries) {
+    if (next.start > minutes) {
+      return "No active task (next: " + next.name + " at " + minutesToTimeString(next.start) + ")";
+    }
+  }
+  return "No active task";
+}
+
+const ScheduleEntry* Schedule::entryAt(int minutes) const {
+  for (const auto& entry : entries) {
+    if (minutes >= entry.start && minutes < entry.end()) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+int Schedule::nextBoundaryAfter(int minutes) const {
+  int boundary = -1;
+  for (const auto& entry : entries) {
+    for (int candidate : {entry.start, entry.end()}) {
+      if (candidate > minutes && (boundary < 0 || candidate < boundary)) {
+        boundary = candidate;
+      }
+    }
+  }
+  return boundary;
+}
+
+int getCurrentTimeInMinutes() {
+  auto now = std::time(nullptr);
+  auto tm = *std::localtime(&now);
+  return tm.tm_hour * 60 + tm.tm_min;
+}
+
+std::string minutesToTimeString(int minutes) {
+  int hours = minutes / 60;
+  int mins = minutes % 60;
+  std::ostringstream oss;
+  oss << std::setfill('0') << std::setw(2) << hours << ":"
+      << std::setfill('0') << std::setw(2) << mins;
+  return oss.str();
+}
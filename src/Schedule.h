@@ -0,0 +1,57 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <string>
+#include <vector>
+#include "Act.h"
+
+// One computed row of a day: where a task lands after calcActLen/calcStartTimes
+struct ScheduleEntry {
+  std::string name;
+  int start;      // Minutes since midnight
+  int actLength;  // Minutes
+  bool fixed;
+  bool rigid;
+
+  int end() const { return start + actLength; }
+  bool operator==(const ScheduleEntry& other) const {
+    return name == other.name && start == other.start && actLength == other.actLength &&
+           fixed == other.fixed && rigid == other.rigid;
+  }
+};
+
+// Read-only snapshot of a computed schedule. Cheap to copy around and
+// independent of TaskManager, so it can be cached, served or published.
+class Schedule {
+ private:
+  std::vector<ScheduleEntry> entries;
+
+ public:
+  Schedule() = default;
+  explicit Schedule(const std::vector<Act>& tasks);
+
+  void addEntry(const ScheduleEntry& entry);
+  const std::vector<ScheduleEntry>& getEntries() const;
+  size_t size() const;
+  bool empty() const;
+  bool operator==(const Schedule& other) const;
+  bool operator!=(const Schedule& other) const;
+
+  // Text used by the `now`, `next` and `list` commands
+  std::string describeCurrent(int minutes) const;
+  std::string describeNext(int minutes) const;
+  std::string describeList(const std::string& heading = "Today's Tasks") const;
+
+  // Text used by `watch`: the current task and its span, with no countdown,
+  // so it only changes at a boundary
+  std::string describeCurrentSpan(int minutes) const;
+
+  const ScheduleEntry* entryAt(int minutes) const;  // nullptr when idle
+  int nextBoundaryAfter(int minutes) const;         // Next start/end, -1 if none
+};
+
+// Time helpers shared by the CLI front-ends
+int getCurrentTimeInMinutes();
+std::string minutesToTimeString(int minutes);
+
+#endif  // SCHEDULE_H
@@ -0,0 +1,110 @@
+#include "ScheduleCache.h"
+#include "ContentHash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x43534c50;  // "PLSC"
+
+// Sidecars never leave the machine, so host byte order is fine
+template <typename T>
+void writeValue(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool readFileBytes(const std::string& filename, std::string& content) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+}  // namespace
+
+std::string ScheduleCache::sidecarPath(const std::string& dataFilename) {
+  std::filesystem::path path(dataFilename);
+  return (path.parent_path() / ("." + path.filename().string() + ".sched")).string();
+}
+
+bool ScheduleCache::store(const std::string& dataFilename, uint64_t contentHash, int dayLength,
+                          const Schedule& schedule) {
+  std::string path = sidecarPath(dataFilename);
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return false;
+    }
+
+    writeValue<uint32_t>(out, MAGIC);
+    writeValue<uint32_t>(out, VERSION);
+    writeValue<uint64_t>(out, contentHash);
+    writeValue<int32_t>(out, dayLength);
+    writeValue<uint32_t>(out, static_cast<uint32_t>(schedule.size()));
+    for (const auto& entry : schedule.getEntries()) {
+      writeValue<int32_t>(out, entry.start);
+      writeValue<int32_t>(out, entry.actLength);
+      writeValue<uint8_t>(out, (entry.fixed ? 1 : 0) | (entry.rigid ? 2 : 0));
+      writeValue<uint32_t>(out, static_cast<uint32_t>(entry.name.size()));
+      out.write(entry.name.data(), static_cast<std::streamsize>(entry.name.size()));
+    }
+    if (!out) {
+      return false;
+    }
+  }
+
+  // Rename so a concurrent reader never sees a half-written sidecar
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  return !ec;
+}
+
+bool ScheduleCache::load(const std::string& dataFilename, Schedule& schedule) {
+  std::ifstream in(sidecarPath(dataFilename), std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  uint32_t magic = 0, version = 0, count = 0;
+  uint64_t storedHash = 0;
+  int32_t dayLength = 0;
+  if (!readValue(in, magic) || magic != MAGIC || !readValue(in, version) || version != VERSION ||
+      !readValue(in, storedHash) || !readValue(in, dayLength) || !readValue(in, count)) {
+    return false;
+  }
+
+  // The hash covers dayLength too, since it is part of the file
+  std::string content;
+  if (!readFileBytes(dataFilename, content) || hashContent(content) != storedHash) {
+    return false;
+  }
+
+  Schedule loaded;
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t start = 0, actLength = 0;
+    uint8_t flags = 0;
+    uint32_t nameLength = 0;
+    if (!readValue(in, start) || !readValue(in, actLength) || !readValue(in, flags) ||
+        !readValue(in, nameLength) || nameLength > (1u << 20)) {
+      return false;
+    }
+    std::string name(nameLength, '\0');
+    if (!in.read(&name[0], nameLength)) {
+      return false;
+    }
+    loaded.addEntry({std::move(name), start, actLength, (flags & 1) != 0, (flags & 2) != 0});
+  }
+
+  schedule = std::move(loaded);
+  return true;
+}
@@ -0,0 +1,27 @@
+#ifndef SCHEDULECACHE_H
+#define SCHEDULECACHE_H
+
+#include <cstdint>
+#include <string>
+#include "Schedule.h"
+
+// Sidecar file holding the computed schedule of a data file, so the one-shot
+// CLI commands can skip JSON parsing and the ActLength/start-time pass.
+// The sidecar is only trusted when the hash of the data file's bytes and the
+// dayLength it was computed with still match.
+class ScheduleCache {
+ public:
+  // Bump whenever calcActLen/calcStartTimes change what they produce
+  static constexpr uint32_t VERSION = 1;
+
+  // data/tasks_2024-01-15.json -> data/.tasks_2024-01-15.json.sched
+  static std::string sidecarPath(const std::string& dataFilename);
+
+  static bool store(const std::string& dataFilename, uint64_t contentHash, int dayLength,
+                    const Schedule& schedule);
+
+  // Reads the data file's bytes (no parsing) to validate the sidecar
+  static bool load(const std::string& dataFilename, Schedule& schedule);
+};
+
+#endif  // SCHEDULECACHE_H
@@ -0,0 +1,218 @@
+#include "ScheduleShm.h"
+#include "Service.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace schedule_shm;
+
+namespace {
+
+// Readers give up instead of spinning forever on a writer that died mid-update
+constexpr int MAX_READ_ATTEMPTS = 1000;
+
+}  // namespace
+
+std::string getScheduleShmName(const std::string& configPath) {
+  const char* nameOverride = std::getenv("PLAN_SHM");
+  if (nameOverride && std::strlen(nameOverride) > 0) {
+    return nameOverride[0] == '/' ? nameOverride : "/" + std::string(nameOverride);
+  }
+
+  std::ostringstream name;
+  name << "/plan-" << getuid() << "-" << std::hex
+       << (std::hash<std::string>{}(configPath) & 0xffffffffu);
+  return name.str();
+}
+
+// SchedulePublisher Implementation
+SchedulePublisher::SchedulePublisher() : fd(-1), segment(nullptr), owner(false), hasPublished(false) {}
+
+SchedulePublisher::~SchedulePublisher() {
+  if (segment) {
+    ::munmap(segment, sizeof(Segment));
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+bool SchedulePublisher::open(const std::string& name) {
+  fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+  if (fd < 0) {
+    std::cerr << "Warning: Could not open shared memory " << name << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if (::ftruncate(fd, sizeof(Segment)) != 0) {
+    std::cerr << "Warning: Could not size shared memory " << name << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+
+  void* mapping = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "Warning: Could not map shared memory " << name << ": " << std::strerror(errno) << std::endl;
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+  segment = static_cast<Segment*>(mapping);
+  takeOwnership();
+  return true;
+}
+
+bool SchedulePublisher::takeOwnership() {
+  if (owner) {
+    return true;
+  }
+  // The lock goes with the owner's descriptor, so it is free again once the
+  // owner exits, even if it died mid-update
+  if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    return false;
+  }
+  owner = true;
+
+  // A fresh segment is zero-filled, which is also a valid even sequence
+  if (segment->magic != MAGIC || segment->version != VERSION) {
+    segment->version = VERSION;
+    segment->magic = MAGIC;
+  }
+  // Nobody else writes now, so an odd value is a dead owner's unfinished update
+  uint32_t seq = segment->sequence.load(std::memory_order_relaxed);
+  if (seq & 1) {
+    segment->sequence.store(seq + 1, std::memory_order_release);
+  }
+  hasPublished = false;  // What the segment shows is the previous owner's
+  return true;
+}
+
+bool SchedulePublisher::isOpen() const {
+  return segment != nullptr;
+}
+
+void SchedulePublisher::publish(const Schedule& schedule, const std::string& source) {
+  if (!segment || !takeOwnership()) {
+    return;
+  }
+  if (hasPublished && schedule == lastPublished && source == lastSource) {
+    return;
+  }
+  if (!hasPublished || source != lastSource) {
+    lastSourcePath = absolutePath(source);
+  }
+
+  // Sole writer: move the sequence from even to odd for the update
+  uint32_t writing = segment->sequence.load(std::memory_order_relaxed) + 1;
+  segment->sequence.store(writing, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint32_t count = 0;
+  uint32_t nameUsed = 0;
+  for (const auto& entry : schedule.getEntries()) {
+    if (count == MAX_ENTRIES) break;
+    uint32_t nameLength = static_cast<uint32_t>(
+        std::min<size_t>(entry.name.size(), NAME_POOL_SIZE - nameUsed));
+
+    Entry& slot = segment->entries[count++];
+    slot.start = entry.start;
+    slot.actLength = entry.actLength;
+    slot.flags = (entry.fixed ? FLAG_FIXED : 0) | (entry.rigid ? FLAG_RIGID : 0);
+    slot.nameOffset = nameUsed;
+    slot.nameLength = nameLength;
+    std::memcpy(segment->names + nameUsed, entry.name.data(), nameLength);
+    nameUsed += nameLength;
+  }
+  segment->entryCount = count;
+  segment->publishedAt = static_cast<int64_t>(std::time(nullptr));
+
+  size_t sourceLength = std::min<size_t>(lastSourcePath.size(), SOURCE_SIZE - 1);
+  std::memcpy(segment->source, lastSourcePath.data(), sourceLength);
+  segment->source[sourceLength] = '\0';
+
+  segment->sequence.store(writing + 1, std::memory_order_release);
+
+  lastPublished = schedule;
+  lastSource = source;
+  hasPublished = true;
+}
+
+// ScheduleShmReader Implementation
+ScheduleShmReader::ScheduleShmReader() : fd(-1), segment(nullptr) {}
+
+ScheduleShmReader::~ScheduleShmReader() {
+  if (segment) {
+    ::munmap(const_cast<Segment*>(segment), sizeof(Segment));
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+bool ScheduleShmReader::open(const std::string& name) {
+  fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  void* mapping = ::mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+  segment = static_cast<const Segment*>(mapping);
+  return segment->magic == MAGIC && segment->version == VERSION;
+}
+
+uint32_t ScheduleShmReader::version() const {
+  return segment ? segment->sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool ScheduleShmReader::read(Schedule& schedule, std::string* source) const {
+  if (!segment) {
+    return false;
+  }
+
+  for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+    uint32_t before = segment->sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;  // Writer in progress
+    }
+    if (before == 0) {
+      return false;  // Nothing published yet
+    }
+
+    Schedule snapshot;
+    uint32_t count = std::min(segment->entryCount, MAX_ENTRIES);
+    for (uint32_t i = 0; i < count; i++) {
+      Entry slot = segment->entries[i];
+      // Offsets may be torn mid-update; clamp so the copy stays in bounds
+      uint32_t offset = std::min(slot.nameOffset, NAME_POOL_SIZE);
+      uint32_t length = std::min(slot.nameLength, NAME_POOL_SIZE - offset);
+      snapshot.addEntry({std::string(segment->names + offset, length), slot.start, slot.actLength,
+                         (slot.flags & FLAG_FIXED) != 0, (slot.flags & FLAG_RIGID) != 0});
+    }
+    std::string sourceCopy(segment->source, strnlen(segment->source, SOURCE_SIZE));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment->sequence.load(std::memory_order_relaxed) == before) {
+      schedule = std::move(snapshot);
+      if (source) {
+        *source = std::move(sourceCopy);
+      }
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,100 @@
+#ifndef SCHEDULESHM_H
+#define SCHEDULESHM_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Schedule.h"
+
+// Layout of the POSIX shared-memory segment holding the published schedule:
+// today's, whichever process publishes it. One process writes at a time,
+// the one holding an flock on the segment. It bumps `sequence` to an odd
+// value, updates the payload and bumps it back to even; readers copy the
+// payload and retry if the value moved.
+namespace schedule_shm {
+
+constexpr uint32_t MAGIC = 0x48534c50;  // "PLSH"
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t MAX_ENTRIES = 512;
+constexpr uint32_t NAME_POOL_SIZE = 32 * 1024;
+constexpr uint32_t SOURCE_SIZE = 256;
+
+constexpr uint32_t FLAG_FIXED = 1u << 0;
+constexpr uint32_t FLAG_RIGID = 1u << 1;
+
+struct Entry {
+  int32_t start;      // Minutes since midnight
+  int32_t actLength;  // Minutes
+  uint32_t flags;     // FLAG_FIXED | FLAG_RIGID
+  uint32_t nameOffset;
+  uint32_t nameLength;
+};
+
+struct Segment {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> sequence;
+  uint32_t entryCount;
+  int64_t publishedAt;  // Unix time of the last publish
+  char source[SOURCE_SIZE];  // Absolute path of the data file the schedule was computed from
+  Entry entries[MAX_ENTRIES];
+  char names[NAME_POOL_SIZE];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "seqlock counter must be lock-free to live in shared memory");
+
+}  // namespace schedule_shm
+
+// Segment name for a config file; $PLAN_SHM overrides it
+std::string getScheduleShmName(const std::string& configPath);
+
+// Writer side, used by the interactive session and the daemon. Only the
+// first of them to publish owns the segment; the other publishes nothing
+// until the owner exits and releases it.
+class SchedulePublisher {
+ private:
+  int fd;
+  schedule_shm::Segment* segment;
+  bool owner;  // Holds the segment's flock
+  Schedule lastPublished;
+  std::string lastSource;
+  std::string lastSourcePath;  // lastSource as an absolute path, as it goes in the segment
+  bool hasPublished;
+
+  bool takeOwnership();
+
+ public:
+  SchedulePublisher();
+  ~SchedulePublisher();
+  SchedulePublisher(const SchedulePublisher&) = delete;
+  SchedulePublisher& operator=(const SchedulePublisher&) = delete;
+
+  bool open(const std::string& name);
+  bool isOpen() const;
+  // Publish unless the same schedule from the same file is already visible,
+  // or another process owns the segment. source is stored as an absolute
+  // path, so readers in any directory can tell whether it is their file.
+  void publish(const Schedule& schedule, const std::string& source);
+};
+
+// Reader side: after open() every call is plain memory access, no syscalls
+class ScheduleShmReader {
+ private:
+  int fd;
+  const schedule_shm::Segment* segment;
+
+ public:
+  ScheduleShmReader();
+  ~ScheduleShmReader();
+  ScheduleShmReader(const ScheduleShmReader&) = delete;
+  ScheduleShmReader& operator=(const ScheduleShmReader&) = delete;
+
+  bool open(const std::string& name);
+  // Changes whenever a new schedule is published; poll this to skip re-reads
+  uint32_t version() const;
+  // Copy a consistent snapshot; false if nothing usable is published
+  bool read(Schedule& schedule, std::string* source = nullptr) const;
+};
+
+#endif  // SCHEDULESHM_H
@@ -0,0 +1,279 @@
+#include "SearchIndex.h"
+#include "ColumnStore.h"
+#include "ContentHash.h"
+#include "UndoLog.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x49534c50;  // "PLSI"
+
+// Header: u32 magic, u32 version, u64 checksum of the rest, u64 generation,
+// u64 term count, u64 postings bytes. Then per term its token (u32 length
+// and bytes), u32 posting count and u64 posting bytes, then the postings.
+constexpr size_t HEADER_SIZE = 40;
+
+template <typename T>
+void append(std::string& buffer, T value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(const std::string& data, size_t& position, T& value) {
+  if (data.size() - position < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, data.data() + position, sizeof(T));
+  position += sizeof(T);
+  return true;
+}
+
+uint64_t postingKey(int64_t day, uint32_t position) {
+  return (static_cast<uint64_t>(day + INT32_MAX + 1) << 32) | position;
+}
+
+}  // namespace
+
+std::string SearchIndex::indexPath(const std::string& dataDir) {
+  return (std::filesystem::path(dataDir) / ".search.idx").string();
+}
+
+std::vector<std::string> SearchIndex::tokenize(const std::string& text) {
+  std::vector<std::string> tokens;
+  std::string token;
+  for (char c : text) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    if (byte >= 0x80 || std::isalnum(byte)) {
+      token += static_cast<char>(std::tolower(byte));
+    } else if (!token.empty()) {
+      tokens.push_back(std::move(token));
+      token.clear();
+    }
+  }
+  if (!token.empty()) {
+    tokens.push_back(std::move(token));
+  }
+  return tokens;
+}
+
+SearchIndex::SearchIndex(const std::string& path) : path(path), generation(0) {}
+
+bool SearchIndex::load(uint64_t expected) {
+  terms.clear();
+  postings.clear();
+  generation = 0;
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return false;
+  }
+  std::string data(static_cast<size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  if (!file.read(data.data(), data.size()) || data.size() < HEADER_SIZE) {
+    return false;
+  }
+
+  size_t position = 0;
+  uint32_t magic = 0, version = 0;
+  uint64_t checksum = 0, stamp = 0, termTotal = 0, postingBytes = 0;
+  get(data, position, magic);
+  get(data, position, version);
+  get(data, position, checksum);
+  get(data, position, stamp);
+  get(data, position, termTotal);
+  get(data, position, postingBytes);
+  if (magic != MAGIC || version != VERSION || stamp != expected || expected == 0 ||
+      checksum != hashContent(data.data() + 16, data.size() - 16)) {
+    return false;
+  }
+
+  uint64_t offset = 0;
+  std::vector<Term> loaded;
+  for (uint64_t i = 0; i < termTotal; ++i) {
+    uint32_t tokenLength = 0;
+    if (!get(data, position, tokenLength) || data.size() - position < tokenLength) {
+      return false;
+    }
+    Term term{data.substr(position, tokenLength), 0, offset, 0};
+    position += tokenLength;
+    if (!get(data, position, term.count) || !get(data, position, term.length) || term.length > postingBytes - offset) {
+      return false;
+    }
+    offset += term.length;
+    loaded.push_back(std::move(term));
+  }
+  if (offset != postingBytes || data.size() - position != postingBytes) {
+    return false;
+  }
+
+  terms = std::move(loaded);
+  postings = data.substr(position);
+  generation = expected;
+  return true;
+}
+
+void SearchIndex::build(const ColumnStore& store) {
+  // Tokens once per name; a name repeating a token posts it once
+  std::unordered_map<std::string, uint32_t> termIds;
+  std::vector<std::vector<uint32_t>> nameTerms;
+  std::vector<std::string> tokens;
+  for (const std::string& name : store.getNames()) {
+    std::vector<uint32_t> ids;
+    for (const std::string& token : tokenize(name)) {
+      auto [it, added] = termIds.emplace(token, static_cast<uint32_t>(tokens.size()));
+      if (added) {
+        tokens.push_back(token);
+      }
+      if (std::find(ids.begin(), ids.end(), it->second) == ids.end()) {
+        ids.push_back(it->second);
+      }
+    }
+    nameTerms.push_back(std::move(ids));
+  }
+
+  struct List {
+    HistoryWriter out;
+    int64_t lastDay = 0;
+    uint32_t count = 0;
+  };
+  std::vector<List> lists(tokens.size());
+  store.forEachDay([&](int32_t day, const uint32_t* nameIds, size_t count) {
+    for (size_t position = 0; position < count; ++position) {
+      for (uint32_t id : nameTerms[nameIds[position]]) {
+        List& list = lists[id];
+        if (list.count == 0) {
+          list.out.writeSigned(day);
+        } else {
+          list.out.writeVarint(static_cast<uint64_t>(day - list.lastDay));
+        }
+        list.out.writeVarint(position);
+        list.lastDay = day;
+        ++list.count;
+      }
+    }
+  });
+
+  std::vector<uint32_t> order(tokens.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return tokens[a] < tokens[b]; });
+
+  terms.clear();
+  postings.clear();
+  for (uint32_t id : order) {
+    if (lists[id].count == 0) {
+      continue;  // Only on shadowed days
+    }
+    const std::string& bytes = lists[id].out.data();
+    terms.push_back({tokens[id], lists[id].count, postings.size(), bytes.size()});
+    postings += bytes;
+  }
+  generation = store.generation();
+}
+
+bool SearchIndex::save() const {
+  std::string body;
+  append<uint64_t>(body, generation);
+  append<uint64_t>(body, terms.size());
+  append<uint64_t>(body, postings.size());
+  for (const Term& term : terms) {
+    append<uint32_t>(body, static_cast<uint32_t>(term.token.size()));
+    body += term.token;
+    append<uint32_t>(body, term.count);
+    append<uint64_t>(body, term.length);
+  }
+  body += postings;
+
+  std::string header;
+  append<uint32_t>(header, MAGIC);
+  append<uint32_t>(header, VERSION);
+  append<uint64_t>(header, hashContent(body));
+
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(header.data(), header.size()) || !file.write(body.data(), body.size())) {
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  return !ec;
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::search(const std::string& query, size_t& days) const {
+  // (posting key, score) pairs in key order, i.e. oldest first; each term's
+  // own list is already in that order
+  using Scored = std::vector<std::pair<uint64_t, uint32_t>>;
+  Scored scores;
+  bool first = true;
+  for (const std::string& queryTerm : tokenize(query)) {
+    // Best score of this term per posting, over every token it prefixes
+    Scored matched;
+    size_t lists = 0;
+    auto term = std::lower_bound(terms.begin(), terms.end(), queryTerm,
+                                 [](const Term& term, const std::string& value) { return term.token < value; });
+    for (; term != terms.end() && term->token.compare(0, queryTerm.size(), queryTerm) == 0; ++term, ++lists) {
+      uint32_t score = term->token.size() == queryTerm.size() ? 2 : 1;
+      HistoryReader reader(std::string_view(postings).substr(term->offset, term->length), nullptr, nullptr);
+      int64_t day = 0;
+      for (uint32_t i = 0; i < term->count && reader.ok(); ++i) {
+        day = i == 0 ? reader.readSigned() : day + static_cast<int64_t>(reader.readVarint());
+        uint32_t position = static_cast<uint32_t>(reader.readVarint());
+        matched.emplace_back(postingKey(day, position), score);
+      }
+    }
+    if (lists > 1) {
+      std::sort(matched.begin(), matched.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : a.second > b.second;
+      });
+      matched.erase(std::unique(matched.begin(), matched.end(),
+                                [](const auto& a, const auto& b) { return a.first == b.first; }),
+                    matched.end());
+    }
+
+    if (first) {
+      scores = std::move(matched);
+      first = false;
+    } else {
+      Scored both;
+      auto left = scores.begin();
+      for (const auto& [key, score] : matched) {
+        while (left != scores.end() && left->first < key) {
+          ++left;
+        }
+        if (left != scores.end() && left->first == key) {
+          both.emplace_back(key, left->second + score);
+        }
+      }
+      scores = std::move(both);
+    }
+    if (scores.empty()) {
+      break;
+    }
+  }
+
+  // Newest first, then by score; the sort is stable so ties stay newest first
+  std::vector<Hit> hits;
+  hits.reserve(scores.size());
+  days = 0;
+  for (auto it = scores.rbegin(); it != scores.rend(); ++it) {
+    uint32_t position = static_cast<uint32_t>(it->first);
+    hits.push_back({static_cast<int64_t>(it->first >> 32) - INT32_MAX - 1, position, it->second});
+    days += hits.size() == 1 || hits.back().day != hits[hits.size() - 2].day;
+  }
+  std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.score > b.score; });
+  return hits;
+}
+
+size_t SearchIndex::termCount() const {
+  return terms.size();
+}
@@ -0,0 +1,67 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ColumnStore;
+
+// Inverted index over the task names of every day on record, for `plan
+// search` and the TUI's `/`. Names are split into lowercase tokens; each
+// token keeps a posting list of (date, position in the day) entries, oldest
+// first, as varints: the first date zigzag, then date deltas, each followed
+// by the position. A lookup decodes only the lists of the tokens a query
+// term is a prefix of.
+//
+// The index lives in data/.search.idx and is derived from the column store
+// (data/.stats.cols), which is what reads and tracks the day files, packs
+// and archive. It is stamped with the store's generation and rebuilt from
+// its columns when that changes; tokenizing happens once per distinct name,
+// so a rebuild over years of history is a pass over one column.
+class SearchIndex {
+ public:
+  // Bump whenever the file layout or the tokenizer changes
+  static constexpr uint32_t VERSION = 1;
+
+  struct Hit {
+    int64_t day;  // Days since 1970-01-01
+    uint32_t position;
+    uint32_t score;  // 2 per query term matching a whole token, 1 per prefix match
+  };
+
+  // data-dir/.search.idx
+  static std::string indexPath(const std::string& dataDir);
+
+  // Lowercase runs of letters and digits; bytes of multi-byte UTF-8
+  // characters count as letters, so accented names stay whole
+  static std::vector<std::string> tokenize(const std::string& text);
+
+  explicit SearchIndex(const std::string& path);
+
+  // False if missing, damaged or built from another generation of the rows
+  bool load(uint64_t generation);
+  void build(const ColumnStore& store);
+  bool save() const;
+
+  // Tasks whose name has, for every term of the query, a token starting with
+  // it; best score first, then newest. days counts the distinct days.
+  std::vector<Hit> search(const std::string& query, size_t& days) const;
+
+  size_t termCount() const;
+
+ private:
+  struct Term {
+    std::string token;
+    uint32_t count;    // Postings
+    uint64_t offset;   // Into postings
+    uint64_t length;
+  };
+
+  std::string path;
+  uint64_t generation;
+  std::vector<Term> terms;  // Sorted by token
+  std::string postings;
+};
+
+#endif  // SEARCHINDEX_H
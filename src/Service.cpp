@@ -0,0 +1,121 @@
+#include "Service.h"
+#include "Config.h"
+
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+volatile std::sig_atomic_t stopFlag = 0;
+
+void handleStopSignal(int) {
+  stopFlag = 1;
+}
+
+}  // namespace
+
+void installStopHandler() {
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = handleStopSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+}
+
+bool stopRequested() {
+  return stopFlag != 0;
+}
+
+std::string directoryOf(const std::string& filename) {
+  std::string dir = std::filesystem::path(filename).parent_path().string();
+  return dir.empty() ? "." : dir;
+}
+
+std::string absolutePath(const std::string& filename) {
+  std::error_code ec;
+  std::filesystem::path path = std::filesystem::absolute(filename, ec);
+  if (!ec) {
+    path = std::filesystem::weakly_canonical(path, ec);
+  }
+  return ec ? filename : path.string();
+}
+
+void reloadConfigFile(Config& config, const std::string& configPath) {
+  config = Config(configPath);
+  config.loadFromFile();
+}
+
+// DirectoryWatcher Implementation
+DirectoryWatcher::DirectoryWatcher() : fd(-1) {}
+
+DirectoryWatcher::~DirectoryWatcher() {
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+bool DirectoryWatcher::open() {
+#ifdef __linux__
+  fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+  return fd >= 0;
+}
+
+int DirectoryWatcher::getFd() const {
+  return fd;
+}
+
+bool DirectoryWatcher::isWatched(const std::string& dir) const {
+  for (const auto& entry : watchedDirs) {
+    if (entry.second == dir) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DirectoryWatcher::watch(const std::string& dir) {
+  if (isWatched(dir)) {
+    return true;
+  }
+#ifdef __linux__
+  if (fd >= 0) {
+    int wd = ::inotify_add_watch(fd, dir.c_str(),
+                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE);
+    if (wd >= 0) {
+      watchedDirs[wd] = dir;
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+void DirectoryWatcher::drain(const Visitor& visit) {
+#ifdef __linux__
+  if (fd < 0) {
+    return;
+  }
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    ssize_t len = ::read(fd, buffer, sizeof(buffer));
+    if (len <= 0) break;
+
+    for (char* ptr = buffer; ptr < buffer + len;) {
+      auto* event = reinterpret_cast<inotify_event*>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+
+      auto dir = watchedDirs.find(event->wd);
+      if (dir == watchedDirs.end() || event->len == 0) continue;
+      visit(dir->second, event->name);
+    }
+  }
+#else
+  (void)visit;
+#endif
+}
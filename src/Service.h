@@ -0,0 +1,51 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <functional>
+#include <map>
+#include <string>
+
+class Config;
+
+// Plumbing shared by the long-running commands, `plan daemon` and `plan watch`
+
+// Make SIGINT/SIGTERM set stopRequested() instead of killing the process
+void installStopHandler();
+bool stopRequested();
+
+// Directory holding filename, "." for a bare name
+std::string directoryOf(const std::string& filename);
+
+// filename as an absolute path with symlinks, "." and ".." resolved, so
+// processes started in different directories name a file the same way
+std::string absolutePath(const std::string& filename);
+
+// Read the config file again over config
+void reloadConfigFile(Config& config, const std::string& configPath);
+
+// inotify watches on whole directories. Watching the directory rather than
+// the file keeps working when a file is replaced by rename or created later.
+class DirectoryWatcher {
+ public:
+  using Visitor = std::function<void(const std::string& dir, const std::string& name)>;
+
+ private:
+  int fd;
+  std::map<int, std::string> watchedDirs;  // inotify watch descriptor -> directory
+
+ public:
+  DirectoryWatcher();
+  ~DirectoryWatcher();
+  DirectoryWatcher(const DirectoryWatcher&) = delete;
+  DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+  bool open();  // False where inotify is unavailable
+  int getFd() const;  // For poll(); -1 if not open
+  bool isWatched(const std::string& dir) const;
+  bool watch(const std::string& dir);  // False if dir cannot be watched
+  // Read every queued event: visit(directory, name) for each file created,
+  // written, moved or deleted in a watched directory
+  void drain(const Visitor& visit);
+};
+
+#endif  // SERVICE_H
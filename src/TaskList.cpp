@@ -0,0 +1,196 @@
+#include "TaskList.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+TaskList::TaskList() : root(emptySpine()) {}
+
+const std::shared_ptr<TaskList::Spine>& TaskList::emptySpine() {
+  static const std::shared_ptr<Spine> empty = std::make_shared<Spine>();
+  return empty;
+}
+
+TaskList::Spine& TaskList::mutableSpine() {
+  if (root.use_count() > 1) {
+    root = std::make_shared<Spine>(*root);
+  }
+  return *root;
+}
+
+TaskList::Chunk& TaskList::mutableChunk(size_t chunkIndex) {
+  auto& chunk = mutableSpine().chunks[chunkIndex];
+  if (chunk.use_count() > 1) {
+    chunk = std::make_shared<Chunk>(*chunk);
+  }
+  return *chunk;
+}
+
+std::pair<size_t, size_t> TaskList::locate(size_t index) const {
+  const auto& chunks = root->chunks;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (index < chunks[i]->size()) {
+      return {i, index};
+    }
+    index -= chunks[i]->size();
+  }
+  if (index == 0 && !chunks.empty()) {
+    return {chunks.size() - 1, chunks.back()->size()};
+  }
+  throw std::out_of_range("TaskList index out of range");
+}
+
+size_t TaskList::size() const {
+  return root->size;
+}
+
+bool TaskList::empty() const {
+  return root->size == 0;
+}
+
+const Act& TaskList::operator[](size_t index) const {
+  auto position = locate(index);
+  return (*root->chunks[position.first])[position.second];
+}
+
+Act& TaskList::operator[](size_t index) {
+  auto position = locate(index);
+  return mutableChunk(position.first)[position.second];
+}
+
+void TaskList::push_back(const Act& task) {
+  Spine& spine = mutableSpine();
+  if (spine.chunks.empty() || spine.chunks.back()->size() >= CHUNK_SIZE) {
+    spine.chunks.push_back(std::make_shared<Chunk>());
+    spine.chunks.back()->reserve(CHUNK_SIZE);
+  }
+  mutableChunk(spine.chunks.size() - 1).push_back(task);
+  spine.size++;
+}
+
+void TaskList::insert(size_t index, const Act& task) {
+  if (index > size()) {
+    throw std::out_of_range("TaskList index out of range");
+  }
+  if (index == size()) {
+    push_back(task);
+    return;
+  }
+
+  auto position = locate(index);
+  Chunk& chunk = mutableChunk(position.first);
+  chunk.insert(chunk.begin() + position.second, task);
+
+  Spine& spine = mutableSpine();
+  spine.size++;
+
+  // Split an overfull chunk so edits never copy more than 2 * CHUNK_SIZE tasks
+  if (chunk.size() > 2 * CHUNK_SIZE) {
+    auto tail = std::make_shared<Chunk>(chunk.begin() + CHUNK_SIZE, chunk.end());
+    chunk.erase(chunk.begin() + CHUNK_SIZE, chunk.end());
+    spine.chunks.insert(spine.chunks.begin() + position.first + 1, std::move(tail));
+  }
+}
+
+void TaskList::erase(size_t index) {
+  if (index >= size()) {
+    throw std::out_of_range("TaskList index out of range");
+  }
+
+  auto position = locate(index);
+  Chunk& chunk = mutableChunk(position.first);
+  chunk.erase(chunk.begin() + position.second);
+
+  Spine& spine = mutableSpine();
+  spine.size--;
+  if (chunk.empty()) {
+    spine.chunks.erase(spine.chunks.begin() + position.first);
+  }
+}
+
+void TaskList::clear() {
+  root = emptySpine();
+}
+
+TaskList::const_iterator TaskList::begin() const {
+  return const_iterator(root.get(), 0, 0);
+}
+
+TaskList::const_iterator TaskList::end() const {
+  return const_iterator(root.get(), root->chunks.size(), 0);
+}
+
+std::vector<Act> TaskList::toVector() const {
+  std::vector<Act> tasks;
+  tasks.reserve(size());
+  for (const auto& chunk : root->chunks) {
+    tasks.insert(tasks.end(), chunk->begin(), chunk->end());
+  }
+  return tasks;
+}
+
+bool TaskList::sharesRoot(const TaskList& other) const {
+  return root == other.root;
+}
+
+void TaskList::forEachUnshared(const TaskList& other, const std::function<void(size_t)>& visit) const {
+  const auto& chunks = root->chunks;
+  const auto& otherChunks = other.root->chunks;
+  bool sameLayout = chunks.size() == otherChunks.size();
+  for (size_t i = 0; sameLayout && i < chunks.size(); i++) {
+    sameLayout = chunks[i]->size() == otherChunks[i]->size();
+  }
+  if (!sameLayout) {
+    for (size_t position = 0; position < std::min(size(), other.size()); position++) {
+      visit(position);
+    }
+    return;
+  }
+
+  size_t position = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (chunks[i] != otherChunks[i]) {
+      for (size_t offset = 0; offset < chunks[i]->size(); offset++) {
+        visit(position + offset);
+      }
+    }
+    position += chunks[i]->size();
+  }
+}
+
+size_t TaskList::getMemoryFootprint() const {
+  size_t bytes = sizeof(Spine) + root->chunks.capacity() * sizeof(std::shared_ptr<Chunk>);
+  for (const auto& chunk : root->chunks) {
+    bytes += sizeof(Chunk) + chunk->capacity() * sizeof(Act);
+    for (const Act& task : *chunk) {
+      bytes += task.getHeapBytes();
+    }
+  }
+  return bytes;
+}
+
+TaskList::const_iterator::const_iterator(const Spine* spine, size_t chunk, size_t offset)
+    : spine(spine), chunk(chunk), offset(offset) {}
+
+TaskList::const_iterator::reference TaskList::const_iterator::operator*() const {
+  return (*spine->chunks[chunk])[offset];
+}
+
+TaskList::const_iterator::pointer TaskList::const_iterator::operator->() const {
+  return &**this;
+}
+
+TaskList::const_iterator& TaskList::const_iterator::operator++() {
+  if (++offset == spine->chunks[chunk]->size()) {
+    chunk++;
+    offset = 0;
+  }
+  return *this;
+}
+
+bool TaskList::const_iterator::operator==(const const_iterator& other) const {
+  return spine == other.spine && chunk == other.chunk && offset == other.offset;
+}
+
+bool TaskList::const_iterator::operator!=(const const_iterator& other) const {
+  return !(*this == other);
+}
@@ -0,0 +1,94 @@
+#ifndef TASKLIST_H
+#define TASKLIST_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "Act.h"
+
+// Persistent list of tasks. Tasks live in chunks of up to 2 * CHUNK_SIZE
+// hung off a shared spine; copying a TaskList only copies the root pointer,
+// so a copy is an O(1) snapshot that later edits never disturb.
+//
+// Writes copy-on-write whatever is still shared with a snapshot: the spine
+// (one pointer per chunk) and the chunk holding the task, nothing else. A
+// list nobody snapshotted is edited in place.
+//
+// References returned by the non-const operator[] stay valid until the next
+// insert/erase or until a snapshot is taken; code that takes a snapshot in
+// between must look the task up again.
+class TaskList {
+ public:
+  static constexpr size_t CHUNK_SIZE = 32;
+
+ private:
+  using Chunk = std::vector<Act>;
+  struct Spine {
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t size = 0;
+  };
+
+  std::shared_ptr<Spine> root;
+
+  // Shared by every empty list, so making one allocates nothing
+  static const std::shared_ptr<Spine>& emptySpine();
+  Spine& mutableSpine();
+  Chunk& mutableChunk(size_t chunkIndex);
+  // Chunk index and offset inside it of the task at `index` (index == size()
+  // yields the end of the last chunk)
+  std::pair<size_t, size_t> locate(size_t index) const;
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Act;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Act*;
+    using reference = const Act&;
+
+    const_iterator(const Spine* spine, size_t chunk, size_t offset);
+    reference operator*() const;
+    pointer operator->() const;
+    const_iterator& operator++();
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+   private:
+    const Spine* spine;
+    size_t chunk;
+    size_t offset;
+  };
+
+  TaskList();
+
+  size_t size() const;
+  bool empty() const;
+  const Act& operator[](size_t index) const;
+  Act& operator[](size_t index);
+
+  void push_back(const Act& task);
+  void insert(size_t index, const Act& task);
+  void erase(size_t index);
+  void clear();
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  std::vector<Act> toVector() const;
+
+  // True when both lists are the same version (one is an unmodified copy of the other)
+  bool sharesRoot(const TaskList& other) const;
+
+  // visit(position) for every task not in a chunk shared with `other`, an
+  // earlier version of this list with its tasks edited in place; every
+  // position if the two are laid out differently
+  void forEachUnshared(const TaskList& other, const std::function<void(size_t)>& visit) const;
+
+  // Bytes the list would hold on its own: the spine and every chunk, shared
+  // ones included, since edits to the other holders copy them away
+  size_t getMemoryFootprint() const;
+};
+
+#endif  // TASKLIST_H
@@ -1,6 +1,13 @@
 #include "TaskManager.h"
 #include "Config.h"
 #include "UndoManager.h"
+#include "Schedule.h"
+#include "ScheduleCache.h"
+#include "UndoLog.h"
+#include "ContentHash.h"
+#include "ArchiveStore.h"
+#include "PackStore.h"
+#include "DateRange.h"
 
 #include <iostream>
 #include <fstream>
@@ -12,17 +19,92 @@
 #include <algorithm>
 #include <unistd.h>
 #include <chrono>
+#include <iterator>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-TaskManager::TaskManager(int dl) : dayLength(dl), config(nullptr), undoManager(std::make_unique<UndoManager>()) {}
+namespace {
 
-TaskManager::TaskManager(Config* cfg) : config(cfg), undoManager(std::make_unique<UndoManager>()) {
+// Schedule exactly as `plan now/list` computes it after loading these tasks
+// from disk, independent of any in-memory state of the current session
+Schedule scheduleForSavedTasks(const TaskList& tasks, int dayLength) {
+  TaskManager fresh(dayLength);
+  for (const auto& task : tasks) {
+    if (task.isFixed()) {
+      fresh.addTask(task.getName(), task.getStartStr(), task.getLength(), task.isRigid());
+    } else {
+      fresh.addTask(task.getName(), task.getLength(), task.isRigid());
+    }
+  }
+  if (fresh.taskSize() > 0) {
+    fresh.calcActLen();
+    fresh.calcStartTimes();
+  }
+  return Schedule(fresh.getTasks());
+}
+
+// Key for a data file's history: one file reached through different paths is one history
+std::string historyKey(const std::string& filename) {
+  std::error_code ec;
+  std::filesystem::path absolute = std::filesystem::absolute(filename, ec);
+  return ec ? filename : absolute.lexically_normal().string();
+}
+
+// Whether two lists hold the same tasks as far as a data file records them;
+// start times of flexible tasks are recomputed, so they do not count
+bool sameSavedTasks(const TaskList& a, const TaskList& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    const Act& x = a[i];
+    const Act& y = b[i];
+    if (x.getId() != y.getId() || x.getName() != y.getName() || x.getLength() != y.getLength() ||
+        x.isRigid() != y.isRigid() || x.isFixed() != y.isFixed() ||
+        (x.isFixed() && x.getStartStr() != y.getStartStr())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Name of the archive `plan archive` compacts old days into, inside the data directory
+std::string archiveFileName(const Config* config) {
+  return config ? config->getString("archive-file", "archive.plan") : "archive.plan";
+}
+
+// Date of a tasks_YYYY-MM-DD<extension> data file; false for any other name
+bool dayOfDataFile(const std::filesystem::path& path, const Config* config, std::string& date) {
+  std::string name = path.filename().string();
+  std::string extension = config ? config->getString("file-extension", ".json") : ".json";
+  int64_t day = 0;
+  if (name.size() != 6 + 10 + extension.size() || name.compare(0, 6, "tasks_") != 0 ||
+      name.compare(16, std::string::npos, extension) != 0 || !DateRange::toDayNumber(name.substr(6, 10), day)) {
+    return false;
+  }
+  date = name.substr(6, 10);
+  return true;
+}
+
+}  // namespace
+
+TaskManager::TaskManager(int dl)
+    : dayLength(dl), config(nullptr), undoManager(std::make_unique<UndoManager>()), loadedContentHash(0),
+      loadedFromArchive(false), quietLoad(false), recalcDepth(0), recalcPending(false), nextTaskId(1), parkedHistoryBytes(0),
+      parkedHistoryBudget(DEFAULT_HISTORY_CACHE_BYTES) {}
+
+TaskManager::TaskManager(Config* cfg)
+    : config(cfg), loadedContentHash(0), loadedFromArchive(false), quietLoad(false), recalcDepth(0), recalcPending(false), nextTaskId(1),
+      parkedHistoryBytes(0), parkedHistoryBudget(DEFAULT_HISTORY_CACHE_BYTES) {
+  undoManager = createUndoManager();
   if (config) {
     // Get day length from config (convert hours to minutes)
     double hours = config->getDouble("default-day-length", 7.0);
     dayLength = static_cast<int>(hours * 60);
+
+    int cacheBytes = config->getInt("undo-cache-bytes", static_cast<int>(DEFAULT_HISTORY_CACHE_BYTES));
+    parkedHistoryBudget = static_cast<size_t>(std::max(cacheBytes, 0));
   } else {
     dayLength = 7 * 60; // Default fallback
   }
@@ -32,13 +114,13 @@ void TaskManager::addTask(const std::string &name, std::string start,
                           int length,
                           bool isRigid) {  // fixed
   Act newTask(name, start, length, isRigid);
-  tasks.push_back(newTask);
+  insertTaskAt(tasks.size(), newTask);
 }
 
 void TaskManager::addTask(const std::string &name, int length,
                           bool isRigid) {  // flexible
   Act newTask(name, length, isRigid);
-  tasks.push_back(newTask);
+  insertTaskAt(tasks.size(), newTask);
 }
 
 void TaskManager::insertTask(int index, const std::string &name, std::string start,
@@ -58,7 +140,37 @@ void TaskManager::insertTaskAt(size_t index, Act &newTask) {
     std::cout << "Index out of bounds. Task not added." << std::endl;
     return;
   }
-  tasks.insert(tasks.begin() + index, newTask);
+
+  // Keep an id the task already carries (undo re-inserting a deleted task,
+  // ids loaded from disk) unless another task has it
+  if (newTask.getId() == 0 || taskPositions.count(newTask.getId()) > 0) {
+    newTask.setId(nextTaskId++);
+  } else {
+    nextTaskId = std::max(nextTaskId, newTask.getId() + 1);
+  }
+
+  tasks.insert(index, newTask);
+  reindexFrom(index);
+}
+
+void TaskManager::reindexFrom(size_t position) {
+  const TaskList& list = tasks;
+  for (size_t i = position; i < list.size(); i++) {
+    taskPositions[list[i].getId()] = i;
+  }
+}
+
+int TaskManager::getTaskIndex(uint64_t id) const {
+  auto it = taskPositions.find(id);
+  return it != taskPositions.end() ? static_cast<int>(it->second) : -1;
+}
+
+uint64_t TaskManager::getTaskId(int index) const {
+  if (index < 0 || index >= static_cast<int>(tasks.size())) {
+    return 0;
+  }
+  const TaskList& list = tasks;
+  return list[index].getId();
 }
 
 void TaskManager::beginAt(size_t index) {
@@ -70,23 +182,51 @@ void TaskManager::beginAt(size_t index) {
 }
 
 void TaskManager::calcStartTimes() {
-  if (tasks.empty()) return;
-
-  for (auto i = 0; i < tasks.size(); i++) {
-    if (!tasks[i].isFixed()) {
-      if (i == 0) {
-        // First task starts at default time if not fixed
-        tasks[i].setStartTime("09:00");
-      } else {
-        tasks[i].setStartTime(tasks[i - 1].getStartInt() +
-                              tasks[i - 1].getActLength());
+  // Read through the const list and write only the starts that moved, so a
+  // pass leaves the chunks it shares with undo snapshots alone
+  const TaskList& list = tasks;
+  for (size_t i = 0; i < list.size(); i++) {
+    if (!list[i].isFixed()) {
+      // First task starts at default time if not fixed
+      int start = i == 0 ? DAY_START : list[i - 1].getStartInt() + list[i - 1].getActLength();
+      if (list[i].getStartInt() != start || list[i].getStartStr() != Act::minutesToTime(start)) {
+        tasks[i].setStartTime(start);
       }
     }
   }
+
+  // Every command finishes with this pass, so the schedule is final here
+  if (scheduleListener) {
+    scheduleListener(tasks.toVector());
+  }
+}
+
+void TaskManager::recalculate() {
+  if (recalcDepth > 0) {
+    recalcPending = true;
+    return;
+  }
+  calcActLen();
+  calcStartTimes();
+}
+
+TaskManager::RecalcScope::RecalcScope(TaskManager& mgr) : manager(mgr) {
+  manager.recalcDepth++;
+}
+
+TaskManager::RecalcScope::~RecalcScope() {
+  if (--manager.recalcDepth == 0 && manager.recalcPending) {
+    manager.recalcPending = false;
+    manager.recalculate();
+  }
+}
+
+void TaskManager::setScheduleListener(ScheduleListener listener) {
+  scheduleListener = std::move(listener);
 }
 
 void TaskManager::displayAllTasks() {
-  for (auto &task : tasks) {
+  for (const auto& task : tasks) {
     task.displayTask();
   }
 }
@@ -99,42 +239,42 @@ void TaskManager::calcActLen() {
 std::vector<std::string> TaskManager::calcActLen(bool& hasWarnings) {
   std::vector<std::string> warnings;
   hasWarnings = false;
+  const TaskList& list = tasks;  // Reads must not copy chunks shared with undo snapshots
 
-  for (int i = 0; i < tasks.size() - 1; i++) {
-    if (tasks[i + 1].isFixed()) {
-      int calculatedActLen = tasks[i + 1].getStartInt() - tasks[i].getStartInt();
-
-      // Check for negative ActLength (time conflict)
-      if (calculatedActLen < 0) {
-        std::string warning = "Time conflict: Task '" + tasks[i].getName() +
-                             "' (starts " + tasks[i].getStartStr() +
-                             ") conflicts with '" + tasks[i + 1].getName() +
-                             "' (starts " + tasks[i + 1].getStartStr() +
-                             "). ActLength set to 0.";
-        warnings.push_back(warning);
-        hasWarnings = true;
-
-        // Set ActLength to 0 to prevent negative values
-        tasks[i].setActLen(0);
-      } else {
-        tasks[i].setActLen(calculatedActLen);
-      }
-
-      tasks[i].setFrozenLen(tasks[i].getActLength());
-      tasks[i].toggleFrozen();
+  // A task followed by a fixed one is frozen to the gap before it (-1: not frozen)
+  std::vector<int> frozenLengths(list.size(), -1);
+  for (size_t i = 0; i + 1 < list.size(); i++) {
+    if (!list[i + 1].isFixed()) {
+      continue;
+    }
+    int calculatedActLen = list[i + 1].getStartInt() - list[i].getStartInt();
+
+    // Check for negative ActLength (time conflict)
+    if (calculatedActLen < 0) {
+      std::string warning = "Time conflict: Task '" + list[i].getName() +
+                           "' (starts " + list[i].getStartStr() +
+                           ") conflicts with '" + list[i + 1].getName() +
+                           "' (starts " + list[i + 1].getStartStr() +
+                           "). ActLength set to 0.";
+      warnings.push_back(warning);
+      hasWarnings = true;
+
+      // Set ActLength to 0 to prevent negative values
+      calculatedActLen = 0;
     }
+    frozenLengths[i] = calculatedActLen;
   }
 
   int totalRigid = 0;
   int totalFlexible = 0;
 
-  for (auto &task : tasks) {
-    if (task.isRigid()) {
-      totalRigid += task.getLength();
-    } else if (task.isFrozen()) {
-      totalRigid += task.getActLength();
+  for (size_t i = 0; i < list.size(); i++) {
+    if (list[i].isRigid()) {
+      totalRigid += list[i].getLength();
+    } else if (frozenLengths[i] >= 0) {
+      totalRigid += frozenLengths[i];
     } else {
-      totalFlexible += task.getLength();
+      totalFlexible += list[i].getLength();
     }
   }
 
@@ -144,8 +284,22 @@ std::vector<std::string> TaskManager::calcActLen(bool& hasWarnings) {
     ratio = static_cast<double>(remainLen) / totalFlexible;
   }
 
-  for (auto &task : tasks) {
-    task.setActLen(ratio);
+  // Only tasks whose lengths changed are written
+  for (size_t i = 0; i < list.size(); i++) {
+    const Act& task = list[i];
+    bool frozen = frozenLengths[i] >= 0;
+    int actLength = task.isRigid() ? task.getLength()
+                    : frozen       ? frozenLengths[i]
+                                   : static_cast<int>(task.getLength() * ratio);
+    if (task.isFrozen() != frozen || task.getActLength() != actLength ||
+        (frozen && task.getFrozenLength() != frozenLengths[i])) {
+      Act& changed = tasks[i];
+      changed.setFrozen(frozen);
+      if (frozen) {
+        changed.setFrozenLen(frozenLengths[i]);
+      }
+      changed.setActLen(actLength);
+    }
   }
 
   return warnings;
@@ -155,10 +309,21 @@ Act TaskManager::getTask(int index) {
   if (index < 0 || index >= tasks.size()) {
     throw std::out_of_range("Index out of range");
   }
-  return tasks[index];
+  const TaskList& list = tasks;
+  return list[index];
+}
+
+std::vector<Act> TaskManager::getTasks() { return tasks.toVector(); }
+
+TaskList TaskManager::snapshotTasks() const {
+  return tasks;
 }
 
-std::vector<Act> TaskManager::getTasks() { return tasks; }
+void TaskManager::restoreTasks(const TaskList& snapshot) {
+  tasks = snapshot;
+  taskPositions.clear();
+  reindexFrom(0);
+}
 
 int TaskManager::taskSize(){
   return tasks.size();
@@ -195,11 +360,21 @@ Act& TaskManager::getTaskRef(int index) {
   return tasks[index];
 }
 
+const Act& TaskManager::getTaskView(int index) const {
+  if (index < 0 || index >= static_cast<int>(tasks.size())) {
+    throw std::out_of_range("Index out of range");
+  }
+  const TaskList& list = tasks;
+  return list[index];
+}
+
 bool TaskManager::deleteTask(int index) {
   if (index < 0 || index >= tasks.size()) {
     return false; // Invalid index
   }
-  tasks.erase(tasks.begin() + index);
+  taskPositions.erase(getTaskId(index));
+  tasks.erase(index);
+  reindexFrom(index);
   return true;
 }
 
@@ -213,15 +388,18 @@ bool TaskManager::moveTask(int fromIndex, int toIndex) {
   // Use std::swap for adjacent moves (more reliable)
   if (abs(toIndex - fromIndex) == 1) {
     std::swap(tasks[fromIndex], tasks[toIndex]);
+    taskPositions[getTaskId(fromIndex)] = fromIndex;
+    taskPositions[getTaskId(toIndex)] = toIndex;
     return true;
   }
 
   // For non-adjacent moves, use the traditional approach
   // Store the task to move
-  Act taskToMove = tasks[fromIndex];
+  const TaskList& list = tasks;
+  Act taskToMove = list[fromIndex];
 
   // Remove the task from its current position
-  tasks.erase(tasks.begin() + fromIndex);
+  tasks.erase(fromIndex);
 
   // Adjust toIndex if necessary (since we removed an element)
   if (toIndex > fromIndex) {
@@ -229,7 +407,8 @@ bool TaskManager::moveTask(int fromIndex, int toIndex) {
   }
 
   // Insert the task at the new position
-  tasks.insert(tasks.begin() + toIndex, taskToMove);
+  tasks.insert(toIndex, taskToMove);
+  reindexFrom(std::min(fromIndex, toIndex));
 
   return true;
 }
@@ -242,7 +421,7 @@ bool TaskManager::moveTaskUp(int index) {
 }
 
 bool TaskManager::moveTaskDown(int index) {
-  if (index < 0 || index >= tasks.size() - 1) {
+  if (index < 0 || index + 1 >= static_cast<int>(tasks.size())) {
     return false; // Can't move last task down or invalid index
   }
   return moveTask(index, index + 1);
@@ -261,45 +440,70 @@ double TaskManager::getDayLengthHours() const {
 }
 
 // Persistence methods
-bool TaskManager::saveToFile(const std::string& filename) const {
+std::string TaskManager::serializeTasks() const {
+  json j;
+
+  // Get current date for metadata
+  auto now = std::time(nullptr);
+  auto tm = *std::localtime(&now);
+  std::ostringstream date_stream;
+  date_stream << std::put_time(&tm, "%Y-%m-%d");
+
+  j["date"] = date_stream.str();
+  j["dayLength"] = dayLength;
+
+  // Serialize tasks
+  json tasks_array = json::array();
+  for (const auto& task : tasks) {
+    json task_obj;
+    task_obj["id"] = task.getId();
+    task_obj["name"] = task.getName();
+    task_obj["startTime"] = task.getStartStr();
+    task_obj["length"] = task.getLength();
+    task_obj["rigid"] = task.isRigid();
+    task_obj["fixed"] = task.isFixed();
+    tasks_array.push_back(task_obj);
+  }
+  j["tasks"] = tasks_array;
+
+  return j.dump(2);  // Pretty print with 2-space indentation
+}
+
+bool TaskManager::saveToFile(const std::string& filename) {
   try {
     // Create data directory if it doesn't exist
     std::filesystem::path filepath(filename);
     std::filesystem::create_directories(filepath.parent_path());
 
-    json j;
-
-    // Get current date for metadata
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
-    std::ostringstream date_stream;
-    date_stream << std::put_time(&tm, "%Y-%m-%d");
-
-    j["date"] = date_stream.str();
-    j["dayLength"] = dayLength;
-
-    // Serialize tasks
-    json tasks_array = json::array();
-    for (const auto& task : tasks) {
-      json task_obj;
-      task_obj["name"] = task.getName();
-      task_obj["startTime"] = task.getStartStr();
-      task_obj["length"] = task.getLength();
-      task_obj["rigid"] = task.isRigid();
-      task_obj["fixed"] = task.isFixed();
-      tasks_array.push_back(task_obj);
-    }
-    j["tasks"] = tasks_array;
-
-    // Write to file
-    std::ofstream file(filename);
+    // Write to a temporary file and rename it into place, so the day cache
+    // and watchers reading the file never see it half written
+    std::string tempPath = filename + ".tmp";
+    std::ofstream file(tempPath, std::ios::trunc);
     if (!file.is_open()) {
       std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
       return false;
     }
 
-    file << j.dump(2); // Pretty print with 2-space indentation
+    std::string content = serializeTasks();
+    file << content;
     file.close();
+    if (!file) {
+      std::cerr << "Error: Could not write file: " << filename << std::endl;
+      std::filesystem::remove(tempPath);
+      return false;
+    }
+    std::filesystem::rename(tempPath, filename);
+
+    // The file now has bytes of its own, which a parked history is keyed to
+    if (historyKey(filename) == historyFile) {
+      loadedContentHash = hashContent(content);
+      loadedFromArchive = false;
+      diskTasks = tasks;
+    }
+
+    // Persist the computed schedule next to the data so the CLI can skip recomputing it
+    ScheduleCache::store(filename, hashContent(content), dayLength,
+                         scheduleForSavedTasks(tasks, dayLength));
 
     return true;
   } catch (const std::exception& e) {
@@ -312,37 +516,81 @@ bool TaskManager::loadFromFile(const std::string& filename) {
   try {
     // Check if file exists
     if (!std::filesystem::exists(filename)) {
-      std::cout << "Data file not found: " << filename << ". Starting with empty task list." << std::endl;
+      // A day compacted by `plan pack` or `plan archive` no longer has a file of its own
+      std::string content;
+      if ((readPackedDay(filename, content) || readArchivedDay(filename, content)) &&
+          loadFromContent(content, filename)) {
+        loadedFromArchive = true;
+        return true;
+      }
+      if (!quietLoad) {
+        std::cout << "Data file not found: " << filename << ". Starting with empty task list." << std::endl;
+      }
       return false;
     }
 
     std::ifstream file(filename);
     if (!file.is_open()) {
-      std::cerr << "Error: Could not open file for reading: " << filename << std::endl;
+      if (!quietLoad) {
+        std::cerr << "Error: Could not open file for reading: " << filename << std::endl;
+      }
       return false;
     }
 
-    json j;
-    file >> j;
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
     file.close();
+    return loadFromContent(content, filename);
+  } catch (const std::exception& e) {
+    if (!quietLoad) {
+      std::cerr << "Error loading from file " << filename << ": " << e.what() << std::endl;
+    }
+    return false;
+  }
+}
+
+bool TaskManager::readArchivedDay(const std::string& filename, std::string& content) const {
+  std::filesystem::path path(filename);
+  std::string date;
+  if (!dayOfDataFile(path, config, date)) {
+    return false;
+  }
+  ArchiveStore archive((path.parent_path() / archiveFileName(config)).string());
+  return archive.open() && archive.read(date, content);
+}
+
+bool TaskManager::readPackedDay(const std::string& filename, std::string& content) const {
+  std::filesystem::path path(filename);
+  std::string date;
+  if (!dayOfDataFile(path, config, date)) {
+    return false;
+  }
+  std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+  PackStore pack(PackStore::packPath(directory, date.substr(0, 7)));
+  return pack.open() && pack.read(date, content);
+}
+
+bool TaskManager::loadFromContent(const std::string& content, const std::string& filename) {
+  try {
+    json j = json::parse(content);
 
     // Validate JSON structure
     if (!j.contains("dayLength") || !j.contains("tasks")) {
-      std::cerr << "Error: Invalid file format in " << filename << std::endl;
+      if (!quietLoad) {
+        std::cerr << "Error: Invalid file format in " << filename << std::endl;
+      }
       return false;
     }
 
-    // Load dayLength
-    dayLength = j["dayLength"].get<int>();
-
-    // Clear existing tasks
-    tasks.clear();
-
-    // Load tasks
+    // Read everything before touching the loaded day, so a file that fails
+    // part way leaves its tasks, content hash and history as they were
+    int newDayLength = j["dayLength"].get<int>();
+    std::vector<Act> newTasks;
     for (const auto& task_obj : j["tasks"]) {
       if (!task_obj.contains("name") || !task_obj.contains("length") ||
           !task_obj.contains("rigid") || !task_obj.contains("fixed")) {
-        std::cerr << "Warning: Skipping invalid task in " << filename << std::endl;
+        if (!quietLoad) {
+          std::cerr << "Warning: Skipping invalid task in " << filename << std::endl;
+        }
         continue;
       }
 
@@ -351,21 +599,85 @@ bool TaskManager::loadFromFile(const std::string& filename) {
       bool rigid = task_obj["rigid"].get<bool>();
       bool fixed = task_obj["fixed"].get<bool>();
 
-      if (fixed && task_obj.contains("startTime")) {
-        std::string startTime = task_obj["startTime"].get<std::string>();
-        addTask(name, startTime, length, rigid);
-      } else {
-        addTask(name, length, rigid);
+      Act task = (fixed && task_obj.contains("startTime"))
+                     ? Act(name, task_obj["startTime"].get<std::string>(), length, rigid)
+                     : Act(name, length, rigid);
+      if (task_obj.contains("id") && task_obj["id"].is_number_unsigned()) {
+        task.setId(task_obj["id"].get<uint64_t>());
       }
+      newTasks.push_back(std::move(task));
     }
 
+    // Set the history of the file being left aside while its tasks are still loaded
+    if (historyKey(filename) != historyFile) {
+      parkHistory();
+    }
+
+    dayLength = newDayLength;
+    loadedContentHash = hashContent(content);
+    loadedFromArchive = false;
+    clearTasks();
+    // Ids are per file: one saved without them (from before ids, or the
+    // archive) numbers its tasks the same way on every load, so a history
+    // recorded against it still finds them
+    nextTaskId = 1;
+    for (Act& task : newTasks) {
+      insertTaskAt(tasks.size(), task);
+    }
+    diskTasks = tasks;
+
+    // History belongs to the file it was recorded against
+    switchHistory(filename);
+
     return true;
   } catch (const std::exception& e) {
-    std::cerr << "Error loading from file " << filename << ": " << e.what() << std::endl;
+    if (!quietLoad) {
+      std::cerr << "Error loading from file " << filename << ": " << e.what() << std::endl;
+    }
     return false;
   }
 }
 
+bool TaskManager::loadExisting(const std::string& filename, bool quiet) {
+  quietLoad = quiet;
+  bool loaded = false;
+  if (std::filesystem::exists(filename)) {
+    loaded = loadFromFile(filename);
+  } else {
+    std::string content;
+    if ((readPackedDay(filename, content) || readArchivedDay(filename, content)) && loadFromContent(content, filename)) {
+      loadedFromArchive = true;
+      loaded = true;
+    }
+  }
+  quietLoad = false;
+  return loaded;
+}
+
+void TaskManager::adoptDay(const TaskManager& loaded, const std::string& filename) {
+  // Set the history of the file being left aside while its tasks are still loaded
+  if (historyKey(filename) != historyFile) {
+    parkHistory();
+  }
+
+  dayLength = loaded.dayLength;
+  loadedContentHash = loaded.loadedContentHash;
+  loadedFromArchive = loaded.loadedFromArchive;
+  nextTaskId = loaded.nextTaskId;
+  restoreTasks(loaded.tasks);
+  diskTasks = tasks;
+
+  switchHistory(filename);
+}
+
+uint64_t TaskManager::getLoadedContentHash() const {
+  return loadedContentHash;
+}
+
+bool TaskManager::isLoadedFromArchive() const {
+  return loadedFromArchive;
+}
+
 std::string TaskManager::getDateBasedFilename() const {
   auto now = std::time(nullptr);
   auto tm = *std::localtime(&now);
@@ -378,8 +690,13 @@ std::string TaskManager::getDateBasedFilename(const std::string& date) const {
   return "data/tasks_" + date + ".json";
 }
 
+bool TaskManager::getFileDate(const std::string& filename, std::string& date) const {
+  return dayOfDataFile(filename, config, date);
+}
+
 void TaskManager::clearTasks() {
   tasks.clear();
+  taskPositions.clear();
 }
 
 // Config-aware methods
@@ -409,6 +726,10 @@ std::string TaskManager::getConfiguredFilename(const std::string& date) const {
   return dataDir + "/tasks_" + date + extension;
 }
 
+std::string TaskManager::getArchivePath() const {
+  return getConfiguredDataDir() + "/" + archiveFileName(config);
+}
+
 // File discovery and selection methods
 std::vector<std::string> TaskManager::findJsonFiles() const {
   std::vector<std::string> jsonFiles;
@@ -448,6 +769,28 @@ std::vector<std::string> TaskManager::findJsonFiles() const {
       }
     });
 
+    // Then the days packed by `plan pack`, newest first, under the names
+    // loadFromFile reads them through; a loose file of the same day wins
+    std::vector<std::string> packedFiles;
+    for (const auto& entry : std::filesystem::directory_iterator(dataDir)) {
+      std::string month;
+      if (!entry.is_regular_file() || !PackStore::monthOf(entry.path().filename().string(), month)) {
+        continue;
+      }
+      PackStore pack(entry.path().string());
+      if (!pack.open()) {
+        continue;
+      }
+      for (const std::string& date : pack.dates()) {
+        std::string filepath = getConfiguredFilename(date);
+        if (!std::filesystem::exists(filepath)) {
+          packedFiles.push_back(filepath);
+        }
+      }
+    }
+    std::sort(packedFiles.rbegin(), packedFiles.rend());
+    jsonFiles.insert(jsonFiles.end(), packedFiles.begin(), packedFiles.end());
+
   } catch (const std::exception& e) {
     std::cerr << "Error scanning directory " << dataDir << ": " << e.what() << std::endl;
   }
@@ -817,39 +1160,71 @@ bool TaskManager::isValidTaskFile(const std::string& filename) const {
 }
 
 // Undo/Redo functionality implementation
-void TaskManager::executeCommand(std::unique_ptr<UndoableCommand> command) {
+std::pmr::memory_resource* TaskManager::getCommandResource() const {
+  return undoManager ? undoManager->getCommandResource() : std::pmr::get_default_resource();
+}
+
+void TaskManager::executeCommand(CommandPtr command) {
   if (undoManager) {
+    RecalcScope scope(*this);
+    loadPendingHistory();  // The new entry goes on top of the saved ones
     undoManager->executeCommand(std::move(command));
   }
 }
 
 bool TaskManager::canUndo() const {
-  return undoManager && undoManager->canUndo();
+  return undoManager && (undoManager->canUndo() || pendingHistory.undoCount > 0);
 }
 
 bool TaskManager::canRedo() const {
-  return undoManager && undoManager->canRedo();
+  return undoManager && (undoManager->canRedo() || pendingHistory.redoCount > 0);
 }
 
 void TaskManager::undo() {
   if (undoManager) {
+    RecalcScope scope(*this);
+    loadPendingHistory();
     undoManager->undo();
     // Recalculate task properties after undo
-    calcActLen();
-    calcStartTimes();
+    recalculate();
   }
 }
 
 void TaskManager::redo() {
   if (undoManager) {
+    RecalcScope scope(*this);
+    loadPendingHistory();
     undoManager->redo();
     // Recalculate task properties after redo
-    calcActLen();
-    calcStartTimes();
+    recalculate();
+  }
+}
+
+std::vector<UndoManager::HistoryEntry> TaskManager::getHistoryTree() {
+  if (!undoManager) {
+    return {};
   }
+  loadPendingHistory();
+  return undoManager->getHistoryTree();
+}
+
+bool TaskManager::jumpToHistory(uint64_t id) {
+  if (!undoManager) {
+    return false;
+  }
+  RecalcScope scope(*this);
+  loadPendingHistory();
+  bool jumped = undoManager->jumpTo(id);
+  if (jumped) {
+    recalculate();
+  }
+  return jumped;
 }
 
 std::string TaskManager::getLastUndoDescription() const {
+  if (!pendingHistoryFile.empty()) {
+    return pendingHistory.lastUndoDescription;
+  }
   if (undoManager) {
     return undoManager->getLastUndoDescription();
   }
@@ -857,6 +1232,9 @@ std::string TaskManager::getLastUndoDescription() const {
 }
 
 std::string TaskManager::getLastRedoDescription() const {
+  if (!pendingHistoryFile.empty()) {
+    return pendingHistory.lastRedoDescription;
+  }
   if (undoManager) {
     return undoManager->getLastRedoDescription();
   }
@@ -865,14 +1243,140 @@ std::string TaskManager::getLastRedoDescription() const {
 
 size_t TaskManager::getUndoStackSize() const {
   if (undoManager) {
-    return undoManager->getUndoStackSize();
+    return undoManager->getUndoStackSize() + pendingHistory.undoCount;
   }
   return 0;
 }
 
 size_t TaskManager::getRedoStackSize() const {
   if (undoManager) {
-    return undoManager->getRedoStackSize();
+    return undoManager->getRedoStackSize() + pendingHistory.redoCount;
+  }
+  return 0;
+}
+
+size_t TaskManager::getUndoMemoryUsage() const {
+  if (undoManager) {
+    return undoManager->getCurrentMemoryUsage();
+  }
+  return 0;
+}
+
+size_t TaskManager::getUndoMemoryLimit() const {
+  if (undoManager) {
+    return undoManager->getMaxBytes();
   }
   return 0;
-}
\ No newline at end of file
+}
+
+bool TaskManager::isHistoryPersisted() const {
+  return !config || config->getBool("undo-persist", true);
+}
+
+void TaskManager::attachHistory(const std::string& filename) {
+  pendingHistoryFile.clear();
+  pendingHistory = UndoLog::Summary();
+  if (isHistoryPersisted() && UndoLog::peek(filename, loadedContentHash, pendingHistory)) {
+    pendingHistoryFile = filename;
+  } else {
+    pendingHistory = UndoLog::Summary();  // peek may have filled part of it
+  }
+}
+
+void TaskManager::loadPendingHistory() {
+  if (pendingHistoryFile.empty()) {
+    return;
+  }
+
+  std::string filename;
+  filename.swap(pendingHistoryFile);
+  pendingHistory = UndoLog::Summary();
+  if (!UndoLog::load(filename, loadedContentHash, *this, *undoManager)) {
+    std::cerr << "Warning: Could not read undo history for " << filename << std::endl;
+  }
+}
+
+std::unique_ptr<UndoManager> TaskManager::createUndoManager() {
+  auto history = std::make_unique<UndoManager>();
+  history->setStateAccess([this]() { return snapshotTasks(); },
+                          [this](const TaskList& snapshot) { restoreTasks(snapshot); });
+  if (config) {
+    int maxEntries = config->getInt("undo-max-entries", static_cast<int>(UndoManager::DEFAULT_MAX_ENTRIES));
+    int maxBytes = config->getInt("undo-max-bytes", static_cast<int>(UndoManager::DEFAULT_MAX_BYTES));
+    history->setLimits(static_cast<size_t>(std::max(maxEntries, 1)), static_cast<size_t>(std::max(maxBytes, 0)));
+    int mergeMs = config->getInt("undo-merge-ms", UndoManager::DEFAULT_MERGE_WINDOW_MS);
+    history->setMergeWindow(std::chrono::milliseconds(std::max(mergeMs, 0)));
+    int checkpointInterval = config->getInt("undo-checkpoint-interval",
+                                            static_cast<int>(UndoManager::DEFAULT_CHECKPOINT_INTERVAL));
+    history->setCheckpointInterval(static_cast<size_t>(std::max(checkpointInterval, 0)));
+  }
+  return history;
+}
+
+void TaskManager::switchHistory(const std::string& filename) {
+  std::string file = historyKey(filename);
+  if (file == historyFile) {
+    // Reloading the same file: whatever was on disk replaces the session
+    undoManager->clear();
+    attachHistory(filename);
+    return;
+  }
+  historyFile = file;
+
+  auto parked = parkedByFile.find(file);
+  if (parked != parkedByFile.end()) {
+    auto entry = parked->second;
+    parkedByFile.erase(parked);
+    parkedHistoryBytes -= entry->bytes;
+    bool current = entry->contentHash == loadedContentHash;
+    std::unique_ptr<UndoManager> history = std::move(entry->history);
+    parkedHistories.erase(entry);
+
+    // Changed since we left (auto-save off, another process): the history no longer applies
+    if (current) {
+      undoManager = std::move(history);
+      return;
+    }
+  }
+
+  attachHistory(filename);
+}
+
+void TaskManager::parkHistory() {
+  // Keep the history unless there is nothing worth keeping in memory: no
+  // file yet, an empty history, or one still sitting unread in its sidecar.
+  // Unsaved edits drop it too: loading the file again gives the tasks on
+  // disk, which the history does not end at.
+  if (!historyFile.empty() && pendingHistoryFile.empty() &&
+      (undoManager->canUndo() || undoManager->canRedo()) && sameSavedTasks(tasks, diskTasks)) {
+    size_t bytes = undoManager->getCurrentMemoryUsage();
+    // Keyed to the bytes on disk, which is what loading the file again hashes
+    parkedHistories.push_front({historyFile, std::move(undoManager), loadedContentHash, bytes});
+    parkedByFile[historyFile] = parkedHistories.begin();
+    parkedHistoryBytes += bytes;
+
+    // Least recently left goes first; its sidecar still has it if it was saved
+    while (parkedHistoryBytes > parkedHistoryBudget || parkedHistories.size() > MAX_PARKED_HISTORIES) {
+      parkedHistoryBytes -= parkedHistories.back().bytes;
+      parkedByFile.erase(parkedHistories.back().file);
+      parkedHistories.pop_back();
+    }
+  }
+
+  undoManager = createUndoManager();
+  historyFile.clear();
+  pendingHistoryFile.clear();
+  pendingHistory = UndoLog::Summary();
+}
+
+size_t TaskManager::getParkedHistoryCount() const {
+  return parkedHistories.size();
+}
+
+bool TaskManager::saveHistory(const std::string& filename) {
+  if (!undoManager || !isHistoryPersisted()) {
+    return true;
+  }
+  loadPendingHistory();
+  return UndoLog::store(filename, *undoManager);
+}
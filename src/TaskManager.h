@@ -4,38 +4,115 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
 #include "Act.h"
+#include "TaskList.h"
+#include "UndoManager.h"
+#include "UndoLog.h"
 
 // Forward declarations
 class Config;
-class UndoManager;
-class UndoableCommand;
 
 class TaskManager {
+ public:
+  // Called with the freshly computed tasks whenever start times are recalculated
+  using ScheduleListener = std::function<void(const std::vector<Act>&)>;
+
+  // Budget for the histories of files switched away from (undo-cache-bytes)
+  static constexpr size_t DEFAULT_HISTORY_CACHE_BYTES = 4 * 1024 * 1024;
+  static constexpr size_t MAX_PARKED_HISTORIES = 16;
+
+  // Where calcStartTimes puts a flexible first task, in minutes since midnight;
+  // a day's working window runs from here for its dayLength
+  static constexpr int DAY_START = 9 * 60;
+
  private:
-  std::vector<Act> tasks;
+  TaskList tasks;  // Persistent: copies are O(1) snapshots
   int dayLength;
   Config* config;  // Pointer to configuration
   std::unique_ptr<UndoManager> undoManager;  // Undo/redo functionality
+  uint64_t loadedContentHash;  // Hash of the loaded file's bytes on disk, as last loaded or saved
+  TaskList diskTasks;          // The tasks those bytes hold, to tell whether they were edited since
+  bool loadedFromArchive;      // Those bytes came from a pack or the archive, not a file of their own
+  bool quietLoad;              // Loading keeps its messages to itself (loadExisting(filename, true))
+  ScheduleListener scheduleListener;
+  int recalcDepth;     // Open RecalcScopes
+  bool recalcPending;  // recalculate() was deferred by one of them
+  uint64_t nextTaskId;
+  std::unordered_map<uint64_t, size_t> taskPositions;  // Task id -> index in tasks
+  std::string pendingHistoryFile;   // Data file whose undo log is attached but not read yet
+  UndoLog::Summary pendingHistory;  // Its header, answering canUndo()/descriptions until then
+
+  // Histories of files switched away from, most recently left first. A file
+  // switched back to gets its UndoManager back as long as the file still has
+  // the contents the history ends at.
+  struct ParkedHistory {
+    std::string file;
+    std::unique_ptr<UndoManager> history;
+    uint64_t contentHash;  // Of the file's bytes on disk when the history was parked
+    size_t bytes;          // Its memory use when parked
+  };
+  std::string historyFile;  // Data file undoManager belongs to (normalized)
+  std::list<ParkedHistory> parkedHistories;
+  std::unordered_map<std::string, std::list<ParkedHistory>::iterator> parkedByFile;
+  size_t parkedHistoryBytes;
+  size_t parkedHistoryBudget;  // undo-cache-bytes
+
+  void reindexFrom(size_t position);  // Refresh taskPositions for tasks[position..]
+  bool isHistoryPersisted() const;    // undo-persist
+  void attachHistory(const std::string& filename);  // Reads only the undo log's header
+  void loadPendingHistory();  // Reads the attached undo log on first use of the history
+  std::unique_ptr<UndoManager> createUndoManager();  // With the configured limits, checkpointing tasks
+  void parkHistory();  // Set the current file's history aside before another file is loaded
+  void switchHistory(const std::string& filename);  // Take up the loaded file's history
+  std::string serializeTasks() const;  // The JSON saveToFile writes
 
  public:
+  // Defers recalculate() while alive; the outermost scope runs a single
+  // calcActLen + calcStartTimes pass on exit if anything asked for one.
+  // Commands, undo/redo and TUI event handlers run inside one, so a group
+  // of N commands costs one pass instead of 2N.
+  class RecalcScope {
+   public:
+    explicit RecalcScope(TaskManager& mgr);
+    ~RecalcScope();
+    RecalcScope(const RecalcScope&) = delete;
+    RecalcScope& operator=(const RecalcScope&) = delete;
+
+   private:
+    TaskManager& manager;
+  };
+
   TaskManager(int dl);
   TaskManager(Config* cfg);  // Constructor with config
   void addTask(const std::string &name, std::string start, int length, bool isRigid);
   void addTask(const std::string &name, int length, bool isRigid);
   void insertTask(int index, const std::string &name, std::string start, int length, bool isRigid);
   void insertTask(int index, const std::string &name, int length, bool isRigid);
-  void insertTaskAt(size_t index, Act &newTask);
+  void insertTaskAt(size_t index, Act &newTask);  // Assigns newTask's id if it has none
   void beginAt(size_t index);
   void calcStartTimes();
+  void recalculate();  // calcActLen + calcStartTimes, deferred inside a RecalcScope
+  void setScheduleListener(ScheduleListener listener);
   void displayAllTasks();
   void calcActLen();
   std::vector<std::string> calcActLen(bool& hasWarnings); // Returns warnings if any
   Act getTask(int index);
   std::vector<Act> getTasks();
+  // O(1) copy of the current list, unaffected by later edits; restoring one
+  // swaps it back in (recalculate() afterwards)
+  TaskList snapshotTasks() const;
+  void restoreTasks(const TaskList& snapshot);
   int taskSize();
   void updateTask(int index, const std::string& name, const std::string& startTime, int length, bool isRigid);
-  Act& getTaskRef(int index);
+  Act& getTaskRef(int index);  // For writes: copies the task's chunk if a snapshot shares it
+  const Act& getTaskView(int index) const;  // For reads; never copies anything
+  // Stable ids survive inserts, deletes and moves; lookups are O(1)
+  int getTaskIndex(uint64_t id) const;  // -1 if no such task
+  uint64_t getTaskId(int index) const;  // 0 if out of range
   bool deleteTask(int index); // Returns true if deletion was successful
   bool moveTask(int fromIndex, int toIndex); // Move task from one position to another
   bool moveTaskUp(int index); // Move task up by one position (to earlier time)
@@ -45,16 +122,36 @@ class TaskManager {
   double getDayLengthHours() const; // Get day length in hours (for display)
 
   // Persistence methods
-  bool saveToFile(const std::string& filename) const;
+  // Saving the loaded file makes what was written its loaded content
+  bool saveToFile(const std::string& filename);
+  // A missing tasks_YYYY-MM-DD file is looked up in its month's pack, then
+  // in the archive next to it
   bool loadFromFile(const std::string& filename);
+  // The bytes of a missing tasks_YYYY-MM-DD file kept in a pack / the archive
+  bool readPackedDay(const std::string& filename, std::string& content) const;
+  bool readArchivedDay(const std::string& filename, std::string& content) const;
+  // Load a data file's bytes obtained elsewhere (a pack or the archive);
+  // filename is the file they stand for
+  bool loadFromContent(const std::string& content, const std::string& filename);
+  // loadFromFile without its message for a day that is nowhere on record;
+  // quiet drops the ones about a damaged file too, for loads off the UI thread
+  bool loadExisting(const std::string& filename, bool quiet = false);
+  // Take over the day another manager loaded from filename (off the UI
+  // thread, say) as if loadFromFile had read it here: its tasks, shared in
+  // O(1), day length and content hash, with the history switched to the file
+  void adoptDay(const TaskManager& loaded, const std::string& filename);
+  uint64_t getLoadedContentHash() const;
+  bool isLoadedFromArchive() const;
   std::string getDateBasedFilename() const;
   std::string getDateBasedFilename(const std::string& date) const;
+  bool getFileDate(const std::string& filename, std::string& date) const;  // False unless tasks_YYYY-MM-DD<extension>
   void clearTasks();
 
   // Config-aware methods
   std::string getConfiguredDataDir() const;
   std::string getConfiguredFilename() const;
   std::string getConfiguredFilename(const std::string& date) const;
+  std::string getArchivePath() const;  // data-dir/archive-file
 
   // File discovery and selection methods
   std::vector<std::string> findJsonFiles() const;
@@ -69,7 +166,13 @@ class TaskManager {
   std::string selectFileWithFindTool() const;
 
   // Undo/Redo functionality
-  void executeCommand(std::unique_ptr<UndoableCommand> command);
+  // Commands are built in the undo manager's pool: manager.createCommand<AddTaskCommand>(name, len, rigid)
+  template <typename T, typename... Args>
+  std::unique_ptr<T, CommandDeleter> createCommand(Args&&... args) {
+    return undoManager->createCommand<T>(this, std::forward<Args>(args)...);
+  }
+  std::pmr::memory_resource* getCommandResource() const;
+  void executeCommand(CommandPtr command);
   bool canUndo() const;
   bool canRedo() const;
   void undo();
@@ -78,6 +181,15 @@ class TaskManager {
   std::string getLastRedoDescription() const;
   size_t getUndoStackSize() const;
   size_t getRedoStackSize() const;
+  // Every state in the undo tree, for the history browser (reads a pending undo log)
+  std::vector<UndoManager::HistoryEntry> getHistoryTree();
+  bool jumpToHistory(uint64_t id);  // Move to any state in the tree, on any branch
+  size_t getUndoMemoryUsage() const;  // Bytes held by the undo/redo history
+  size_t getUndoMemoryLimit() const;  // undo-max-bytes
+  size_t getParkedHistoryCount() const;  // Histories of other files kept in memory
+  // Write the undo/redo history next to the data file; call after saveToFile
+  // succeeded so the log is keyed to what is on disk
+  bool saveHistory(const std::string& filename);
 };
 
 #endif  // TASKMANAGER_H
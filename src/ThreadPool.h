@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads taking jobs first in, first out. submit()
+// hands back a future for the job's result (or the exception it threw);
+// destroying the pool finishes the queued jobs and joins the workers.
+class ThreadPool {
+ private:
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::deque<std::function<void()>> jobs;
+  std::vector<std::thread> workers;
+  bool stopping;
+
+  void run();
+
+ public:
+  explicit ThreadPool(size_t threads);  // 0 means one per hardware thread
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const;
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>> submit(F job) {
+    // packaged_task is move-only and std::function needs a copyable target
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(job));
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.emplace_back([task]() { (*task)(); });
+    }
+    wakeup.notify_one();
+    return result;
+  }
+};
+
+#endif  // THREADPOOL_H
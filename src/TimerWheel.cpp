@@ -0,0 +1,141 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+TimerWheel::TimerWheel(uint64_t now) : current(now), slots(OVERDUE_SLOT + 1) {}
+
+int TimerWheel::slotFor(uint64_t expiry) const {
+  if (expiry <= current) {
+    return OVERDUE_SLOT;
+  }
+
+  uint64_t delta = expiry - current;
+  for (int level = 0; level < LEVELS; level++) {
+    if (delta < (uint64_t(1) << (SLOT_BITS * (level + 1))) || level == LEVELS - 1) {
+      // Beyond the top level's range, park in its farthest slot and re-cascade
+      uint64_t tick = level == LEVELS - 1 && (delta >> (SLOT_BITS * LEVELS)) != 0
+                          ? current + (uint64_t(SLOTS - 1) << (SLOT_BITS * level))
+                          : expiry;
+      return level * SLOTS + static_cast<int>((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+  }
+  return 0;
+}
+
+void TimerWheel::place(uint64_t id, uint64_t expiry) {
+  int slot = slotFor(expiry);
+  auto& list = slots[slot];
+  list.push_back(id);
+  timers[id] = {expiry, slot, std::prev(list.end())};
+}
+
+void TimerWheel::schedule(uint64_t id, uint64_t expiry) {
+  cancel(id);
+  place(id, expiry);
+}
+
+bool TimerWheel::cancel(uint64_t id) {
+  auto it = timers.find(id);
+  if (it == timers.end()) {
+    return false;
+  }
+  slots[it->second.slot].erase(it->second.position);
+  timers.erase(it);
+  return true;
+}
+
+bool TimerWheel::contains(uint64_t id) const {
+  return timers.count(id) > 0;
+}
+
+void TimerWheel::cascade(int level) {
+  int position = static_cast<int>((current >> (SLOT_BITS * level)) & (SLOTS - 1));
+  std::list<uint64_t> moving;
+  moving.swap(slots[level * SLOTS + position]);
+  for (uint64_t id : moving) {
+    place(id, timers[id].expiry);
+  }
+}
+
+bool TimerWheel::levelEmpty(int level) const {
+  for (int slot = 0; slot < SLOTS; slot++) {
+    if (!slots[level * SLOTS + slot].empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TimerWheel::drainOverdue(std::vector<uint64_t>& expired) {
+  for (uint64_t id : slots[OVERDUE_SLOT]) {
+    expired.push_back(id);
+    timers.erase(id);
+  }
+  slots[OVERDUE_SLOT].clear();
+}
+
+void TimerWheel::advance(uint64_t now, std::vector<uint64_t>& expired) {
+  drainOverdue(expired);
+
+  while (current < now) {
+    // Skip ahead over stretches with nothing scheduled instead of ticking through them
+    if (timers.empty()) {
+      current = now;
+      return;
+    }
+    int emptyLevels = 0;
+    while (emptyLevels < LEVELS && levelEmpty(emptyLevels)) {
+      emptyLevels++;
+    }
+    if (emptyLevels > 0) {
+      // Nothing can happen before the next cascade of the first occupied level
+      uint64_t lastQuietTick = current | ((uint64_t(1) << (SLOT_BITS * emptyLevels)) - 1);
+      if (lastQuietTick > current) {
+        current = std::min(lastQuietTick, now);
+        continue;
+      }
+    }
+
+    current++;
+    for (int level = 1; level < LEVELS; level++) {
+      if ((current & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0) break;
+      cascade(level);
+    }
+    // Cascading puts timers due exactly now into the overdue slot
+    drainOverdue(expired);
+
+    auto& due = slots[current & (SLOTS - 1)];
+    for (auto it = due.begin(); it != due.end();) {
+      uint64_t id = *it;
+      if (timers[id].expiry <= current) {
+        expired.push_back(id);
+        timers.erase(id);
+        it = due.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+uint64_t TimerWheel::nextExpiry() const {
+  // Callers only need this to pick a sleep deadline, and a day holds a
+  // handful of boundaries, so a scan beats maintaining a second index
+  uint64_t next = std::numeric_limits<uint64_t>::max();
+  for (const auto& entry : timers) {
+    if (entry.second.expiry < next) {
+      next = entry.second.expiry;
+    }
+  }
+  return next;
+}
+
+size_t TimerWheel::size() const {
+  return timers.size();
+}
+
+bool TimerWheel::empty() const {
+  return timers.empty();
+}
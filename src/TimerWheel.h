@@ -0,0 +1,57 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical timer wheel with one-minute ticks. Level 0 holds the next 64
+// minutes one slot per minute, each further level covers 64 times the span of
+// the previous one (~2.8 days, ~6 months, ~32 years), and timers cascade down
+// a level when its slot comes up. Scheduling and cancelling are O(1); advancing
+// only touches the slots that expire.
+class TimerWheel {
+ public:
+  static constexpr int SLOT_BITS = 6;
+  static constexpr int SLOTS = 1 << SLOT_BITS;
+  static constexpr int LEVELS = 4;
+
+ private:
+  // Extra slot for timers scheduled at or before the current tick
+  static constexpr int OVERDUE_SLOT = LEVELS * SLOTS;
+
+  struct Timer {
+    uint64_t expiry;  // Absolute tick
+    int slot;         // Index into slots (level * SLOTS + position)
+    std::list<uint64_t>::iterator position;
+  };
+
+  uint64_t current;                       // Last tick processed
+  std::vector<std::list<uint64_t>> slots;  // Timer ids per slot
+  std::unordered_map<uint64_t, Timer> timers;
+
+  int slotFor(uint64_t expiry) const;
+  void place(uint64_t id, uint64_t expiry);
+  void cascade(int level);
+  void drainOverdue(std::vector<uint64_t>& expired);
+  bool levelEmpty(int level) const;
+
+ public:
+  explicit TimerWheel(uint64_t now);
+
+  // Schedule (or reschedule) a timer; expiries not in the future fire on the next advance
+  void schedule(uint64_t id, uint64_t expiry);
+  bool cancel(uint64_t id);
+  bool contains(uint64_t id) const;
+
+  // Move the wheel to `now`, appending the ids of every timer that expired
+  void advance(uint64_t now, std::vector<uint64_t>& expired);
+
+  uint64_t nextExpiry() const;  // UINT64_MAX when empty
+  size_t size() const;
+  bool empty() const;
+};
+
+#endif  // TIMERWHEEL_H
@@ -0,0 +1,309 @@
+#include "UndoLog.h"
+#include "ContentHash.h"
+#include "TaskManager.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x4c554c50;  // "PLUL"
+constexpr uint32_t MAX_HEADER_LENGTH = 1u << 16;
+
+// Sidecars never leave the machine, so host byte order is fine for the fixed header
+template <typename T>
+void writeValue(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+bool readFileBytes(const std::string& filename, std::string& content) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Fixed part of the sidecar: magic, version, content hash and the length of
+// the varint summary that follows it
+bool readPrefix(std::istream& in, uint64_t contentHash, uint32_t& headerLength) {
+  uint32_t magic = 0, version = 0;
+  uint64_t storedHash = 0;
+  return readValue(in, magic) && magic == MAGIC && readValue(in, version) &&
+         version == UndoLog::VERSION && readValue(in, storedHash) && storedHash == contentHash &&
+         readValue(in, headerLength) && headerLength <= MAX_HEADER_LENGTH;
+}
+
+bool readSummary(const std::string& header, UndoLog::Summary& summary) {
+  HistoryReader reader(header, nullptr, nullptr);
+  summary.undoCount = reader.readVarint();
+  summary.redoCount = reader.readVarint();
+  summary.lastUndoDescription = reader.readString();
+  summary.lastRedoDescription = reader.readString();
+  return reader.ok();
+}
+
+CommandPtr createBlankCommand(CommandType type, TaskManager* manager, UndoManager* history) {
+  switch (type) {
+    case CommandType::AddTask:
+      return history->createCommand<AddTaskCommand>(manager);
+    case CommandType::DeleteTask:
+      return history->createCommand<DeleteTaskCommand>(manager);
+    case CommandType::EditTaskName:
+      return history->createCommand<EditTaskNameCommand>(manager);
+    case CommandType::EditTaskStartTime:
+      return history->createCommand<EditTaskStartTimeCommand>(manager);
+    case CommandType::EditTaskLength:
+      return history->createCommand<EditTaskLengthCommand>(manager);
+    case CommandType::ToggleTaskFixed:
+      return history->createCommand<ToggleTaskFixedCommand>(manager);
+    case CommandType::ToggleTaskRigid:
+      return history->createCommand<ToggleTaskRigidCommand>(manager);
+    case CommandType::MoveTaskUp:
+      return history->createCommand<MoveTaskUpCommand>(manager);
+    case CommandType::MoveTaskDown:
+      return history->createCommand<MoveTaskDownCommand>(manager);
+    case CommandType::StartTaskTimer:
+      return history->createCommand<StartTaskTimerCommand>(manager);
+    case CommandType::Group:
+      return history->createCommand<CommandGroup>("", history->getCommandResource());
+    case CommandType::InsertTask:
+      return history->createCommand<InsertTaskCommand>(manager);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// HistoryWriter
+void HistoryWriter::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+void HistoryWriter::writeSigned(int64_t value) {
+  // Zigzag keeps small negative values (a -1 index) to one byte
+  writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void HistoryWriter::writeBool(bool value) {
+  buffer.push_back(value ? 1 : 0);
+}
+
+void HistoryWriter::writeString(std::string_view value) {
+  writeVarint(value.size());
+  buffer.append(value.data(), value.size());
+}
+
+void HistoryWriter::writeCommand(const UndoableCommand& command) {
+  HistoryWriter payload;
+  command.serialize(payload);
+  writeVarint(static_cast<uint8_t>(command.getType()));
+  writeString(payload.data());
+}
+
+// HistoryReader
+HistoryReader::HistoryReader(std::string_view data, TaskManager* manager, UndoManager* history)
+    : input(data), position(0), valid(true), manager(manager), history(history) {}
+
+uint64_t HistoryReader::readVarint() {
+  uint64_t value = 0;
+  for (int shift = 0; valid && shift < 64; shift += 7) {
+    if (position >= input.size()) {
+      break;
+    }
+    uint8_t byte = static_cast<uint8_t>(input[position++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  valid = false;
+  return 0;
+}
+
+int64_t HistoryReader::readSigned() {
+  uint64_t value = readVarint();
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+bool HistoryReader::readBool() {
+  if (!valid || position >= input.size()) {
+    valid = false;
+    return false;
+  }
+  return input[position++] != 0;
+}
+
+std::string HistoryReader::readString() {
+  uint64_t length = readVarint();
+  if (!valid || length > input.size() - position) {
+    valid = false;
+    return "";
+  }
+  std::string value(input.substr(position, length));
+  position += length;
+  return value;
+}
+
+std::string HistoryReader::readTime() {
+  std::string value = readString();
+  if (value.empty()) {
+    return value;
+  }
+
+  // Commands hand these straight to Act::setStartTime, which throws on garbage.
+  // A flexible task's computed start can be out of range; empty means flexible,
+  // which is what it was, so that is read back as empty.
+  size_t colon = value.find(':');
+  bool digits = colon != std::string::npos && colon >= 1 && colon <= 2 && value.size() - colon - 1 >= 1 &&
+                value.size() - colon - 1 <= 2;
+  for (size_t i = 0; digits && i < value.size(); i++) {
+    digits = i == colon || (value[i] >= '0' && value[i] <= '9');
+  }
+  if (!digits || std::stoi(value.substr(0, colon)) > 23 || std::stoi(value.substr(colon + 1)) > 59) {
+    return "";
+  }
+  return value;
+}
+
+CommandPtr HistoryReader::readCommand() {
+  uint64_t type = readVarint();
+  std::string payload = readString();
+  if (!valid || !manager || !history) {
+    valid = false;
+    return nullptr;
+  }
+
+  CommandPtr command = createBlankCommand(static_cast<CommandType>(type), manager, history);
+  HistoryReader fields(payload, manager, history);
+  if (!command || !command->deserialize(fields) || !fields.ok()) {
+    valid = false;
+    return nullptr;
+  }
+  return command;
+}
+
+// UndoLog
+std::string UndoLog::sidecarPath(const std::string& dataFilename) {
+  std::filesystem::path path(dataFilename);
+  return (path.parent_path() / ("." + path.filename().string() + ".undo")).string();
+}
+
+bool UndoLog::store(const std::string& dataFilename, const UndoManager& history) {
+  std::string path = sidecarPath(dataFilename);
+  std::vector<const UndoableCommand*> undoEntries = history.getUndoEntries();
+  std::vector<const UndoableCommand*> redoEntries = history.getRedoEntries();
+
+  std::error_code ec;
+  if (undoEntries.empty() && redoEntries.empty()) {
+    std::filesystem::remove(path, ec);
+    return !ec;
+  }
+
+  std::string content;
+  if (!readFileBytes(dataFilename, content)) {
+    return false;
+  }
+
+  HistoryWriter header;
+  header.writeVarint(undoEntries.size());
+  header.writeVarint(redoEntries.size());
+  header.writeString(history.getLastUndoDescription());
+  header.writeString(history.getLastRedoDescription());
+
+  // Undo entries oldest first, then redo entries next-to-redo first
+  HistoryWriter records;
+  for (const UndoableCommand* command : undoEntries) {
+    records.writeCommand(*command);
+  }
+  for (const UndoableCommand* command : redoEntries) {
+    records.writeCommand(*command);
+  }
+
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return false;
+    }
+
+    writeValue<uint32_t>(out, MAGIC);
+    writeValue<uint32_t>(out, VERSION);
+    writeValue<uint64_t>(out, hashContent(content));
+    writeValue<uint32_t>(out, static_cast<uint32_t>(header.data().size()));
+    out.write(header.data().data(), static_cast<std::streamsize>(header.data().size()));
+    out.write(records.data().data(), static_cast<std::streamsize>(records.data().size()));
+    if (!out) {
+      return false;
+    }
+  }
+
+  // Rename so a crash mid-write never leaves a truncated history behind
+  std::filesystem::rename(tempPath, path, ec);
+  return !ec;
+}
+
+bool UndoLog::peek(const std::string& dataFilename, uint64_t contentHash, Summary& summary) {
+  std::ifstream in(sidecarPath(dataFilename), std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  uint32_t headerLength = 0;
+  if (!readPrefix(in, contentHash, headerLength)) {
+    return false;
+  }
+  std::string header(headerLength, '\0');
+  if (!in.read(&header[0], headerLength)) {
+    return false;
+  }
+  return readSummary(header, summary);
+}
+
+bool UndoLog::load(const std::string& dataFilename, uint64_t contentHash, TaskManager& manager,
+                   UndoManager& history) {
+  std::ifstream in(sidecarPath(dataFilename), std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  uint32_t headerLength = 0;
+  if (!readPrefix(in, contentHash, headerLength)) {
+    return false;
+  }
+  std::string header(headerLength, '\0');
+  Summary summary;
+  if (!in.read(&header[0], headerLength) || !readSummary(header, summary)) {
+    return false;
+  }
+  std::string records((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  HistoryReader reader(records, &manager, &history);
+  std::vector<CommandPtr> undoEntries;
+  std::vector<CommandPtr> redoEntries;
+  for (size_t i = 0; i < summary.undoCount + summary.redoCount; i++) {
+    CommandPtr command = reader.readCommand();
+    if (!command) {
+      return false;
+    }
+    (i < summary.undoCount ? undoEntries : redoEntries).push_back(std::move(command));
+  }
+  if (!reader.atEnd()) {
+    return false;
+  }
+
+  history.restoreHistory(std::move(undoEntries), std::move(redoEntries));
+  return true;
+}
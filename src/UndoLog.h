@@ -0,0 +1,94 @@
+#ifndef UNDOLOG_H
+#define UNDOLOG_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "UndoManager.h"
+
+class TaskManager;
+
+// Appends command state as LEB128 varints (zigzag for signed values) and
+// length-prefixed strings. Most fields are small ids, lengths and flags, so
+// a typical edit costs a few dozen bytes on disk.
+class HistoryWriter {
+ public:
+  void writeVarint(uint64_t value);
+  void writeSigned(int64_t value);
+  void writeBool(bool value);
+  void writeString(std::string_view value);
+  // Type tag plus the command's serialize() output as a length-prefixed record
+  void writeCommand(const UndoableCommand& command);
+
+  const std::string& data() const { return buffer; }
+
+ private:
+  std::string buffer;
+};
+
+// Reads what HistoryWriter wrote. A read past the end or a malformed varint
+// returns zero/empty and makes ok() false for good, so deserialize() can read
+// every field and check once at the end.
+class HistoryReader {
+ public:
+  // Commands read through readCommand() are bound to manager and built in history's pool
+  HistoryReader(std::string_view data, TaskManager* manager, UndoManager* history);
+
+  uint64_t readVarint();
+  int64_t readSigned();
+  bool readBool();
+  std::string readString();
+  // A start time: H:MM/HH:MM within the day, anything else reads as empty (flexible)
+  std::string readTime();
+  // Null if the record is malformed or of an unknown type
+  CommandPtr readCommand();
+
+  bool ok() const { return valid; }
+  bool atEnd() const { return position == input.size(); }
+
+ private:
+  std::string_view input;
+  size_t position;
+  bool valid;
+  TaskManager* manager;
+  UndoManager* history;
+};
+
+// Sidecar file holding a data file's undo/redo history so it survives
+// restarts and file switches. Like the schedule sidecar it is keyed by a hash
+// of the data file's bytes; a file edited outside the TUI (or by a CLI
+// command) drops its history instead of replaying it against other tasks.
+//
+// The header carries the stack sizes and the top descriptions, so attaching
+// a history costs one small read; the command records are only parsed when
+// the history is first used.
+class UndoLog {
+ public:
+  // Bump whenever a command's serialize() output changes
+  static constexpr uint32_t VERSION = 2;
+
+  struct Summary {
+    size_t undoCount = 0;
+    size_t redoCount = 0;
+    std::string lastUndoDescription;
+    std::string lastRedoDescription;
+  };
+
+  // data/tasks_2024-01-15.json -> data/.tasks_2024-01-15.json.undo
+  static std::string sidecarPath(const std::string& dataFilename);
+
+  // Records history against the data file as it is on disk now (call right
+  // after saving it). An empty history removes the sidecar.
+  static bool store(const std::string& dataFilename, const UndoManager& history);
+
+  // Reads only the header; false if there is no sidecar or it was recorded
+  // against different contents
+  static bool peek(const std::string& dataFilename, uint64_t contentHash, Summary& summary);
+
+  // Reads every record and replaces history's entries with them; commands are
+  // bound to manager. Leaves history untouched on failure.
+  static bool load(const std::string& dataFilename, uint64_t contentHash, TaskManager& manager,
+                   UndoManager& history);
+};
+
+#endif  // UNDOLOG_H
@@ -1,6 +1,7 @@
 #include "UndoManager.h"
 #include "TaskManager.h"
 #include "Act.h"
+#include "UndoLog.h"
 #include <ctime>
 #include <iomanip>
 #include <sstream>
@@ -16,60 +17,342 @@ std::string getCurrentTimeString() {
     return oss.str();
 }
 
+// Helper for descriptions of boolean toggles
+static const char* yesNo(bool value) {
+    return value ? "Yes" : "No";
+}
+
+// CommandDeleter Implementation
+void CommandDeleter::operator()(UndoableCommand* command) const {
+    if (!command) {
+        return;
+    }
+    if (resource) {
+        void* memory = dynamic_cast<void*>(command);
+        command->~UndoableCommand();
+        resource->deallocate(memory, size, alignment);
+    } else {
+        delete command;
+    }
+}
+
+// PayloadArena Implementation
+PayloadArena::PayloadArena(std::pmr::memory_resource* upstreamResource)
+    : upstream(upstreamResource), bytesInUse(0) {
+}
+
+void* PayloadArena::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = upstream->allocate(bytes, alignment);
+    bytesInUse += bytes;
+    return pointer;
+}
+
+void PayloadArena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream->deallocate(pointer, bytes, alignment);
+    bytesInUse -= bytes;
+}
+
+bool PayloadArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
 // TaskManagerCommand Implementation
-TaskManagerCommand::TaskManagerCommand(TaskManager* mgr, const std::string& desc)
-    : manager(mgr), description(desc) {
+TaskManagerCommand::TaskManagerCommand(TaskManager* mgr)
+    : manager(mgr),
+      payloadArena(mgr ? mgr->getCommandResource() : std::pmr::get_default_resource()) {
+}
+
+std::pmr::memory_resource* TaskManagerCommand::payloadResource() {
+    return &payloadArena;
+}
+
+std::pmr::string TaskManagerCommand::taskNameAt(int index) {
+    std::pmr::string taskName(payloadResource());
+    if (index >= 0 && index < manager->taskSize()) {
+        taskName = manager->getTaskView(index).getName();
+    }
+    return taskName;
+}
+
+// SnapshotCommand Implementation
+SnapshotCommand::SnapshotCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), changes(payloadResource()), applied(false) {
+}
+
+bool SnapshotCommand::TaskState::operator==(const TaskState& other) const {
+    return name == other.name && startTime == other.startTime && length == other.length &&
+           fixed == other.fixed && rigid == other.rigid;
+}
+
+SnapshotCommand::TaskState SnapshotCommand::stateOf(const Act& task) {
+    return TaskState{task.getName(), task.isFixed() ? task.getStartStr() : "", task.getLength(),
+                     task.isFixed(), task.isRigid()};
+}
+
+void SnapshotCommand::execute() {
+    if (applied) {
+        // Redo: the result is already known
+        restore(true);
+    } else {
+        TaskList before = manager->snapshotTasks();
+        if (!apply()) {
+            return;
+        }
+        TaskList after = manager->snapshotTasks();
+
+        // apply() edits tasks in place, so both lists hold the same tasks in the same order
+        after.forEachUnshared(before, [&](size_t position) {
+            const Act& was = before[position];
+            const Act& now = after[position];
+            TaskState oldState = stateOf(was);
+            TaskState newState = stateOf(now);
+            if (was.getId() == now.getId() && !(oldState == newState)) {
+                changes.push_back({now.getId(), std::move(oldState), std::move(newState)});
+            }
+        });
+        applied = true;
+    }
+
+    // Trigger recalculation
+    manager->recalculate();
+}
+
+void SnapshotCommand::undo() {
+    if (applied) {
+        restore(false);
+
+        // Trigger recalculation
+        manager->recalculate();
+    }
+}
+
+void SnapshotCommand::restore(bool toAfter) {
+    for (const auto& change : changes) {
+        int taskIndex = manager->getTaskIndex(change.taskId);
+        if (taskIndex < 0) {
+            continue;
+        }
+        const TaskState& state = toAfter ? change.after : change.before;
+        auto& task = manager->getTaskRef(taskIndex);
+        try {
+            task.setName(state.name);
+            task.setLength(state.length);
+            task.setRigid(state.rigid);
+            if (!state.startTime.empty()) {
+                task.setStartTime(state.startTime);
+            }
+            if (task.isFixed() != state.fixed) {
+                task.setFixed(); // Toggle to match the recorded state
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error in SnapshotCommand::restore(): " << e.what() << std::endl;
+        }
+    }
 }
 
-std::string TaskManagerCommand::getDescription() const {
-    return description;
+size_t SnapshotCommand::getSnapshotFootprint() const {
+    const size_t inlineCapacity = std::string().capacity();
+    auto heapBytes = [inlineCapacity](const std::string& text) {
+        return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+    };
+    size_t bytes = 0;
+    for (const auto& change : changes) {
+        bytes += heapBytes(change.before.name) + heapBytes(change.before.startTime) +
+                 heapBytes(change.after.name) + heapBytes(change.after.startTime);
+    }
+    return bytes;
+}
+
+void SnapshotCommand::serializeSnapshot(HistoryWriter& out) const {
+    out.writeBool(applied);
+    if (!applied) {
+        return;
+    }
+
+    auto writeState = [&out](const TaskState& state) {
+        out.writeString(state.name);
+        out.writeString(state.startTime);
+        out.writeSigned(state.length);
+        out.writeBool(state.fixed);
+        out.writeBool(state.rigid);
+    };
+    out.writeVarint(changes.size());
+    for (const auto& change : changes) {
+        out.writeVarint(change.taskId);
+        writeState(change.before);
+        writeState(change.after);
+    }
+}
+
+bool SnapshotCommand::deserializeSnapshot(HistoryReader& in) {
+    auto readState = [&in]() {
+        TaskState state;
+        state.name = in.readString();
+        state.startTime = in.readTime();
+        state.length = static_cast<int>(in.readSigned());
+        state.fixed = in.readBool();
+        state.rigid = in.readBool();
+        return state;
+    };
+
+    applied = in.readBool();
+    changes.clear();
+    if (applied) {
+        uint64_t count = in.readVarint();
+        for (uint64_t i = 0; i < count && in.ok(); i++) {
+            TaskChange change;
+            change.taskId = in.readVarint();
+            change.before = readState();
+            change.after = readState();
+            changes.push_back(std::move(change));
+        }
+    }
+    return in.ok();
 }
 
 // AddTaskCommand Implementation
 AddTaskCommand::AddTaskCommand(TaskManager* mgr, const std::string& taskName,
                                const std::string& start, int len, bool rigid)
-    : TaskManagerCommand(mgr, "Add task '" + taskName + "'"),
-      name(taskName), startTime(start), length(len), isRigid(rigid),
-      hasStartTime(true), insertIndex(-1) {
+    : TaskManagerCommand(mgr),
+      name(taskName, payloadResource()), startTime(start, payloadResource()), length(len), isRigid(rigid),
+      hasStartTime(true), taskId(0) {
 }
 
 AddTaskCommand::AddTaskCommand(TaskManager* mgr, const std::string& taskName,
                                int len, bool rigid)
-    : TaskManagerCommand(mgr, "Add task '" + taskName + "'"),
-      name(taskName), startTime(""), length(len), isRigid(rigid),
-      hasStartTime(false), insertIndex(-1) {
+    : TaskManagerCommand(mgr),
+      name(taskName, payloadResource()), startTime(payloadResource()), length(len), isRigid(rigid),
+      hasStartTime(false), taskId(0) {
+}
+
+AddTaskCommand::AddTaskCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr),
+      name(payloadResource()), startTime(payloadResource()), length(0), isRigid(false),
+      hasStartTime(false), taskId(0) {
+}
+
+std::string AddTaskCommand::getDescription() const {
+    return "Add task '" + std::string(name) + "'";
 }
 
 void AddTaskCommand::execute() {
-    if (hasStartTime) {
-        manager->addTask(name, startTime, length, isRigid);
-    } else {
-        manager->addTask(name, length, isRigid);
-    }
-    insertIndex = manager->taskSize() - 1; // Task was added at the end
+    Act task = hasStartTime ? Act(std::string(name), std::string(startTime), length, isRigid)
+                            : Act(std::string(name), length, isRigid);
+    task.setId(taskId); // Redo brings back the same task, so later commands still find it
+    manager->insertTaskAt(insertPosition(), task);
+    taskId = task.getId();
+}
+
+int AddTaskCommand::insertPosition() const {
+    return manager->taskSize();
 }
 
 void AddTaskCommand::undo() {
-    if (insertIndex >= 0 && insertIndex < manager->taskSize()) {
-        manager->deleteTask(insertIndex);
+    int index = manager->getTaskIndex(taskId);
+    if (index >= 0) {
+        manager->deleteTask(index);
     }
 }
 
 size_t AddTaskCommand::getMemoryFootprint() const {
-    return sizeof(*this) + name.size() + startTime.size();
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType AddTaskCommand::getType() const {
+    return CommandType::AddTask;
+}
+
+void AddTaskCommand::serialize(HistoryWriter& out) const {
+    out.writeString(name);
+    out.writeString(startTime);
+    out.writeSigned(length);
+    out.writeBool(isRigid);
+    out.writeBool(hasStartTime);
+    out.writeVarint(taskId);
+}
+
+bool AddTaskCommand::deserialize(HistoryReader& in) {
+    name = in.readString();
+    startTime = in.readTime();
+    length = static_cast<int>(in.readSigned());
+    isRigid = in.readBool();
+    hasStartTime = in.readBool();
+    taskId = in.readVarint();
+    return in.ok();
+}
+
+// InsertTaskCommand Implementation
+InsertTaskCommand::InsertTaskCommand(TaskManager* mgr, int index, const std::string& taskName,
+                                     const std::string& start, int len, bool rigid)
+    : AddTaskCommand(mgr, taskName, start, len, rigid), followingTaskId(mgr->getTaskId(index)) {
+}
+
+InsertTaskCommand::InsertTaskCommand(TaskManager* mgr, int index, const std::string& taskName, int len, bool rigid)
+    : AddTaskCommand(mgr, taskName, len, rigid), followingTaskId(mgr->getTaskId(index)) {
+}
+
+InsertTaskCommand::InsertTaskCommand(TaskManager* mgr)
+    : AddTaskCommand(mgr), followingTaskId(0) {
+}
+
+int InsertTaskCommand::insertPosition() const {
+    int position = followingTaskId != 0 ? manager->getTaskIndex(followingTaskId) : -1;
+    return position >= 0 ? position : manager->taskSize();
+}
+
+std::string InsertTaskCommand::getDescription() const {
+    // Inserted blank and named by the edit that follows
+    return name.empty() ? "Insert task" : "Insert task '" + std::string(name) + "'";
+}
+
+size_t InsertTaskCommand::getMemoryFootprint() const {
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType InsertTaskCommand::getType() const {
+    return CommandType::InsertTask;
+}
+
+void InsertTaskCommand::serialize(HistoryWriter& out) const {
+    AddTaskCommand::serialize(out);
+    out.writeVarint(followingTaskId);
+}
+
+bool InsertTaskCommand::deserialize(HistoryReader& in) {
+    if (!AddTaskCommand::deserialize(in)) {
+        return false;
+    }
+    followingTaskId = in.readVarint();
+    return in.ok();
 }
 
 // DeleteTaskCommand Implementation
 DeleteTaskCommand::DeleteTaskCommand(TaskManager* mgr, int taskIndex)
-    : TaskManagerCommand(mgr, "Delete task"),
-      index(taskIndex), deletedLength(0), deletedRigid(false),
-      deletedFixed(false), taskWasDeleted(false) {
+    : TaskManagerCommand(mgr), taskId(mgr->getTaskId(taskIndex)), followingTaskId(0),
+      index(taskIndex), deletedName(payloadResource()), deletedStartTime(payloadResource()),
+      deletedLength(0), deletedRigid(false), deletedFixed(false), taskWasDeleted(false) {
+}
+
+DeleteTaskCommand::DeleteTaskCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), taskId(0), followingTaskId(0), index(-1),
+      deletedName(payloadResource()), deletedStartTime(payloadResource()),
+      deletedLength(0), deletedRigid(false), deletedFixed(false), taskWasDeleted(false) {
+}
+
+std::string DeleteTaskCommand::getDescription() const {
+    // The name is only known once the command has run
+    if (deletedName.empty()) {
+        return "Delete task";
+    }
+    return "Delete task '" + std::string(deletedName) + "'";
 }
 
 void DeleteTaskCommand::execute() {
-    if (index >= 0 && index < manager->taskSize()) {
+    index = manager->getTaskIndex(taskId);
+    if (index >= 0) {
         // Store the task data before deletion
         try {
+            followingTaskId = manager->getTaskId(index + 1);
             Act task = manager->getTask(index);
             deletedName = task.getName();
             deletedStartTime = task.getStartStr();
@@ -77,9 +360,6 @@ void DeleteTaskCommand::execute() {
             deletedRigid = task.isRigid();
             deletedFixed = task.isFixed();
 
-            // Update description with actual task name
-            description = "Delete task '" + deletedName + "'";
-
             // Perform the deletion
             taskWasDeleted = manager->deleteTask(index);
         } catch (const std::exception& e) {
@@ -94,13 +374,18 @@ void DeleteTaskCommand::execute() {
 void DeleteTaskCommand::undo() {
     if (taskWasDeleted) {
         try {
-            if (deletedFixed && !deletedStartTime.empty()) {
-                // Restore fixed task with start time
-                manager->insertTask(index, deletedName, deletedStartTime, deletedLength, deletedRigid);
-            } else {
-                // Restore flexible task
-                manager->insertTask(index, deletedName, deletedLength, deletedRigid);
+            // Restore fixed task with start time, or flexible task
+            Act task = (deletedFixed && !deletedStartTime.empty())
+                           ? Act(std::string(deletedName), std::string(deletedStartTime), deletedLength, deletedRigid)
+                           : Act(std::string(deletedName), deletedLength, deletedRigid);
+            task.setId(taskId);
+
+            // Put it back in front of the task that followed it
+            int position = followingTaskId != 0 ? manager->getTaskIndex(followingTaskId) : manager->taskSize();
+            if (position < 0) {
+                position = std::min(index, manager->taskSize());
             }
+            manager->insertTaskAt(position, task);
         } catch (const std::exception& e) {
             std::cerr << "Error in DeleteTaskCommand::undo(): " << e.what() << std::endl;
         }
@@ -108,60 +393,137 @@ void DeleteTaskCommand::undo() {
 }
 
 size_t DeleteTaskCommand::getMemoryFootprint() const {
-    return sizeof(*this) + deletedName.size() + deletedStartTime.size();
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType DeleteTaskCommand::getType() const {
+    return CommandType::DeleteTask;
+}
+
+void DeleteTaskCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeVarint(followingTaskId);
+    out.writeSigned(index);
+    out.writeString(deletedName);
+    out.writeString(deletedStartTime);
+    out.writeSigned(deletedLength);
+    out.writeBool(deletedRigid);
+    out.writeBool(deletedFixed);
+    out.writeBool(taskWasDeleted);
+}
+
+bool DeleteTaskCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    followingTaskId = in.readVarint();
+    index = static_cast<int>(in.readSigned());
+    deletedName = in.readString();
+    deletedStartTime = in.readTime();
+    deletedLength = static_cast<int>(in.readSigned());
+    deletedRigid = in.readBool();
+    deletedFixed = in.readBool();
+    taskWasDeleted = in.readBool();
+    return in.ok();
 }
 
 // EditTaskNameCommand Implementation
 EditTaskNameCommand::EditTaskNameCommand(TaskManager* mgr, int index, const std::string& oldValue, const std::string& newValue)
-    : TaskManagerCommand(mgr, "Changed task name from '" + oldValue + "' to '" + newValue + "'"),
-      taskIndex(index), oldName(oldValue), newName(newValue), wasExecuted(false) {
+    : TaskManagerCommand(mgr),
+      taskId(mgr->getTaskId(index)), oldName(oldValue, payloadResource()), newName(newValue, payloadResource()), wasExecuted(false) {
+}
+
+EditTaskNameCommand::EditTaskNameCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr),
+      taskId(0), oldName(payloadResource()), newName(payloadResource()), wasExecuted(false) {
+}
+
+std::string EditTaskNameCommand::getDescription() const {
+    return "Changed task name from '" + std::string(oldName) + "' to '" + std::string(newName) + "'";
 }
 
 void EditTaskNameCommand::execute() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
-        task.setName(newName);
+        task.setName(std::string(newName));
         wasExecuted = true;
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 void EditTaskNameCommand::undo() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
-        task.setName(oldName);
+        task.setName(std::string(oldName));
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 size_t EditTaskNameCommand::getMemoryFootprint() const {
-    return sizeof(*this) + oldName.size() + newName.size();
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType EditTaskNameCommand::getType() const {
+    return CommandType::EditTaskName;
+}
+
+void EditTaskNameCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeString(oldName);
+    out.writeString(newName);
+    out.writeBool(wasExecuted);
+}
+
+bool EditTaskNameCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    oldName = in.readString();
+    newName = in.readString();
+    wasExecuted = in.readBool();
+    return in.ok();
+}
+
+bool EditTaskNameCommand::mergeWith(const UndoableCommand& next) {
+    if (next.getType() != getType()) {
+        return false;
+    }
+    const auto& edit = static_cast<const EditTaskNameCommand&>(next);
+    if (edit.taskId != taskId || !wasExecuted || !edit.wasExecuted) {
+        return false;
+    }
+    newName = edit.newName;
+    return true;
 }
 
 // EditTaskStartTimeCommand Implementation
 EditTaskStartTimeCommand::EditTaskStartTimeCommand(TaskManager* mgr, int index, const std::string& oldValue, const std::string& newValue, bool oldFixedState, bool newFixedState)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), oldStartTime(oldValue), newStartTime(newValue),
+    : TaskManagerCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)),
+      oldStartTime(oldValue, payloadResource()), newStartTime(newValue, payloadResource()),
       oldFixed(oldFixedState), newFixed(newFixedState), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        std::string oldDisplay = oldValue.empty() ? "flexible" : oldValue;
-        std::string newDisplay = newValue.empty() ? "flexible" : newValue;
-        setDescription("Changed task '" + taskName + "' start time from " + oldDisplay + " to " + newDisplay);
-    } else {
-        setDescription("Changed task start time from '" + oldValue + "' to '" + newValue + "'");
+}
+
+EditTaskStartTimeCommand::EditTaskStartTimeCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), taskId(0), taskName(payloadResource()),
+      oldStartTime(payloadResource()), newStartTime(payloadResource()),
+      oldFixed(false), newFixed(false), wasExecuted(false) {
+}
+
+std::string EditTaskStartTimeCommand::getDescription() const {
+    std::string oldValue(oldStartTime);
+    std::string newValue(newStartTime);
+    if (taskName.empty()) {
+        return "Changed task start time from '" + oldValue + "' to '" + newValue + "'";
     }
+    std::string oldDisplay = oldValue.empty() ? "flexible" : oldValue;
+    std::string newDisplay = newValue.empty() ? "flexible" : newValue;
+    return "Changed task '" + std::string(taskName) + "' start time from " + oldDisplay + " to " + newDisplay;
 }
 
 void EditTaskStartTimeCommand::execute() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
 
@@ -172,7 +534,7 @@ void EditTaskStartTimeCommand::execute() {
             }
         } else {
             // Set start time and make task fixed
-            task.setStartTime(newStartTime);
+            task.setStartTime(std::string(newStartTime));
             if (!task.isFixed()) {
                 task.setFixed(); // Toggle to make it fixed
             }
@@ -181,13 +543,12 @@ void EditTaskStartTimeCommand::execute() {
         wasExecuted = true;
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 void EditTaskStartTimeCommand::undo() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
 
@@ -199,7 +560,7 @@ void EditTaskStartTimeCommand::undo() {
             }
         } else {
             // Set old start time
-            task.setStartTime(oldStartTime);
+            task.setStartTime(std::string(oldStartTime));
         }
 
         // Restore old fixed state
@@ -208,353 +569,528 @@ void EditTaskStartTimeCommand::undo() {
         }
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 size_t EditTaskStartTimeCommand::getMemoryFootprint() const {
-    return sizeof(*this) + oldStartTime.size() + newStartTime.size();
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType EditTaskStartTimeCommand::getType() const {
+    return CommandType::EditTaskStartTime;
+}
+
+void EditTaskStartTimeCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeString(oldStartTime);
+    out.writeString(newStartTime);
+    out.writeBool(oldFixed);
+    out.writeBool(newFixed);
+    out.writeBool(wasExecuted);
+}
+
+bool EditTaskStartTimeCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    taskName = in.readString();
+    oldStartTime = in.readTime();
+    newStartTime = in.readTime();
+    oldFixed = in.readBool();
+    newFixed = in.readBool();
+    wasExecuted = in.readBool();
+    return in.ok();
+}
+
+bool EditTaskStartTimeCommand::mergeWith(const UndoableCommand& next) {
+    if (next.getType() != getType()) {
+        return false;
+    }
+    const auto& edit = static_cast<const EditTaskStartTimeCommand&>(next);
+    if (edit.taskId != taskId || !wasExecuted || !edit.wasExecuted) {
+        return false;
+    }
+    newStartTime = edit.newStartTime;
+    newFixed = edit.newFixed;
+    return true;
 }
 
 // EditTaskLengthCommand Implementation
 EditTaskLengthCommand::EditTaskLengthCommand(TaskManager* mgr, int index, int oldValue, int newValue)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), oldLength(oldValue), newLength(newValue), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        setDescription("Changed task '" + taskName + "' length from " + std::to_string(oldValue) + " to " + std::to_string(newValue) + " minutes");
-    } else {
-        setDescription("Changed task length from " + std::to_string(oldValue) + " to " + std::to_string(newValue));
+    : TaskManagerCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)),
+      oldLength(oldValue), newLength(newValue), wasExecuted(false) {
+}
+
+EditTaskLengthCommand::EditTaskLengthCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), taskId(0), taskName(payloadResource()),
+      oldLength(0), newLength(0), wasExecuted(false) {
+}
+
+std::string EditTaskLengthCommand::getDescription() const {
+    if (taskName.empty()) {
+        return "Changed task length from " + std::to_string(oldLength) + " to " + std::to_string(newLength);
     }
+    return "Changed task '" + std::string(taskName) + "' length from " + std::to_string(oldLength) +
+           " to " + std::to_string(newLength) + " minutes";
 }
 
 void EditTaskLengthCommand::execute() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
         task.setLength(newLength);
         wasExecuted = true;
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 void EditTaskLengthCommand::undo() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize()) {
         auto& task = manager->getTaskRef(taskIndex);
         task.setLength(oldLength);
 
         // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+        manager->recalculate();
     }
 }
 
 size_t EditTaskLengthCommand::getMemoryFootprint() const {
-    return sizeof(*this);
+    return sizeof(*this) + payloadArena.getBytesInUse();
 }
 
-// ToggleTaskFixedCommand Implementation
-ToggleTaskFixedCommand::ToggleTaskFixedCommand(TaskManager* mgr, int index, bool oldValue)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), oldFixed(oldValue), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        setDescription("Toggled task '" + taskName + "' fixed status from " +
-                      std::string(oldValue ? "Yes" : "No") + " to " +
-                      std::string(!oldValue ? "Yes" : "No"));
-    } else {
-        setDescription("Toggled task fixed status from " + std::string(oldValue ? "Yes" : "No") + " to " + std::string(!oldValue ? "Yes" : "No"));
-    }
+CommandType EditTaskLengthCommand::getType() const {
+    return CommandType::EditTaskLength;
 }
 
-void ToggleTaskFixedCommand::execute() {
-    if (taskIndex >= 0 && taskIndex < manager->taskSize()) {
-        auto& task = manager->getTaskRef(taskIndex);
-        task.setFixed(); // Toggle fixed state
-        wasExecuted = true;
+void EditTaskLengthCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeSigned(oldLength);
+    out.writeSigned(newLength);
+    out.writeBool(wasExecuted);
+}
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+bool EditTaskLengthCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    taskName = in.readString();
+    oldLength = static_cast<int>(in.readSigned());
+    newLength = static_cast<int>(in.readSigned());
+    wasExecuted = in.readBool();
+    return in.ok();
+}
+
+bool EditTaskLengthCommand::mergeWith(const UndoableCommand& next) {
+    if (next.getType() != getType()) {
+        return false;
     }
+    const auto& edit = static_cast<const EditTaskLengthCommand&>(next);
+    if (edit.taskId != taskId || !wasExecuted || !edit.wasExecuted) {
+        return false;
+    }
+    newLength = edit.newLength;
+    return true;
 }
 
-void ToggleTaskFixedCommand::undo() {
-    if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize()) {
-        auto& task = manager->getTaskRef(taskIndex);
+// ToggleTaskFixedCommand Implementation
+ToggleTaskFixedCommand::ToggleTaskFixedCommand(TaskManager* mgr, int index, bool oldValue)
+    : SnapshotCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)), oldFixed(oldValue) {
+}
 
-        // Toggle back to original state
-        if (task.isFixed() != oldFixed) {
-            task.setFixed(); // Toggle to restore original state
-        }
+ToggleTaskFixedCommand::ToggleTaskFixedCommand(TaskManager* mgr)
+    : SnapshotCommand(mgr), taskId(0), taskName(payloadResource()), oldFixed(false) {
+}
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+std::string ToggleTaskFixedCommand::getDescription() const {
+    std::string subject = taskName.empty() ? "task" : "task '" + std::string(taskName) + "'";
+    return "Toggled " + subject + " fixed status from " + yesNo(oldFixed) + " to " + yesNo(!oldFixed);
+}
+
+bool ToggleTaskFixedCommand::apply() {
+    int taskIndex = manager->getTaskIndex(taskId);
+    if (taskIndex < 0 || taskIndex >= manager->taskSize()) {
+        return false;
     }
+    manager->getTaskRef(taskIndex).setFixed(); // Toggle fixed state
+    return true;
 }
 
 size_t ToggleTaskFixedCommand::getMemoryFootprint() const {
-    return sizeof(*this);
+    return sizeof(*this) + payloadArena.getBytesInUse() + getSnapshotFootprint();
 }
 
-// ToggleTaskRigidCommand Implementation
-ToggleTaskRigidCommand::ToggleTaskRigidCommand(TaskManager* mgr, int index, bool oldValue)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), oldRigid(oldValue), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        setDescription("Toggled task '" + taskName + "' rigid status from " +
-                      std::string(oldValue ? "Yes" : "No") + " to " +
-                      std::string(!oldValue ? "Yes" : "No"));
-    } else {
-        setDescription("Toggled task rigid status from " + std::string(oldValue ? "Yes" : "No") + " to " + std::string(!oldValue ? "Yes" : "No"));
-    }
+CommandType ToggleTaskFixedCommand::getType() const {
+    return CommandType::ToggleTaskFixed;
 }
 
-void ToggleTaskRigidCommand::execute() {
-    if (taskIndex >= 0 && taskIndex < manager->taskSize()) {
-        auto& task = manager->getTaskRef(taskIndex);
-        task.setRigid(!task.isRigid()); // Toggle rigid state
-        wasExecuted = true;
+void ToggleTaskFixedCommand::serialize(HistoryWriter& out) const {
+    serializeSnapshot(out);
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeBool(oldFixed);
+}
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+bool ToggleTaskFixedCommand::deserialize(HistoryReader& in) {
+    if (!deserializeSnapshot(in)) {
+        return false;
     }
+    taskId = in.readVarint();
+    taskName = in.readString();
+    oldFixed = in.readBool();
+    return in.ok();
 }
 
-void ToggleTaskRigidCommand::undo() {
-    if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize()) {
-        auto& task = manager->getTaskRef(taskIndex);
-        task.setRigid(oldRigid); // Restore original state
+// ToggleTaskRigidCommand Implementation
+ToggleTaskRigidCommand::ToggleTaskRigidCommand(TaskManager* mgr, int index, bool oldValue)
+    : SnapshotCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)), oldRigid(oldValue) {
+}
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+ToggleTaskRigidCommand::ToggleTaskRigidCommand(TaskManager* mgr)
+    : SnapshotCommand(mgr), taskId(0), taskName(payloadResource()), oldRigid(false) {
+}
+
+std::string ToggleTaskRigidCommand::getDescription() const {
+    std::string subject = taskName.empty() ? "task" : "task '" + std::string(taskName) + "'";
+    return "Toggled " + subject + " rigid status from " + yesNo(oldRigid) + " to " + yesNo(!oldRigid);
+}
+
+bool ToggleTaskRigidCommand::apply() {
+    int taskIndex = manager->getTaskIndex(taskId);
+    if (taskIndex < 0 || taskIndex >= manager->taskSize()) {
+        return false;
     }
+    auto& task = manager->getTaskRef(taskIndex);
+    task.setRigid(!task.isRigid()); // Toggle rigid state
+    return true;
 }
 
 size_t ToggleTaskRigidCommand::getMemoryFootprint() const {
-    return sizeof(*this);
+    return sizeof(*this) + payloadArena.getBytesInUse() + getSnapshotFootprint();
+}
+
+CommandType ToggleTaskRigidCommand::getType() const {
+    return CommandType::ToggleTaskRigid;
+}
+
+void ToggleTaskRigidCommand::serialize(HistoryWriter& out) const {
+    serializeSnapshot(out);
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeBool(oldRigid);
+}
+
+bool ToggleTaskRigidCommand::deserialize(HistoryReader& in) {
+    if (!deserializeSnapshot(in)) {
+        return false;
+    }
+    taskId = in.readVarint();
+    taskName = in.readString();
+    oldRigid = in.readBool();
+    return in.ok();
 }
 
 // MoveTaskUpCommand Implementation
 MoveTaskUpCommand::MoveTaskUpCommand(TaskManager* mgr, int index, bool taskWasFixed)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), wasFixed(taskWasFixed), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        setDescription("Moved task '" + taskName + "' up");
-    } else {
-        setDescription("Move task up");
+    : TaskManagerCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)), wasFixed(taskWasFixed),
+      distance(1), wasExecuted(false) {
+}
+
+MoveTaskUpCommand::MoveTaskUpCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), taskId(0), taskName(payloadResource()), wasFixed(false), distance(1), wasExecuted(false) {
+}
+
+std::string MoveTaskUpCommand::getDescription() const {
+    if (taskName.empty()) {
+        return "Move task up";
+    }
+    std::string text = "Moved task '" + std::string(taskName) + "' up";
+    if (distance > 1) {
+        text += " " + std::to_string(distance) + " positions";
     }
+    return text;
 }
 
 void MoveTaskUpCommand::execute() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (taskIndex > 0 && taskIndex < manager->taskSize()) {
         // Remove fixed status if task was fixed (as per existing behavior)
-        auto& task = manager->getTaskRef(taskIndex);
-        if (task.isFixed()) {
-            task.setFixed(); // Toggle to remove fixed status
+        if (manager->getTaskView(taskIndex).isFixed()) {
+            manager->getTaskRef(taskIndex).setFixed(); // Toggle to remove fixed status
         }
 
-        if (manager->moveTaskUp(taskIndex)) {
+        // A merged command redoes every step it took, as far as the list allows
+        int moved = 0;
+        while (moved < distance && manager->moveTaskUp(taskIndex - moved)) {
+            moved++;
+        }
+        if (moved > 0) {
+            distance = moved;
             wasExecuted = true;
 
             // Trigger recalculation
-            bool hasWarnings = false;
-            manager->calcActLen(hasWarnings);
-            manager->calcStartTimes();
+            manager->recalculate();
         }
     }
 }
 
 void MoveTaskUpCommand::undo() {
-    if (wasExecuted && taskIndex > 0 && taskIndex < manager->taskSize()) {
+    int taskIndex = manager->getTaskIndex(taskId);
+    if (wasExecuted && taskIndex >= 0) {
         // Move task back down to original position
-        if (manager->moveTaskDown(taskIndex - 1)) {
+        int moved = 0;
+        while (moved < distance && manager->moveTaskDown(taskIndex + moved)) {
+            moved++;
+        }
+        if (moved > 0) {
             // Restore fixed status if it was originally fixed
             if (wasFixed) {
-                auto& task = manager->getTaskRef(taskIndex);
-                if (!task.isFixed()) {
-                    task.setFixed(); // Toggle to restore fixed status
+                if (!manager->getTaskView(taskIndex + moved).isFixed()) {
+                    manager->getTaskRef(taskIndex + moved).setFixed(); // Toggle to restore fixed status
                 }
             }
 
             // Trigger recalculation
-            bool hasWarnings = false;
-            manager->calcActLen(hasWarnings);
-            manager->calcStartTimes();
+            manager->recalculate();
         }
     }
 }
 
 size_t MoveTaskUpCommand::getMemoryFootprint() const {
-    return sizeof(*this);
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType MoveTaskUpCommand::getType() const {
+    return CommandType::MoveTaskUp;
+}
+
+void MoveTaskUpCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeBool(wasFixed);
+    out.writeSigned(distance);
+    out.writeBool(wasExecuted);
+}
+
+bool MoveTaskUpCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    taskName = in.readString();
+    wasFixed = in.readBool();
+    distance = static_cast<int>(in.readSigned());
+    wasExecuted = in.readBool();
+    return in.ok() && distance > 0;
+}
+
+bool MoveTaskUpCommand::mergeWith(const UndoableCommand& next) {
+    if (next.getType() != getType()) {
+        return false;
+    }
+    const auto& move = static_cast<const MoveTaskUpCommand&>(next);
+    if (move.taskId != taskId || !wasExecuted) {
+        return false;
+    }
+    // A move that hit the top of the list did nothing; absorbing it is harmless
+    if (move.wasExecuted) {
+        distance += move.distance;
+    }
+    return true;
 }
 
 // MoveTaskDownCommand Implementation
 MoveTaskDownCommand::MoveTaskDownCommand(TaskManager* mgr, int index, bool taskWasFixed)
-    : TaskManagerCommand(mgr, ""), taskIndex(index), wasFixed(taskWasFixed), wasExecuted(false) {
-    // Set description with task name
-    if (index >= 0 && index < mgr->taskSize()) {
-        std::string taskName = mgr->getTaskRef(index).getName();
-        setDescription("Moved task '" + taskName + "' down");
-    } else {
-        setDescription("Move task down");
+    : TaskManagerCommand(mgr), taskId(mgr->getTaskId(index)), taskName(taskNameAt(index)), wasFixed(taskWasFixed),
+      distance(1), wasExecuted(false) {
+}
+
+MoveTaskDownCommand::MoveTaskDownCommand(TaskManager* mgr)
+    : TaskManagerCommand(mgr), taskId(0), taskName(payloadResource()), wasFixed(false), distance(1), wasExecuted(false) {
+}
+
+std::string MoveTaskDownCommand::getDescription() const {
+    if (taskName.empty()) {
+        return "Move task down";
+    }
+    std::string text = "Moved task '" + std::string(taskName) + "' down";
+    if (distance > 1) {
+        text += " " + std::to_string(distance) + " positions";
     }
+    return text;
 }
 
 void MoveTaskDownCommand::execute() {
+    int taskIndex = manager->getTaskIndex(taskId);
     if (taskIndex >= 0 && taskIndex < manager->taskSize() - 1) {
         // Remove fixed status if task was fixed (as per existing behavior)
-        auto& task = manager->getTaskRef(taskIndex);
-        if (task.isFixed()) {
-            task.setFixed(); // Toggle to remove fixed status
+        if (manager->getTaskView(taskIndex).isFixed()) {
+            manager->getTaskRef(taskIndex).setFixed(); // Toggle to remove fixed status
         }
 
-        if (manager->moveTaskDown(taskIndex)) {
+        // A merged command redoes every step it took, as far as the list allows
+        int moved = 0;
+        while (moved < distance && manager->moveTaskDown(taskIndex + moved)) {
+            moved++;
+        }
+        if (moved > 0) {
+            distance = moved;
             wasExecuted = true;
 
             // Trigger recalculation
-            bool hasWarnings = false;
-            manager->calcActLen(hasWarnings);
-            manager->calcStartTimes();
+            manager->recalculate();
         }
     }
 }
 
 void MoveTaskDownCommand::undo() {
-    if (wasExecuted && taskIndex >= 0 && taskIndex < manager->taskSize() - 1) {
+    int taskIndex = manager->getTaskIndex(taskId);
+    if (wasExecuted && taskIndex >= 0) {
         // Move task back up to original position
-        if (manager->moveTaskUp(taskIndex + 1)) {
+        int moved = 0;
+        while (moved < distance && manager->moveTaskUp(taskIndex - moved)) {
+            moved++;
+        }
+        if (moved > 0) {
             // Restore fixed status if it was originally fixed
             if (wasFixed) {
-                auto& task = manager->getTaskRef(taskIndex);
-                if (!task.isFixed()) {
-                    task.setFixed(); // Toggle to restore fixed status
+                if (!manager->getTaskView(taskIndex - moved).isFixed()) {
+                    manager->getTaskRef(taskIndex - moved).setFixed(); // Toggle to restore fixed status
                 }
             }
 
             // Trigger recalculation
-            bool hasWarnings = false;
-            manager->calcActLen(hasWarnings);
-            manager->calcStartTimes();
+            manager->recalculate();
         }
     }
 }
 
 size_t MoveTaskDownCommand::getMemoryFootprint() const {
-    return sizeof(*this);
+    return sizeof(*this) + payloadArena.getBytesInUse();
+}
+
+CommandType MoveTaskDownCommand::getType() const {
+    return CommandType::MoveTaskDown;
+}
+
+void MoveTaskDownCommand::serialize(HistoryWriter& out) const {
+    out.writeVarint(taskId);
+    out.writeString(taskName);
+    out.writeBool(wasFixed);
+    out.writeSigned(distance);
+    out.writeBool(wasExecuted);
+}
+
+bool MoveTaskDownCommand::deserialize(HistoryReader& in) {
+    taskId = in.readVarint();
+    taskName = in.readString();
+    wasFixed = in.readBool();
+    distance = static_cast<int>(in.readSigned());
+    wasExecuted = in.readBool();
+    return in.ok() && distance > 0;
+}
+
+bool MoveTaskDownCommand::mergeWith(const UndoableCommand& next) {
+    if (next.getType() != getType()) {
+        return false;
+    }
+    const auto& move = static_cast<const MoveTaskDownCommand&>(next);
+    if (move.taskId != taskId || !wasExecuted) {
+        return false;
+    }
+    // A move that hit the bottom of the list did nothing; absorbing it is harmless
+    if (move.wasExecuted) {
+        distance += move.distance;
+    }
+    return true;
 }
 
 // StartTaskTimerCommand Implementation
 StartTaskTimerCommand::StartTaskTimerCommand(TaskManager* mgr, int index)
-    : TaskManagerCommand(mgr, ""), wasExecuted(false) {
+    : SnapshotCommand(mgr), affectedTasks(payloadResource()), taskName(taskNameAt(index)) {
 
     if (index >= 0 && index < mgr->taskSize()) {
         timerStartTime = getCurrentTimeString();
 
         // Calculate all cascading updates needed
         calculateCascadingUpdates(mgr, index);
+    }
+}
 
-        // Set description based on affected tasks
-        if (affectedTasks.size() == 1) {
-            std::string taskName = mgr->getTaskRef(index).getName();
-            setDescription("Started timer for task '" + taskName + "' at " + timerStartTime);
-        } else {
-            std::string taskName = mgr->getTaskRef(index).getName();
-            setDescription("Started timer for task '" + taskName + "' at " + timerStartTime +
-                          " (updated " + std::to_string(affectedTasks.size() - 1) + " subsequent tasks)");
-        }
-    } else {
-        setDescription("Start task timer");
-    }
-}
-
-void StartTaskTimerCommand::execute() {
-    if (!affectedTasks.empty()) {
-        // Apply all calculated updates
-        for (const auto& taskState : affectedTasks) {
-            if (taskState.index >= 0 && taskState.index < manager->taskSize()) {
-                auto& task = manager->getTaskRef(taskState.index);
-
-                // Set the new start time
-                if (taskState.newStartTime.empty()) {
-                    // Make task flexible
-                    if (task.isFixed()) {
-                        task.setFixed(); // Toggle to make flexible
-                    }
-                } else {
-                    // Set specific start time
-                    task.setStartTime(taskState.newStartTime);
-                }
+StartTaskTimerCommand::StartTaskTimerCommand(TaskManager* mgr)
+    : SnapshotCommand(mgr), affectedTasks(payloadResource()), taskName(payloadResource()) {
+}
 
-                // Set the new fixed status
-                if (task.isFixed() != taskState.newFixed) {
-                    task.setFixed(); // Toggle to match desired state
-                }
-            }
-        }
+std::string StartTaskTimerCommand::getDescription() const {
+    if (affectedTasks.empty()) {
+        return "Start task timer";
+    }
+    std::string text = "Started timer for task '" + std::string(taskName) + "' at " + timerStartTime;
+    if (affectedTasks.size() > 1) {
+        text += " (updated " + std::to_string(affectedTasks.size() - 1) + " subsequent tasks)";
+    }
+    return text;
+}
 
-        wasExecuted = true;
+bool StartTaskTimerCommand::apply() {
+    if (affectedTasks.empty()) {
+        return false;
+    }
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
-    }
-}
-
-void StartTaskTimerCommand::undo() {
-    if (wasExecuted && !affectedTasks.empty()) {
-        // Restore all affected tasks to their original states
-        for (const auto& taskState : affectedTasks) {
-            if (taskState.index >= 0 && taskState.index < manager->taskSize()) {
-                auto& task = manager->getTaskRef(taskState.index);
-
-                // Restore old start time
-                if (taskState.oldStartTime.empty()) {
-                    // Task was originally flexible - make it flexible again
-                    if (task.isFixed()) {
-                        task.setFixed(); // Toggle to make it flexible
-                    }
-                } else {
-                    // Task had a specific start time - restore it
-                    task.setStartTime(taskState.oldStartTime);
-                }
+    // Apply all calculated updates; undo puts back the states recorded around this
+    for (const auto& update : affectedTasks) {
+        int index = manager->getTaskIndex(update.taskId);
+        if (index >= 0) {
+            auto& task = manager->getTaskRef(index);
 
-                // Restore old fixed state
-                if (task.isFixed() != taskState.oldFixed) {
-                    task.setFixed(); // Toggle to match old state
-                }
+            // Set the new start time
+            if (!update.newStartTime.empty()) {
+                task.setStartTime(update.newStartTime);
             }
-        }
 
-        // Trigger recalculation
-        bool hasWarnings = false;
-        manager->calcActLen(hasWarnings);
-        manager->calcStartTimes();
+            // Set the new fixed status
+            if (task.isFixed() != update.newFixed) {
+                task.setFixed(); // Toggle to match desired state
+            }
+        }
     }
+    return true;
 }
 
 size_t StartTaskTimerCommand::getMemoryFootprint() const {
-    size_t total = sizeof(*this) + timerStartTime.size();
-    for (const auto& taskState : affectedTasks) {
-        total += sizeof(taskState) + taskState.oldStartTime.size() + taskState.newStartTime.size();
+    return sizeof(*this) + payloadArena.getBytesInUse() + getSnapshotFootprint();
+}
+
+CommandType StartTaskTimerCommand::getType() const {
+    return CommandType::StartTaskTimer;
+}
+
+void StartTaskTimerCommand::serialize(HistoryWriter& out) const {
+    serializeSnapshot(out);
+    out.writeVarint(affectedTasks.size());
+    for (const auto& update : affectedTasks) {
+        out.writeVarint(update.taskId);
+        out.writeString(update.newStartTime);
+        out.writeBool(update.newFixed);
     }
-    return total;
+    out.writeString(taskName);
+    out.writeString(timerStartTime);
+}
+
+bool StartTaskTimerCommand::deserialize(HistoryReader& in) {
+    if (!deserializeSnapshot(in)) {
+        return false;
+    }
+    affectedTasks.clear();
+    uint64_t count = in.readVarint();
+    for (uint64_t i = 0; i < count && in.ok(); i++) {
+        TaskUpdate update;
+        update.taskId = in.readVarint();
+        update.newStartTime = in.readTime();
+        update.newFixed = in.readBool();
+        affectedTasks.push_back(std::move(update));
+    }
+    taskName = in.readString();
+    timerStartTime = in.readTime();
+    return in.ok();
 }
 
 void StartTaskTimerCommand::calculateCascadingUpdates(TaskManager* mgr, int startIndex) {
@@ -563,20 +1099,18 @@ void StartTaskTimerCommand::calculateCascadingUpdates(TaskManager* mgr, int star
     }
 
     // First, add the target task (the one Alt+B was pressed on)
-    auto& targetTask = mgr->getTaskRef(startIndex);
-    TaskState targetState;
-    targetState.index = startIndex;
-    targetState.oldStartTime = targetTask.getStartStr();
-    targetState.oldFixed = targetTask.isFixed();
-    targetState.newStartTime = timerStartTime;
-    targetState.newFixed = true; // Timer start always makes task fixed
-    affectedTasks.push_back(targetState);
+    const auto& targetTask = mgr->getTaskView(startIndex);
+    TaskUpdate targetUpdate;
+    targetUpdate.taskId = mgr->getTaskId(startIndex);
+    targetUpdate.newStartTime = timerStartTime;
+    targetUpdate.newFixed = true; // Timer start always makes task fixed
+    affectedTasks.push_back(targetUpdate);
 
     // Now check subsequent tasks for conflicts
     std::string currentEndTime = calculateNextAvailableTime(timerStartTime, targetTask.getLength());
 
     for (int i = startIndex + 1; i < mgr->taskSize(); ++i) {
-        auto& task = mgr->getTaskRef(i);
+        const auto& task = mgr->getTaskView(i);
         std::string taskStartTime = task.getStartStr();
 
         // Check if this task has a start time that would create a conflict
@@ -593,13 +1127,11 @@ void StartTaskTimerCommand::calculateCascadingUpdates(TaskManager* mgr, int star
 
         if (hasConflict) {
             // This task needs to be updated to resolve the conflict
-            TaskState conflictState;
-            conflictState.index = i;
-            conflictState.oldStartTime = task.getStartStr();
-            conflictState.oldFixed = task.isFixed();
-            conflictState.newStartTime = currentEndTime; // Start when previous task ends
-            conflictState.newFixed = true; // Make it fixed to maintain the sequence
-            affectedTasks.push_back(conflictState);
+            TaskUpdate conflictUpdate;
+            conflictUpdate.taskId = mgr->getTaskId(i);
+            conflictUpdate.newStartTime = currentEndTime; // Start when previous task ends
+            conflictUpdate.newFixed = true; // Make it fixed to maintain the sequence
+            affectedTasks.push_back(conflictUpdate);
 
             // Update currentEndTime for the next iteration
             currentEndTime = calculateNextAvailableTime(currentEndTime, task.getLength());
@@ -665,10 +1197,11 @@ std::string StartTaskTimerCommand::minutesToTimeString(int minutes) {
 }
 
 // CommandGroup Implementation
-CommandGroup::CommandGroup(const std::string& description) : groupDescription(description) {
+CommandGroup::CommandGroup(const std::string& description, std::pmr::memory_resource* resource)
+    : payloadArena(resource), commands(&payloadArena), groupDescription(description, &payloadArena) {
 }
 
-void CommandGroup::addCommand(std::unique_ptr<UndoableCommand> command) {
+void CommandGroup::addCommand(CommandPtr command) {
     if (command) {
         commands.push_back(std::move(command));
     }
@@ -692,32 +1225,108 @@ std::string CommandGroup::getDescription() const {
     if (commands.size() == 1) {
         return commands[0]->getDescription();
     } else if (commands.size() > 1) {
-        return groupDescription + " (" + std::to_string(commands.size()) + " operations)";
+        return std::string(groupDescription) + " (" + std::to_string(commands.size()) + " operations)";
     }
-    return groupDescription;
+    return std::string(groupDescription);
 }
 
 size_t CommandGroup::getMemoryFootprint() const {
-    size_t total = sizeof(*this) + groupDescription.size();
+    size_t total = sizeof(*this) + payloadArena.getBytesInUse();
     for (const auto& command : commands) {
         total += command->getMemoryFootprint();
     }
     return total;
 }
 
+CommandType CommandGroup::getType() const {
+    return CommandType::Group;
+}
+
+void CommandGroup::serialize(HistoryWriter& out) const {
+    out.writeString(groupDescription);
+    out.writeVarint(commands.size());
+    for (const auto& command : commands) {
+        out.writeCommand(*command);
+    }
+}
+
+bool CommandGroup::deserialize(HistoryReader& in) {
+    groupDescription = in.readString();
+    uint64_t count = in.readVarint();
+    for (uint64_t i = 0; i < count && in.ok(); i++) {
+        CommandPtr command = in.readCommand();
+        if (!command) {
+            return false;
+        }
+        addCommand(std::move(command));
+    }
+    return in.ok();
+}
+
 bool CommandGroup::isEmpty() const {
     return commands.empty();
 }
 
 // UndoManager Implementation
-UndoManager::UndoManager() : currentMemoryUsage(0), groupingEnabled(false) {
+UndoManager::UndoManager(size_t entryLimit, size_t byteLimit)
+    : root(std::make_unique<HistoryNode>()), current(root.get()), redoTail(root.get()), oldestLeaf(nullptr),
+      newestLeaf(nullptr), nodesById(&commandPool), nextNodeId(1), nodeCount(0), memoryUsage(0), evictionVisits(0),
+      maxEntries(std::max<size_t>(entryLimit, 1)), maxBytes(byteLimit),
+      mergeWindow(DEFAULT_MERGE_WINDOW_MS), checkpointInterval(DEFAULT_CHECKPOINT_INTERVAL),
+      groupingEnabled(false) {
+    root->id = nextNodeId++;
+    nodesById[root->id] = root.get();
+}
+
+void UndoManager::setLimits(size_t entryLimit, size_t byteLimit) {
+    maxEntries = std::max<size_t>(entryLimit, 1);
+    maxBytes = byteLimit;
+    enforceLimits();
+}
+
+size_t UndoManager::getMaxEntries() const {
+    return maxEntries;
+}
+
+size_t UndoManager::getMaxBytes() const {
+    return maxBytes;
+}
+
+void UndoManager::setMergeWindow(std::chrono::milliseconds window) {
+    mergeWindow = window;
+}
+
+std::chrono::milliseconds UndoManager::getMergeWindow() const {
+    return mergeWindow;
+}
+
+void UndoManager::setStateAccess(std::function<TaskList()> capture, std::function<void(const TaskList&)> restore) {
+    captureState = std::move(capture);
+    restoreState = std::move(restore);
+}
+
+void UndoManager::setCheckpointInterval(size_t interval) {
+    checkpointInterval = interval;
 }
 
-void UndoManager::executeCommand(std::unique_ptr<UndoableCommand> command) {
+size_t UndoManager::getCheckpointInterval() const {
+    return checkpointInterval;
+}
+
+std::pmr::memory_resource* UndoManager::getCommandResource() {
+    return &commandPool;
+}
+
+void UndoManager::executeCommand(CommandPtr command) {
     if (!command) {
         return;
     }
 
+    // The oldest state is only known while we are in it
+    if (current == root.get() && !groupingEnabled) {
+        takeCheckpoint(current, true);
+    }
+
     // Execute the command
     command->execute();
 
@@ -725,24 +1334,217 @@ void UndoManager::executeCommand(std::unique_ptr<UndoableCommand> command) {
         // Add to current group
         currentGroup->addCommand(std::move(command));
     } else {
-        // Clear redo stack since we're adding a new command
-        clearRedoStack();
+        // Fold it into the newest entry if that is the same edit moments ago.
+        // A node with children is a branch point and stays as it is.
+        auto now = std::chrono::steady_clock::now();
+        if (current != root.get() && current->children.empty() && mergeWindow.count() > 0 &&
+            now - current->recordedAt <= mergeWindow && current->command->mergeWith(*command)) {
+            refreshFootprint(current);
+            current->recordedAt = now;
+            if (current->hasCheckpoint) {
+                takeCheckpoint(current, true);
+            }
+            enforceLimits();
+            return;
+        }
 
-        // Add to undo stack
-        currentMemoryUsage += command->getMemoryFootprint();
-        undoStack.push_back(std::move(command));
+        // Add as a new branch of the current state
+        pushCommand(std::move(command), now);
 
         // Enforce memory limits
-        enforceMemoryLimits();
+        enforceLimits();
+    }
+}
+
+UndoManager::HistoryNode* UndoManager::attachNode(HistoryNode* parent, CommandPtr command,
+                                                  std::chrono::steady_clock::time_point recordedAt) {
+    auto node = std::make_unique<HistoryNode>();
+    node->footprint = command->getMemoryFootprint();
+    node->command = std::move(command);
+    node->recordedAt = recordedAt;
+    node->id = nextNodeId++;
+    node->depth = parent->depth + 1;
+    node->parent = parent;
+
+    HistoryNode* added = node.get();
+    parent->children.push_back(std::move(node));
+    parent->redoChild = added;
+    nodesById[added->id] = added;
+    memoryUsage += added->footprint;
+    nodeCount++;
+    return added;
+}
+
+void UndoManager::pushCommand(CommandPtr command, std::chrono::steady_clock::time_point recordedAt) {
+    current = attachNode(current, std::move(command), recordedAt);
+    updateRedoTail(current);
+    takeCheckpoint(current);
+}
+
+void UndoManager::takeCheckpoint(HistoryNode* node, bool force) {
+    if (!captureState || checkpointInterval == 0) {
+        return;
+    }
+    if (force || node->depth % checkpointInterval == 0) {
+        node->checkpoint = captureState();
+        node->hasCheckpoint = true;
+
+        // Counted in full: the live list soon copies away from the chunks it shares
+        memoryUsage -= node->footprint;
+        node->footprint -= node->checkpointBytes;
+        node->checkpointBytes = node->checkpoint.getMemoryFootprint();
+        node->footprint += node->checkpointBytes;
+        memoryUsage += node->footprint;
+    }
+}
+
+void UndoManager::refreshFootprint(HistoryNode* node) {
+    memoryUsage -= node->footprint;
+    node->footprint = node->command->getMemoryFootprint() + node->checkpointBytes;
+    memoryUsage += node->footprint;
+}
+
+void UndoManager::forgetSubtree(HistoryNode* node) {
+    std::vector<HistoryNode*> pending{node};
+    while (!pending.empty()) {
+        HistoryNode* next = pending.back();
+        pending.pop_back();
+        for (auto& child : next->children) {
+            pending.push_back(child.get());
+        }
+        forgetNode(next);
+    }
+}
+
+void UndoManager::forgetNode(HistoryNode* node) {
+    evictionVisits++;
+    unlinkLeaf(node);
+    nodesById.erase(node->id);
+    memoryUsage -= node->footprint;
+    if (node->command) {
+        nodeCount--;
+    }
+}
+
+void UndoManager::linkLeaf(HistoryNode* node, bool evictNext) {
+    node->isAbandonedLeaf = true;
+    if (evictNext) {
+        node->olderLeaf = nullptr;
+        node->newerLeaf = oldestLeaf;
+        (oldestLeaf ? oldestLeaf->olderLeaf : newestLeaf) = node;
+        oldestLeaf = node;
+    } else {
+        node->olderLeaf = newestLeaf;
+        node->newerLeaf = nullptr;
+        (newestLeaf ? newestLeaf->newerLeaf : oldestLeaf) = node;
+        newestLeaf = node;
+    }
+}
+
+void UndoManager::unlinkLeaf(HistoryNode* node) {
+    if (!node->isAbandonedLeaf) {
+        return;
+    }
+    (node->olderLeaf ? node->olderLeaf->newerLeaf : oldestLeaf) = node->newerLeaf;
+    (node->newerLeaf ? node->newerLeaf->olderLeaf : newestLeaf) = node->olderLeaf;
+    node->olderLeaf = nullptr;
+    node->newerLeaf = nullptr;
+    node->isAbandonedLeaf = false;
+}
+
+void UndoManager::updateRedoTail(HistoryNode* from) {
+    HistoryNode* tail = from;
+    while (tail->redoChild) {
+        evictionVisits++;
+        tail = tail->redoChild;
+    }
+    if (tail == redoTail) {
+        return;
+    }
+
+    // A new command or a jump left the old end on a branch of its own
+    if (redoTail && redoTail->children.empty()) {
+        linkLeaf(redoTail, false);
+    }
+    unlinkLeaf(tail);
+    redoTail = tail;
+}
+
+void UndoManager::removeLeaf(HistoryNode* node) {
+    HistoryNode* parent = node->parent;
+    bool wasRedoTail = node == redoTail;
+    forgetNode(node);
+
+    auto& siblings = parent->children;
+    if (parent->redoChild == node) {
+        // Redo falls back to the newest remaining branch
+        parent->redoChild = nullptr;
+        for (auto child = siblings.rbegin(); child != siblings.rend() && !parent->redoChild; ++child) {
+            if (child->get() != node) {
+                parent->redoChild = child->get();
+            }
+        }
+    }
+    siblings.erase(std::find_if(siblings.begin(), siblings.end(),
+                                [node](const std::unique_ptr<HistoryNode>& child) { return child.get() == node; }));
+
+    if (wasRedoTail) {
+        redoTail = nullptr;
+        updateRedoTail(parent);
+    } else if (siblings.empty() && parent != redoTail) {
+        // The rest of the same branch goes before any other
+        linkLeaf(parent, true);
+    }
+}
+
+bool UndoManager::evictOne() {
+    // Abandoned branches first, the one left longest ago first
+    if (oldestLeaf) {
+        removeLeaf(oldestLeaf);
+        return true;
+    }
+
+    // Then the oldest undo entry: the root's redo child, the next state on
+    // the current line, becomes the root and the command leading to it is
+    // dropped. With no abandoned leaves left it is the root's only child.
+    if (current != root.get()) {
+        std::unique_ptr<HistoryNode> newRoot;
+        for (auto& child : root->children) {
+            if (child.get() == root->redoChild) {
+                newRoot = std::move(child);
+            } else if (child) {
+                forgetSubtree(child.get());
+            }
+        }
+        forgetNode(root.get());
+        memoryUsage -= newRoot->footprint - newRoot->checkpointBytes;
+        nodeCount--;
+        newRoot->command.reset();
+        newRoot->footprint = newRoot->checkpointBytes;
+        newRoot->parent = nullptr;
+        root = std::move(newRoot);
+        return true;
+    }
+
+    // Then the redo entries farthest away
+    if (redoTail != current) {
+        removeLeaf(redoTail);
+        return true;
+    }
+    return false;
+}
+
+void UndoManager::enforceLimits() {
+    while ((nodeCount > maxEntries || memoryUsage > maxBytes) && evictOne()) {
     }
 }
 
 bool UndoManager::canUndo() const {
-    return !undoStack.empty();
+    return current != root.get();
 }
 
 bool UndoManager::canRedo() const {
-    return !redoStack.empty();
+    return current->redoChild != nullptr;
 }
 
 void UndoManager::undo() {
@@ -750,16 +1552,15 @@ void UndoManager::undo() {
         return;
     }
 
-    // Get the last command
-    auto command = std::move(undoStack.back());
-    undoStack.pop_back();
-    currentMemoryUsage -= command->getMemoryFootprint();
+    HistoryNode* node = current;
+    node->recordedAt = {}; // Once undone it is no longer the edit just made
 
     // Undo the command
-    command->undo();
+    node->command->undo();
 
-    // Move to redo stack
-    redoStack.push_back(std::move(command));
+    refreshFootprint(node);
+    current = node->parent;
+    current->redoChild = node;
 }
 
 void UndoManager::redo() {
@@ -767,69 +1568,139 @@ void UndoManager::redo() {
         return;
     }
 
-    // Get the last undone command
-    auto command = std::move(redoStack.back());
-    redoStack.pop_back();
+    HistoryNode* node = current->redoChild;
 
     // Re-execute the command
-    command->execute();
+    node->command->execute();
 
-    // Move back to undo stack
-    currentMemoryUsage += command->getMemoryFootprint();
-    undoStack.push_back(std::move(command));
+    refreshFootprint(node);
+    current = node;
 }
 
 std::string UndoManager::getLastUndoDescription() const {
     if (canUndo()) {
-        return undoStack.back()->getDescription();
+        return current->command->getDescription();
     }
     return "";
 }
 
 std::string UndoManager::getLastRedoDescription() const {
     if (canRedo()) {
-        return redoStack.back()->getDescription();
+        return current->redoChild->command->getDescription();
     }
     return "";
 }
 
 size_t UndoManager::getCurrentMemoryUsage() const {
-    return currentMemoryUsage;
+    return memoryUsage;
 }
 
 size_t UndoManager::getUndoStackSize() const {
-    return undoStack.size();
+    return current->depth - root->depth;
 }
 
 size_t UndoManager::getRedoStackSize() const {
-    return redoStack.size();
+    size_t count = 0;
+    for (const HistoryNode* node = current->redoChild; node; node = node->redoChild) {
+        count++;
+    }
+    return count;
 }
 
-void UndoManager::enforceMemoryLimits() {
-    // Calculate total memory usage including redo stack
-    size_t totalMemoryUsage = currentMemoryUsage;
-    for (const auto& cmd : redoStack) {
-        totalMemoryUsage += cmd->getMemoryFootprint();
-    }
+size_t UndoManager::getEvictionVisits() const {
+    return evictionVisits;
+}
 
-    // Remove oldest undo commands if over limits
-    while ((undoStack.size() > MAX_UNDO_HISTORY || totalMemoryUsage > MAX_MEMORY_USAGE)
-           && !undoStack.empty()) {
-        size_t removedSize = undoStack.front()->getMemoryFootprint();
-        currentMemoryUsage -= removedSize;
-        totalMemoryUsage -= removedSize;
-        undoStack.erase(undoStack.begin());
+std::vector<UndoManager::HistoryEntry> UndoManager::getHistoryTree() const {
+    // undoLine[d] is the current line's node d levels below the root
+    std::vector<const HistoryNode*> undoLine(getUndoStackSize() + 1);
+    for (const HistoryNode* node = current; node; node = node->parent) {
+        undoLine[node->depth - root->depth] = node;
     }
 
-    // If still over memory limit, clear some redo commands
-    while (totalMemoryUsage > MAX_MEMORY_USAGE && !redoStack.empty()) {
-        totalMemoryUsage -= redoStack.front()->getMemoryFootprint();
-        redoStack.erase(redoStack.begin());
+    std::vector<HistoryEntry> entries;
+    entries.reserve(nodeCount + 1);
+    std::vector<std::pair<const HistoryNode*, size_t>> pending{{root.get(), 0}};
+    while (!pending.empty()) {
+        auto [node, branch] = pending.back();
+        pending.pop_back();
+
+        size_t depth = node->depth - root->depth;
+        bool undoable = depth < undoLine.size() && undoLine[depth] == node;
+        entries.push_back({node->id, depth, branch, node->command ? node->command->getDescription() : "",
+                           node == current, undoable, node->hasCheckpoint});
+
+        // The redo child continues this branch after the others are listed
+        if (node->redoChild) {
+            pending.push_back({node->redoChild, branch});
+        }
+        for (auto child = node->children.rbegin(); child != node->children.rend(); ++child) {
+            if (child->get() != node->redoChild) {
+                pending.push_back({child->get(), branch + 1});
+            }
+        }
     }
+    return entries;
 }
 
-void UndoManager::clearRedoStack() {
-    redoStack.clear();
+bool UndoManager::jumpTo(uint64_t id) {
+    auto found = nodesById.find(id);
+    if (found == nodesById.end() || isGrouping()) {
+        return false;
+    }
+    HistoryNode* target = found->second;
+
+    // Where the current line and the target's part ways
+    HistoryNode* fromCurrent = current;
+    HistoryNode* fromTarget = target;
+    while (fromCurrent->depth > fromTarget->depth) {
+        fromCurrent = fromCurrent->parent;
+    }
+    while (fromTarget->depth > fromCurrent->depth) {
+        fromTarget = fromTarget->parent;
+    }
+    while (fromCurrent != fromTarget) {
+        fromCurrent = fromCurrent->parent;
+        fromTarget = fromTarget->parent;
+    }
+    HistoryNode* branchPoint = fromCurrent;
+
+    // The nearest checkpoint at or above the target, at most one interval up
+    HistoryNode* checkpoint = target;
+    while (checkpoint && !checkpoint->hasCheckpoint) {
+        checkpoint = checkpoint->parent;
+    }
+
+    size_t walkCost = (current->depth - branchPoint->depth) + (target->depth - branchPoint->depth);
+    HistoryNode* replayFrom = branchPoint;
+    if (checkpoint && restoreState && target->depth - checkpoint->depth < walkCost) {
+        restoreState(checkpoint->checkpoint);
+        replayFrom = checkpoint;
+    } else {
+        for (HistoryNode* node = current; node != branchPoint; node = node->parent) {
+            node->recordedAt = {};
+            node->command->undo();
+            refreshFootprint(node);
+        }
+    }
+
+    std::vector<HistoryNode*> replay;
+    for (HistoryNode* node = target; node != replayFrom; node = node->parent) {
+        replay.push_back(node);
+    }
+    for (auto node = replay.rbegin(); node != replay.rend(); ++node) {
+        (*node)->recordedAt = {};
+        (*node)->command->execute();
+        refreshFootprint(*node);
+    }
+
+    // Redo follows the path just taken
+    for (HistoryNode* node = target; node->parent; node = node->parent) {
+        node->parent->redoChild = node;
+    }
+    current = target;
+    updateRedoTail(target);
+    return true;
 }
 
 void UndoManager::startCommandGroup(const std::string& groupDescription) {
@@ -839,22 +1710,21 @@ void UndoManager::startCommandGroup(const std::string& groupDescription) {
     }
 
     // Start new group
-    currentGroup = std::make_unique<CommandGroup>(groupDescription);
+    if (current == root.get()) {
+        takeCheckpoint(current, true);
+    }
+    currentGroup = createCommand<CommandGroup>(groupDescription, &commandPool);
     groupingEnabled = true;
 }
 
 void UndoManager::endCommandGroup() {
     if (groupingEnabled && currentGroup) {
         if (!currentGroup->isEmpty()) {
-            // Clear redo stack since we're adding a new command
-            clearRedoStack();
-
-            // Add the group to undo stack
-            currentMemoryUsage += currentGroup->getMemoryFootprint();
-            undoStack.push_back(std::move(currentGroup));
+            // Add the group as a new branch of the current state
+            pushCommand(std::move(currentGroup), std::chrono::steady_clock::time_point{});
 
             // Enforce memory limits
-            enforceMemoryLimits();
+            enforceLimits();
         }
 
         currentGroup.reset();
@@ -865,3 +1735,55 @@ void UndoManager::endCommandGroup() {
 bool UndoManager::isGrouping() const {
     return groupingEnabled && currentGroup != nullptr;
 }
+
+std::vector<const UndoableCommand*> UndoManager::getUndoEntries() const {
+    std::vector<const UndoableCommand*> entries;
+    entries.reserve(getUndoStackSize());
+    for (const HistoryNode* node = current; node != root.get(); node = node->parent) {
+        entries.push_back(node->command.get());
+    }
+    std::reverse(entries.begin(), entries.end());
+    return entries;
+}
+
+std::vector<const UndoableCommand*> UndoManager::getRedoEntries() const {
+    std::vector<const UndoableCommand*> entries;
+    for (const HistoryNode* node = current->redoChild; node; node = node->redoChild) {
+        entries.push_back(node->command.get());
+    }
+    return entries;
+}
+
+void UndoManager::restoreHistory(std::vector<CommandPtr> undoEntries, std::vector<CommandPtr> redoEntries) {
+    clear();
+
+    // The task list is already in the state after the undo entries, so only
+    // the current node can be checkpointed
+    for (auto& command : undoEntries) {
+        current = attachNode(current, std::move(command), {});
+    }
+    takeCheckpoint(current, true);
+
+    redoTail = current;
+    for (auto& command : redoEntries) {
+        redoTail = attachNode(redoTail, std::move(command), {});
+    }
+
+    enforceLimits();
+}
+
+void UndoManager::clear() {
+    currentGroup.reset();
+    groupingEnabled = false;
+
+    root = std::make_unique<HistoryNode>();
+    root->id = nextNodeId++;
+    current = root.get();
+    redoTail = root.get();
+    oldestLeaf = nullptr;
+    newestLeaf = nullptr;
+    nodesById.clear();
+    nodesById[root->id] = root.get();
+    nodeCount = 0;
+    memoryUsage = 0;
+}
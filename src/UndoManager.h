@@ -1,13 +1,88 @@
 #ifndef UNDOMANAGER_H
 #define UNDOMANAGER_H
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include "TaskList.h"
 
 // Forward declarations
 class TaskManager;
 class Act;
+class UndoableCommand;
+class HistoryWriter;
+class HistoryReader;
+
+/**
+ * Tags identifying each command type in the persisted history (UndoLog).
+ * Values are stored on disk: append new ones, never renumber.
+ */
+enum class CommandType : uint8_t {
+    AddTask = 1,
+    DeleteTask = 2,
+    EditTaskName = 3,
+    EditTaskStartTime = 4,
+    EditTaskLength = 5,
+    ToggleTaskFixed = 6,
+    ToggleTaskRigid = 7,
+    MoveTaskUp = 8,
+    MoveTaskDown = 9,
+    StartTaskTimer = 10,
+    Group = 11,
+    InsertTask = 12,
+};
+
+/**
+ * Deleter for commands allocated from an UndoManager's pool. A default
+ * deleter (or one converted from std::default_delete) falls back to delete,
+ * so commands created with std::make_unique can still be executed.
+ */
+struct CommandDeleter {
+    std::pmr::memory_resource* resource = nullptr;
+    size_t size = 0;
+    size_t alignment = 0;
+
+    CommandDeleter() = default;
+    CommandDeleter(std::pmr::memory_resource* res, size_t bytes, size_t align)
+        : resource(res), size(bytes), alignment(align) {}
+    template <typename T>
+    CommandDeleter(const std::default_delete<T>&) {}
+
+    void operator()(UndoableCommand* command) const;
+};
+
+using CommandPtr = std::unique_ptr<UndoableCommand, CommandDeleter>;
+
+/**
+ * Memory resource that forwards to another one and tallies the bytes
+ * currently allocated through it. Each command routes its payloads through
+ * its own arena, so its footprint is what it really holds (string and
+ * vector capacity included) rather than an estimate.
+ */
+class PayloadArena : public std::pmr::memory_resource {
+private:
+    std::pmr::memory_resource* upstream;
+    size_t bytesInUse;
+
+public:
+    explicit PayloadArena(std::pmr::memory_resource* upstreamResource = std::pmr::get_default_resource());
+
+    /**
+     * Bytes allocated through this arena and not yet released
+     */
+    size_t getBytesInUse() const { return bytesInUse; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
 
 /**
  * Abstract base class for all undoable commands
@@ -27,7 +102,8 @@ public:
     virtual void undo() = 0;
 
     /**
-     * Get a human-readable description of the command
+     * Get a human-readable description of the command (built on demand,
+     * so the edit path never formats text nobody reads)
      */
     virtual std::string getDescription() const = 0;
 
@@ -35,6 +111,29 @@ public:
      * Get the approximate memory footprint of this command in bytes
      */
     virtual size_t getMemoryFootprint() const = 0;
+
+    /**
+     * Tag written in front of the command's record in the history log
+     */
+    virtual CommandType getType() const = 0;
+
+    /**
+     * Write the command's state, including whether it has run, so a command
+     * read back with deserialize() undoes and redoes exactly like this one
+     */
+    virtual void serialize(HistoryWriter& out) const = 0;
+
+    /**
+     * Fill a blank command from what serialize() wrote; false if malformed
+     */
+    virtual bool deserialize(HistoryReader& in) = 0;
+
+    /**
+     * Fold `next`, executed right after this command, into this one so the
+     * pair undoes as a single step. UndoManager only asks for consecutive
+     * entries inside its merge window. Return false to keep them separate.
+     */
+    virtual bool mergeWith(const UndoableCommand& /*next*/) { return false; }
 };
 
 /**
@@ -43,27 +142,97 @@ public:
 class TaskManagerCommand : public UndoableCommand {
 protected:
     TaskManager* manager;
-    std::string description;
+    PayloadArena payloadArena; // In front of the owning UndoManager's pool
 
 public:
-    TaskManagerCommand(TaskManager* mgr, const std::string& desc);
-    std::string getDescription() const override;
+    explicit TaskManagerCommand(TaskManager* mgr);
+
+protected:
+    /**
+     * Allocator for string payloads; footprints count what goes through it
+     */
+    std::pmr::memory_resource* payloadResource();
+
+    /**
+     * Name of the task at index, empty when the index is out of range
+     */
+    std::pmr::string taskNameAt(int index);
+};
+
+/**
+ * Base for commands undone by putting back the tasks they changed instead of
+ * with hand-written inverse logic. Subclasses implement apply(); execute
+ * compares the list with an O(1) snapshot taken before it (TaskList shares
+ * structure, so only the chunks apply() touched are looked at) and keeps the
+ * before/after state of just the changed tasks. Undo and redo write those
+ * states back onto the tasks, found by id, so the rest of the list - say a
+ * task inserted with i/o since - is left as it is.
+ */
+class SnapshotCommand : public TaskManagerCommand {
+private:
+    struct TaskState {
+        std::string name;
+        std::string startTime; // Empty for a flexible task, whose start is recomputed
+        int length;
+        bool fixed;
+        bool rigid;
+
+        bool operator==(const TaskState& other) const;
+    };
+
+    struct TaskChange {
+        uint64_t taskId;
+        TaskState before;
+        TaskState after;
+    };
+
+    std::pmr::vector<TaskChange> changes;
+    bool applied;
+
+    static TaskState stateOf(const Act& task);
+
+    /**
+     * Write the recorded before (or after) states onto the tasks still there
+     */
+    void restore(bool toAfter);
 
 protected:
-    void setDescription(const std::string& desc) { description = desc; }
+    /**
+     * Perform the change; return false if there was nothing to do
+     */
+    virtual bool apply() = 0;
+
+    /**
+     * Write/read the snapshot part of the state: whether apply() ran and
+     * the tasks it changed, before and after
+     */
+    void serializeSnapshot(HistoryWriter& out) const;
+    bool deserializeSnapshot(HistoryReader& in);
+
+    /**
+     * Bytes the recorded states hold outside the payload arena (names and
+     * times too long for the small-string buffer)
+     */
+    size_t getSnapshotFootprint() const;
+
+public:
+    explicit SnapshotCommand(TaskManager* mgr);
+
+    void execute() override;
+    void undo() override;
 };
 
 /**
  * Command for adding a task
  */
 class AddTaskCommand : public TaskManagerCommand {
-private:
-    std::string name;
-    std::string startTime;
+protected:
+    std::pmr::string name;
+    std::pmr::string startTime;
     int length;
     bool isRigid;
     bool hasStartTime;
-    int insertIndex; // Where the task was added
+    uint64_t taskId; // Id of the added task, reused on redo (0 before the first run)
 
 public:
     // Constructor for task with start time (fixed task)
@@ -74,9 +243,51 @@ public:
     AddTaskCommand(TaskManager* mgr, const std::string& taskName,
                    int len, bool rigid);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit AddTaskCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
+    size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+
+protected:
+    /**
+     * Where execute() puts the task; the end of the list
+     */
+    virtual int insertPosition() const;
+};
+
+/**
+ * Command for inserting a task in front of another (i, o and F in the TUI).
+ * Redo puts it back in front of the same task wherever that is by then.
+ */
+class InsertTaskCommand : public AddTaskCommand {
+private:
+    uint64_t followingTaskId; // Task it goes in front of, 0 for the end
+
+protected:
+    int insertPosition() const override;
+
+public:
+    // Fixed task at index
+    InsertTaskCommand(TaskManager* mgr, int index, const std::string& taskName,
+                      const std::string& start, int len, bool rigid);
+
+    // Flexible task at index
+    InsertTaskCommand(TaskManager* mgr, int index, const std::string& taskName, int len, bool rigid);
+
+    // Blank command for UndoLog to fill with deserialize()
+    explicit InsertTaskCommand(TaskManager* mgr);
+
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
 };
 
 /**
@@ -84,10 +295,12 @@ public:
  */
 class DeleteTaskCommand : public TaskManagerCommand {
 private:
-    int index;
+    uint64_t taskId;
+    uint64_t followingTaskId; // Task after it when deleted (0 if last), where undo puts it back
+    int index;                // Position when deleted, used if the follower is gone
     // Store deleted task data for undo
-    std::string deletedName;
-    std::string deletedStartTime;
+    std::pmr::string deletedName;
+    std::pmr::string deletedStartTime;
     int deletedLength;
     bool deletedRigid;
     bool deletedFixed;
@@ -96,9 +309,16 @@ private:
 public:
     DeleteTaskCommand(TaskManager* mgr, int taskIndex);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit DeleteTaskCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
 };
 
 /**
@@ -106,17 +326,25 @@ public:
  */
 class EditTaskNameCommand : public TaskManagerCommand {
 private:
-    int taskIndex;
-    std::string oldName;
-    std::string newName;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string oldName;
+    std::pmr::string newName;
     bool wasExecuted;
 
 public:
     EditTaskNameCommand(TaskManager* mgr, int index, const std::string& oldValue, const std::string& newValue);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit EditTaskNameCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+    bool mergeWith(const UndoableCommand& next) override;
 };
 
 /**
@@ -124,9 +352,10 @@ public:
  */
 class EditTaskStartTimeCommand : public TaskManagerCommand {
 private:
-    int taskIndex;
-    std::string oldStartTime;
-    std::string newStartTime;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
+    std::pmr::string oldStartTime;
+    std::pmr::string newStartTime;
     bool oldFixed;
     bool newFixed;
     bool wasExecuted;
@@ -134,9 +363,17 @@ private:
 public:
     EditTaskStartTimeCommand(TaskManager* mgr, int index, const std::string& oldValue, const std::string& newValue, bool oldFixedState, bool newFixedState);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit EditTaskStartTimeCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+    bool mergeWith(const UndoableCommand& next) override;
 };
 
 /**
@@ -144,7 +381,8 @@ public:
  */
 class EditTaskLengthCommand : public TaskManagerCommand {
 private:
-    int taskIndex;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
     int oldLength;
     int newLength;
     bool wasExecuted;
@@ -152,43 +390,67 @@ private:
 public:
     EditTaskLengthCommand(TaskManager* mgr, int index, int oldValue, int newValue);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit EditTaskLengthCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+    bool mergeWith(const UndoableCommand& next) override;
 };
 
 /**
  * Command for toggling task fixed status
  */
-class ToggleTaskFixedCommand : public TaskManagerCommand {
+class ToggleTaskFixedCommand : public SnapshotCommand {
 private:
-    int taskIndex;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
     bool oldFixed;
-    bool wasExecuted;
+
+protected:
+    bool apply() override;
 
 public:
     ToggleTaskFixedCommand(TaskManager* mgr, int index, bool oldValue);
 
-    void execute() override;
-    void undo() override;
+    // Blank command for UndoLog to fill with deserialize()
+    explicit ToggleTaskFixedCommand(TaskManager* mgr);
+
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
 };
 
 /**
  * Command for toggling task rigid status
  */
-class ToggleTaskRigidCommand : public TaskManagerCommand {
+class ToggleTaskRigidCommand : public SnapshotCommand {
 private:
-    int taskIndex;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
     bool oldRigid;
-    bool wasExecuted;
+
+protected:
+    bool apply() override;
 
 public:
     ToggleTaskRigidCommand(TaskManager* mgr, int index, bool oldValue);
 
-    void execute() override;
-    void undo() override;
+    // Blank command for UndoLog to fill with deserialize()
+    explicit ToggleTaskRigidCommand(TaskManager* mgr);
+
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
 };
 
 /**
@@ -196,16 +458,26 @@ public:
  */
 class MoveTaskUpCommand : public TaskManagerCommand {
 private:
-    int taskIndex;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
     bool wasFixed; // Store if task was fixed before movement
+    int distance;  // Positions moved; consecutive moves of the task merge into one command
     bool wasExecuted;
 
 public:
     MoveTaskUpCommand(TaskManager* mgr, int index, bool taskWasFixed);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit MoveTaskUpCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+    bool mergeWith(const UndoableCommand& next) override;
 };
 
 /**
@@ -213,42 +485,58 @@ public:
  */
 class MoveTaskDownCommand : public TaskManagerCommand {
 private:
-    int taskIndex;
+    uint64_t taskId; // Stable across inserts, deletes and moves
+    std::pmr::string taskName; // Captured for the description
     bool wasFixed; // Store if task was fixed before movement
+    int distance;  // Positions moved; consecutive moves of the task merge into one command
     bool wasExecuted;
 
 public:
     MoveTaskDownCommand(TaskManager* mgr, int index, bool taskWasFixed);
 
+    // Blank command for UndoLog to fill with deserialize()
+    explicit MoveTaskDownCommand(TaskManager* mgr);
+
     void execute() override;
     void undo() override;
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
+    bool mergeWith(const UndoableCommand& next) override;
 };
 
 /**
  * Command for starting a task timer (sets current time and makes task fixed)
  * Includes cascading time propagation for subsequent tasks
  */
-class StartTaskTimerCommand : public TaskManagerCommand {
+class StartTaskTimerCommand : public SnapshotCommand {
 private:
-    struct TaskState {
-        int index;
-        std::string oldStartTime;
-        std::string newStartTime;
-        bool oldFixed;
+    struct TaskUpdate {
+        uint64_t taskId;
+        std::string newStartTime; // HH:MM, always within the small-string buffer
         bool newFixed;
     };
 
-    std::vector<TaskState> affectedTasks;
+    std::pmr::vector<TaskUpdate> affectedTasks;
+    std::pmr::string taskName; // Captured for the description
     std::string timerStartTime;
-    bool wasExecuted;
+
+protected:
+    bool apply() override;
 
 public:
     StartTaskTimerCommand(TaskManager* mgr, int index);
 
-    void execute() override;
-    void undo() override;
+    // Blank command for UndoLog to fill with deserialize()
+    explicit StartTaskTimerCommand(TaskManager* mgr);
+
+    std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
 
 private:
     void calculateCascadingUpdates(TaskManager* mgr, int startIndex);
@@ -262,17 +550,22 @@ private:
  */
 class CommandGroup : public UndoableCommand {
 private:
-    std::vector<std::unique_ptr<UndoableCommand>> commands;
-    std::string groupDescription;
+    PayloadArena payloadArena;
+    std::pmr::vector<CommandPtr> commands;
+    std::pmr::string groupDescription;
 
 public:
-    CommandGroup(const std::string& description);
+    CommandGroup(const std::string& description,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-    void addCommand(std::unique_ptr<UndoableCommand> command);
+    void addCommand(CommandPtr command);
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
     size_t getMemoryFootprint() const override;
+    CommandType getType() const override;
+    void serialize(HistoryWriter& out) const override;
+    bool deserialize(HistoryReader& in) override;
     bool isEmpty() const;
 };
 
@@ -280,36 +573,207 @@ public:
  * Manages undo/redo operations with memory limits
  */
 class UndoManager {
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 100;
+    static constexpr size_t DEFAULT_MAX_BYTES = 1024 * 1024; // 1MB
+    static constexpr int DEFAULT_MERGE_WINDOW_MS = 1000;
+    static constexpr size_t DEFAULT_CHECKPOINT_INTERVAL = 16;
+
+    /**
+     * One node of the history tree as the history browser lists it
+     */
+    struct HistoryEntry {
+        uint64_t id;
+        size_t depth;        // Distance from the oldest state still kept
+        size_t branch;       // 0 for the current line, >0 for nested alternate branches
+        std::string description; // Empty for the oldest state
+        bool isCurrent;
+        bool isUndoable;     // On the path from the oldest state to the current one
+        bool hasCheckpoint;
+    };
+
 private:
-    static constexpr size_t MAX_UNDO_HISTORY = 100;
-    static constexpr size_t MAX_MEMORY_USAGE = 1024 * 1024; // 1MB
+    /**
+     * Pool for commands and their payloads. Declared first so it outlives
+     * every command that points into it.
+     */
+    std::pmr::unsynchronized_pool_resource commandPool;
 
-    std::vector<std::unique_ptr<UndoableCommand>> undoStack;
-    std::vector<std::unique_ptr<UndoableCommand>> redoStack;
-    size_t currentMemoryUsage;
+    /**
+     * One state of the task list. Every node but the root holds the command
+     * that leads to it from its parent. Undo moves to the parent and redo to
+     * the child visited last, so a command executed after an undo starts a
+     * new branch instead of discarding the redo entries.
+     */
+    struct HistoryNode {
+        CommandPtr command; // Null for the root
+        size_t footprint = 0; // Command plus checkpoint, cached so the running total never re-walks the tree
+        std::chrono::steady_clock::time_point recordedAt; // Last executed or merged into (epoch if loaded)
+        uint64_t id = 0;    // Creation order; stable while the node lives
+        size_t depth = 0;   // Commands between the first recorded state and this one
+        HistoryNode* parent = nullptr;
+        std::vector<std::unique_ptr<HistoryNode>> children; // Oldest first
+        HistoryNode* redoChild = nullptr; // Child that redo moves to
+        TaskList checkpoint; // The whole task list in this state, if hasCheckpoint
+        bool hasCheckpoint = false;
+        size_t checkpointBytes = 0; // The checkpoint's share of footprint
+        HistoryNode* olderLeaf = nullptr; // Neighbours in the abandoned-leaf list
+        HistoryNode* newerLeaf = nullptr;
+        bool isAbandonedLeaf = false;
+    };
+
+    /**
+     * The tree, oldest state at the root. Eviction removes abandoned branches
+     * first, then the root (its redo child, the next state on the current
+     * line, takes over), then the redo entries farthest away.
+     *
+     * Every leaf but the end of the current line is on an abandoned branch.
+     * Those leaves are kept in a list in the order they were abandoned; when
+     * evicting one leaves its parent a leaf, the parent goes to the front, so
+     * a branch is removed from its tip back to where it left the current line
+     * before the next one is touched. Each eviction is then O(1) instead of a
+     * walk over the whole tree.
+     */
+    std::unique_ptr<HistoryNode> root;
+    HistoryNode* current;  // The state the task list is in
+    HistoryNode* redoTail; // End of the current line: the last redo entry, or current
+    HistoryNode* oldestLeaf; // Abandoned leaves, next to evict first
+    HistoryNode* newestLeaf;
+    std::pmr::unordered_map<uint64_t, HistoryNode*> nodesById; // Entries come from commandPool
+    uint64_t nextNodeId;
+    size_t nodeCount;   // Nodes holding a command (all but the root)
+    size_t memoryUsage; // Footprint of every command and checkpoint in the tree
+    size_t evictionVisits; // Nodes looked at while evicting, see getEvictionVisits()
+    size_t maxEntries;  // undo-max-entries, counting every branch
+    size_t maxBytes;    // undo-max-bytes, counting every branch
+    std::chrono::milliseconds mergeWindow; // Max gap between commands that merge (undo-merge-ms)
+
+    /**
+     * Checkpoints are TaskList snapshots, which share structure with the live
+     * list, so one every few nodes costs little and bounds how many commands
+     * a jump has to replay. Without state access no checkpoints are taken.
+     */
+    size_t checkpointInterval; // undo-checkpoint-interval; 0 disables checkpoints
+    std::function<TaskList()> captureState;
+    std::function<void(const TaskList&)> restoreState;
 
     // Command grouping support
-    std::unique_ptr<CommandGroup> currentGroup;
+    std::unique_ptr<CommandGroup, CommandDeleter> currentGroup;
     bool groupingEnabled;
 
     /**
-     * Enforce memory limits by removing oldest commands if necessary
+     * Hang a command under parent as its redo child; returns the new node
+     */
+    HistoryNode* attachNode(HistoryNode* parent, CommandPtr command,
+                            std::chrono::steady_clock::time_point recordedAt);
+
+    /**
+     * Attach an executed command under the current node and move onto it
+     */
+    void pushCommand(CommandPtr command, std::chrono::steady_clock::time_point recordedAt);
+
+    /**
+     * Record the current task list on node (which must be the current node)
+     * if it falls on the checkpoint interval, or unconditionally if forced
      */
-    void enforceMemoryLimits();
+    void takeCheckpoint(HistoryNode* node, bool force = false);
 
     /**
-     * Clear the redo stack (called when a new command is executed)
+     * Re-read a command's footprint after it ran or was merged into
      */
-    void clearRedoStack();
+    void refreshFootprint(HistoryNode* node);
+
+    /**
+     * Remove node and everything below it from the accounting, the id map
+     * and the abandoned-leaf list
+     */
+    void forgetSubtree(HistoryNode* node);
+    void forgetNode(HistoryNode* node);
+
+    /**
+     * Add a leaf to the abandoned-leaf list, at the back (abandoned just
+     * now) or the front (evicted next); take one off it
+     */
+    void linkLeaf(HistoryNode* node, bool evictNext);
+    void unlinkLeaf(HistoryNode* node);
+
+    /**
+     * Follow redo children from `from` to the new end of the current line.
+     * The old end, if it is now a leaf off the line, is abandoned.
+     */
+    void updateRedoTail(HistoryNode* from);
+
+    /**
+     * Detach a leaf from its parent, freeing its command
+     */
+    void removeLeaf(HistoryNode* node);
+
+    /**
+     * Drop one node by the eviction order above; false if only the current
+     * state is left
+     */
+    bool evictOne();
+
+    /**
+     * Evict until the tree fits the entry and byte limits
+     */
+    void enforceLimits();
 
 public:
-    UndoManager();
+    explicit UndoManager(size_t entryLimit = DEFAULT_MAX_ENTRIES, size_t byteLimit = DEFAULT_MAX_BYTES);
     ~UndoManager() = default;
 
     /**
-     * Execute a command and add it to the undo stack
+     * Change the history limits, dropping abandoned branches, then the
+     * oldest entries, then the farthest redo entries until the rest fits.
+     * An entry limit of 0 is treated as 1.
+     */
+    void setLimits(size_t entryLimit, size_t byteLimit);
+    size_t getMaxEntries() const;
+    size_t getMaxBytes() const;
+
+    /**
+     * How close together two commands must be executed for the second to be
+     * merged into the first (see UndoableCommand::mergeWith); 0 disables merging
+     */
+    void setMergeWindow(std::chrono::milliseconds window);
+    std::chrono::milliseconds getMergeWindow() const;
+
+    /**
+     * How to snapshot and restore the whole task list, for checkpoints.
+     * Every `interval` levels of the tree keeps a snapshot so jumpTo()
+     * replays at most that many commands; 0 disables checkpoints.
+     */
+    void setStateAccess(std::function<TaskList()> capture, std::function<void(const TaskList&)> restore);
+    void setCheckpointInterval(size_t interval);
+    size_t getCheckpointInterval() const;
+
+    /**
+     * Construct a command in the pool. Commands created here and the strings
+     * they keep are recycled from the pool instead of the general heap.
      */
-    void executeCommand(std::unique_ptr<UndoableCommand> command);
+    template <typename T, typename... Args>
+    std::unique_ptr<T, CommandDeleter> createCommand(Args&&... args) {
+        void* memory = commandPool.allocate(sizeof(T), alignof(T));
+        try {
+            T* command = new (memory) T(std::forward<Args>(args)...);
+            return std::unique_ptr<T, CommandDeleter>(command, CommandDeleter(&commandPool, sizeof(T), alignof(T)));
+        } catch (...) {
+            commandPool.deallocate(memory, sizeof(T), alignof(T));
+            throw;
+        }
+    }
+
+    /**
+     * Allocator commands use for their payloads
+     */
+    std::pmr::memory_resource* getCommandResource();
+
+    /**
+     * Execute a command and add it to the undo stack. Redo entries are kept
+     * as a branch of the history tree.
+     */
+    void executeCommand(CommandPtr command);
 
     /**
      * Check if undo is possible
@@ -342,7 +806,7 @@ public:
     std::string getLastRedoDescription() const;
 
     /**
-     * Get current memory usage in bytes
+     * Get the memory held by the undo and redo entries in bytes
      */
     size_t getCurrentMemoryUsage() const;
 
@@ -356,6 +820,27 @@ public:
      */
     size_t getRedoStackSize() const;
 
+    /**
+     * Nodes looked at while evicting since the manager was created. Once the
+     * history is full every new entry evicts one, and this grows by a small
+     * constant per eviction however large the tree is.
+     */
+    size_t getEvictionVisits() const;
+
+    /**
+     * Every kept state, depth-first with the current line before the
+     * branches that leave it, oldest branch first
+     */
+    std::vector<HistoryEntry> getHistoryTree() const;
+
+    /**
+     * Move the task list to the state of node `id`, on any branch. Replays
+     * from the nearest checkpoint above it when that is shorter than undoing
+     * back to the branch point. Both routes give the same list only because
+     * every change to it goes through a command. False if there is no such node.
+     */
+    bool jumpTo(uint64_t id);
+
     /**
      * Start a command group - subsequent commands will be grouped together
      */
@@ -370,6 +855,26 @@ public:
      * Check if currently in a command group
      */
     bool isGrouping() const;
+
+    /**
+     * Undo entries oldest first and redo entries next-to-redo first, for
+     * writing the history out. Only the current line: other branches are
+     * not persisted.
+     */
+    std::vector<const UndoableCommand*> getUndoEntries() const;
+    std::vector<const UndoableCommand*> getRedoEntries() const;
+
+    /**
+     * Replace the history with commands read back from disk, in the order
+     * the getters above return them. The current limits apply: the oldest
+     * undo entries and the farthest redo entries are dropped first.
+     */
+    void restoreHistory(std::vector<CommandPtr> undoEntries, std::vector<CommandPtr> redoEntries);
+
+    /**
+     * Drop every undo and redo entry (switching to another data file)
+     */
+    void clear();
 };
 
 #endif // UNDOMANAGER_H
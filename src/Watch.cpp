@@ -0,0 +1,180 @@
+#include "Watch.h"
+#include "Config.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+namespace {
+
+constexpr int MINUTES_PER_DAY = 24 * 60;
+
+// Read the same clock the timer is armed on; time() may use a coarser clock
+// that still reports the previous second right after the timer fires
+time_t wallClockNow() {
+  timespec now;
+  ::clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec;
+}
+
+int minutesSinceMidnight(time_t when) {
+  std::tm local = *std::localtime(&when);
+  return local.tm_hour * 60 + local.tm_min;
+}
+
+}  // namespace
+
+ScheduleWatcher::ScheduleWatcher(Config* cfg, const std::string& cfgPath, FilenameResolver resolver,
+                                 ScheduleLoader loader)
+    : config(cfg),
+      configPath(cfgPath),
+      resolveFilename(std::move(resolver)),
+      loadSchedule(std::move(loader)),
+      timerFd(-1) {}
+
+ScheduleWatcher::~ScheduleWatcher() {
+  if (timerFd >= 0) {
+    ::close(timerFd);
+  }
+}
+
+bool ScheduleWatcher::drainFileEvents(const std::string& dataFilename) {
+  bool changed = false;
+  bool configChanged = false;
+  std::string configName = std::filesystem::path(configPath).filename().string();
+  std::string dataName = std::filesystem::path(dataFilename).filename().string();
+
+  // Sidecars and other days share the directory; only our two files matter
+  files.drain([&](const std::string& dir, const std::string& name) {
+    if (name == configName && dir == directoryOf(configPath)) {
+      configChanged = true;
+    } else if (name == dataName && dir == directoryOf(dataFilename)) {
+      changed = true;
+    }
+  });
+
+  if (configChanged) {
+    reloadConfigFile(*config, configPath);
+    changed = true;
+  }
+  return changed;
+}
+
+time_t ScheduleWatcher::nextWakeup(const Schedule& schedule, time_t now) const {
+  // Past the last boundary (or past midnight) the next event is the new day's file
+  int boundary = schedule.nextBoundaryAfter(minutesSinceMidnight(now));
+  if (boundary < 0 || boundary > MINUTES_PER_DAY) {
+    boundary = MINUTES_PER_DAY;
+  }
+
+  // mktime normalizes minute overflow, including the jump to tomorrow
+  std::tm wake = *std::localtime(&now);
+  wake.tm_hour = 0;
+  wake.tm_min = boundary;
+  wake.tm_sec = 0;
+  wake.tm_isdst = -1;
+  return std::mktime(&wake);
+}
+
+bool ScheduleWatcher::armTimer(time_t wakeAt) {
+#ifdef __linux__
+  if (timerFd < 0) {
+    return false;
+  }
+  itimerspec spec;
+  std::memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = wakeAt;
+
+  // Absolute wall-clock time, so suspend/resume and clock steps can't make us
+  // oversleep; CANCEL_ON_SET also wakes us when the clock is changed
+  int flags = TFD_TIMER_ABSTIME;
+#ifdef TFD_TIMER_CANCEL_ON_SET
+  flags |= TFD_TIMER_CANCEL_ON_SET;
+#endif
+  return ::timerfd_settime(timerFd, flags, &spec, nullptr) == 0;
+#else
+  (void)wakeAt;
+  return false;
+#endif
+}
+
+void ScheduleWatcher::print(const std::string& line) {
+  if (line != lastLine) {
+    std::cout << line << std::endl;
+    lastLine = line;
+  }
+}
+
+int ScheduleWatcher::run() {
+  installStopHandler();
+
+#ifdef __linux__
+  timerFd = ::timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+#endif
+  if (!files.open()) {
+    std::cerr << "Warning: inotify unavailable, file changes are picked up at the next boundary" << std::endl;
+  }
+  files.watch(directoryOf(configPath));
+
+  while (!stopRequested()) {
+    std::string filename = resolveFilename("");
+    files.watch(directoryOf(filename));
+
+    // One snapshot for both, so the line and the timer always agree
+    Schedule schedule = loadSchedule(filename);
+    time_t now = wallClockNow();
+    print(schedule.describeCurrentSpan(minutesSinceMidnight(now)));
+
+    time_t wakeAt = nextWakeup(schedule, now);
+    int timeout = -1;
+    if (!armTimer(wakeAt)) {
+      timeout = static_cast<int>((wakeAt > now ? wakeAt - now : 0) * 1000 + 500);
+    }
+
+    pollfd fds[2];
+    nfds_t count = 0;
+    if (timerFd >= 0) {
+      fds[count++] = {timerFd, POLLIN, 0};
+    }
+    if (files.getFd() >= 0) {
+      fds[count++] = {files.getFd(), POLLIN, 0};
+    }
+
+    // Keep sleeping through file events that don't touch today's data
+    while (!stopRequested()) {
+      int ready = ::poll(fds, count, timeout);
+      if (ready < 0) {
+        if (errno == EINTR) continue;
+        std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+        return 1;
+      }
+      if (ready == 0) {
+        break;  // Fallback timeout reached the boundary
+      }
+
+      bool wake = false;
+      for (nfds_t i = 0; i < count; i++) {
+        if (!(fds[i].revents & POLLIN)) continue;
+        if (fds[i].fd == timerFd) {
+          // Either expired or cancelled by a clock change (ECANCELED); both mean recompute
+          uint64_t expirations = 0;
+          ssize_t n = ::read(timerFd, &expirations, sizeof(expirations));
+          (void)n;
+          wake = true;
+        } else if (drainFileEvents(filename)) {
+          wake = true;
+        }
+      }
+      if (wake) break;
+    }
+  }
+
+  return 0;
+}
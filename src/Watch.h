@@ -0,0 +1,43 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <ctime>
+#include <functional>
+#include <string>
+#include "Schedule.h"
+#include "Service.h"
+
+class Config;
+
+// `plan watch`: print the current task, then block until something can change
+// it. On Linux a timerfd is armed at the next task start/end (or midnight) on
+// the wall clock and inotify reports edits to the data or config file, so the
+// process uses no CPU between transitions.
+class ScheduleWatcher {
+ public:
+  using FilenameResolver = std::function<std::string(const std::string&)>;
+  using ScheduleLoader = std::function<Schedule(const std::string&)>;
+
+ private:
+  Config* config;
+  std::string configPath;
+  FilenameResolver resolveFilename;
+  ScheduleLoader loadSchedule;
+  int timerFd;
+  DirectoryWatcher files;
+  std::string lastLine;
+
+  bool drainFileEvents(const std::string& dataFilename);  // True when the day or config changed
+  time_t nextWakeup(const Schedule& schedule, time_t now) const;
+  bool armTimer(time_t wakeAt);
+  void print(const std::string& line);
+
+ public:
+  ScheduleWatcher(Config* cfg, const std::string& cfgPath, FilenameResolver resolver,
+                  ScheduleLoader loader);
+  ~ScheduleWatcher();
+
+  int run();  // Print transitions until SIGINT/SIGTERM, returns the process exit code
+};
+
+#endif  // WATCH_H
@@ -13,10 +13,31 @@
 #include <filesystem>
 #include <cstdlib>
 #include <cstring>
+#include <chrono>
+#include <fstream>
+#include <nlohmann/json.hpp>
 
 #include "TaskManager.h"
 #include "Config.h"
 #include "UndoManager.h"
+#include "Schedule.h"
+#include "Daemon.h"
+#include "ScheduleShm.h"
+#include "ScheduleCache.h"
+#include "Watch.h"
+#include "Notifier.h"
+#include "DateRange.h"
+#include "ThreadPool.h"
+#include "ArchiveStore.h"
+#include "ContentStore.h"
+#include "ColumnStore.h"
+#include "PackStore.h"
+#include "Query.h"
+#include "SearchIndex.h"
+#include "FreeSlots.h"
+#include "DayCache.h"
+#include <map>
+#include <unordered_map>
 
 using namespace ftxui;
 
@@ -38,8 +59,8 @@ std::string expandHomePath(const std::string& path) {
   return std::string(home) + path.substr(1);
 }
 
-// Helper function to get config file path with environment variable support
-std::string getConfigFilePath() {
+// Helper function to resolve the config file path with environment variable support
+std::string resolveConfigFilePath() {
   std::string configPath;
 
   // Priority 1: PLAN_CONFIG_FILE (full path to config file)
@@ -66,6 +87,13 @@ std::string getConfigFilePath() {
     }
   }
 
+  return configPath;
+}
+
+// Helper function to get config file path, creating its directory if needed
+std::string getConfigFilePath() {
+  std::string configPath = resolveConfigFilePath();
+
   // Ensure the config directory exists
   std::filesystem::path configDir = std::filesystem::path(configPath).parent_path();
   try {
@@ -77,12 +105,66 @@ std::string getConfigFilePath() {
   return configPath;
 }
 
-// Helper function to get current time in minutes since midnight
-int getCurrentTimeInMinutes() {
-  auto now = std::time(nullptr);
-  auto tm = *std::localtime(&now);
-  return tm.tm_hour * 60 + tm.tm_min;
-}
+// Startup-phase breakdown printed to stderr with --timing
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(bool enabled)
+      : enabled(enabled), start(std::chrono::steady_clock::now()), last(start) {}
+
+  void mark(const std::string& phase) {
+    if (!enabled) return;
+    auto now = std::chrono::steady_clock::now();
+    phases.emplace_back(phase, std::chrono::duration<double, std::micro>(now - last).count());
+    last = now;
+  }
+
+  void report(const std::string& path) const {
+    if (!enabled) return;
+    double total = std::chrono::duration<double, std::micro>(last - start).count();
+    std::cerr << "Startup timing (" << path << "):\n";
+    for (const auto& phase : phases) {
+      std::cerr << "  " << std::left << std::setw(24) << phase.first
+                << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+                << phase.second << " us\n";
+    }
+    std::cerr << "  " << std::left << std::setw(24) << "total"
+              << std::right << std::setw(10) << total << " us" << std::endl;
+  }
+
+ private:
+  bool enabled;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point last;
+  std::vector<std::pair<std::string, double>> phases;
+};
+
+// Collects command output and hands it to the stream in large writes, so
+// output spanning many days isn't flushed line by line
+class BufferedWriter {
+ public:
+  explicit BufferedWriter(std::ostream& out, size_t capacity = 64 * 1024) : out(out), capacity(capacity) {
+    buffer.reserve(capacity);
+  }
+  ~BufferedWriter() { flush(); }
+
+  void write(const std::string& text) {
+    buffer += text;
+    if (buffer.size() >= capacity) {
+      flush();
+    }
+  }
+
+  void flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+  }
+
+ private:
+  std::ostream& out;
+  size_t capacity;
+  std::string buffer;
+};
 
 // Helper function to check if a string is a valid date format (YYYY-MM-DD)
 bool isValidDateFormat(const std::string& str) {
@@ -117,52 +199,22 @@ std::string resolveCustomFilename(const std::string& input, const Config& config
   return dataDir + "/" + input + extension;
 }
 
-// Helper function to convert minutes to HH:MM format
-std::string minutesToTimeString(int minutes) {
-  int hours = minutes / 60;
-  int mins = minutes % 60;
-  std::ostringstream oss;
-  oss << std::setfill('0') << std::setw(2) << hours << ":"
-      << std::setfill('0') << std::setw(2) << mins;
-  return oss.str();
-}
-
 // Helper function to find current task
 std::string getCurrentTask(TaskManager& manager) {
-  int currentTime = getCurrentTimeInMinutes();
-  auto tasks = manager.getTasks();
-
-  for (size_t i = 0; i < tasks.size(); i++) {
-    int taskStart = tasks[i].getStartInt();
-    int taskEnd = taskStart + tasks[i].getActLength();
-
-    if (currentTime >= taskStart && currentTime < taskEnd) {
-      int remainingMinutes = taskEnd - currentTime;
-      return tasks[i].getName() + " (ends at " + minutesToTimeString(taskEnd) +
-             ", " + std::to_string(remainingMinutes) + " min remaining)";
-    }
-  }
-
-  return "No active task at current time (" + minutesToTimeString(currentTime) + ")";
+  return Schedule(manager.getTasks()).describeCurrent(getCurrentTimeInMinutes());
 }
 
 // Helper function to find next task
 std::string getNextTask(TaskManager& manager) {
-  int currentTime = getCurrentTimeInMinutes();
-  auto tasks = manager.getTasks();
-
-  // Find the next task that starts after current time
-  for (size_t i = 0; i < tasks.size(); i++) {
-    int taskStart = tasks[i].getStartInt();
-
-    if (taskStart > currentTime) {
-      int minutesUntil = taskStart - currentTime;
-      return tasks[i].getName() + " (starts at " + minutesToTimeString(taskStart) +
-             ", in " + std::to_string(minutesUntil) + " minutes)";
-    }
-  }
+  return Schedule(manager.getTasks()).describeNext(getCurrentTimeInMinutes());
+}
 
-  return "No upcoming tasks today";
+// Helper function to populate demonstration tasks when no data file exists
+void addDefaultTasks(TaskManager& manager) {
+  manager.addTask("A", "10:00", 60, false);
+  manager.addTask("B", "13:30", 10, false);
+  manager.addTask("C", 60, false);
+  manager.addTask("D", 15, false);
 }
 
 // Helper function to print usage information
@@ -173,11 +225,26 @@ void printUsage(const char* programName) {
   std::cout << "  now    - Show current active task\n";
   std::cout << "  next   - Show next upcoming task\n";
   std::cout << "  list   - Show all tasks for today\n";
+  std::cout << "  stats  - Show task count and scheduled time for today\n";
+  std::cout << "  daemon - Keep schedules in memory and answer now/next/list over a Unix socket\n";
+  std::cout << "  watch  - Print the current task each time it changes (sleeps until the next boundary)\n";
+  std::cout << "  archive --before YYYY-MM-DD - Move older day files into a single archive file\n";
+  std::cout << "  pack [YYYY-MM] - Compress a month's day files (default: every past month) into a pack file\n";
   std::cout << "  (no args) - Launch interactive task manager (loads last session)\n";
   std::cout << "\nDate parameter (YYYY-MM-DD format):\n";
   std::cout << "  " << programName << " 2024-01-15         - Interactive mode for specific date\n";
   std::cout << "  " << programName << " now 2024-01-15     - Show current task for specific date\n";
   std::cout << "  " << programName << " list 2024-01-15    - List tasks for specific date\n";
+  std::cout << "\nDate ranges (now, next, list, stats; days are loaded in parallel):\n";
+  std::cout << "  " << programName << " list 2024-01-01..2024-03-31  - List every day that has a data file\n";
+  std::cout << "  " << programName << " stats 2024-01-01..2024-01-31 - Per-day and total scheduled time\n";
+  std::cout << "\nHistory statistics (all days on record, or FIRST..LAST):\n";
+  std::cout << "  " << programName << " stats --by-name [FIRST..LAST]      - Per-name totals, averages and spread\n";
+  std::cout << "  " << programName << " stats --name NAME [FIRST..LAST]    - One name, with a length histogram\n";
+  std::cout << "  " << programName << " search TERMS...                    - Find past tasks by name, best match first\n";
+  std::cout << "  " << programName << " query \"rigid and length>=60\"       - Tasks matching a condition, as TSV (--json, --day DATE)\n";
+  std::cout << "  " << programName << " at 2024-03-05T14:10                - What was scheduled then (at - reads times from stdin)\n";
+  std::cout << "  " << programName << " free 45 [FIRST..LAST|DATE]         - Earliest 45-minute gap between fixed tasks\n";
   std::cout << "\nCustom filename parameter:\n";
   std::cout << "  " << programName << " today.json         - Interactive mode with custom file\n";
   std::cout << "  " << programName << " project-alpha      - Interactive mode (auto-adds .json extension)\n";
@@ -199,6 +266,22 @@ void printUsage(const char* programName) {
   std::cout << "  PLAN_CONFIG_HOME=/path/to/config/dir   - Use custom config directory\n";
   std::cout << "  XDG_CONFIG_HOME=/path/to/configs       - Use XDG config directory\n";
   std::cout << "\nData files format: Any .json filename (not limited to date-based naming)\n";
+  std::cout << "\nDaemon:\n";
+  std::cout << "  While '" << programName << " daemon' is running, now/next/list are answered by it\n";
+  std::cout << "  PLAN_SOCKET=/path/to/plan.sock           - Override the daemon socket path\n";
+  std::cout << "\nShared Memory:\n";
+  std::cout << "  The interactive session and the daemon publish the computed schedule to shared memory\n";
+  std::cout << "  " << programName << " now --shm          - Read the published schedule instead of the data file\n";
+  std::cout << "  PLAN_SHM=name                            - Override the shared-memory segment name\n";
+  std::cout << "\nSchedule Cache:\n";
+  std::cout << "  Saving writes the computed schedule to a hidden .<file>.sched sidecar; now/next/list\n";
+  std::cout << "  use it while the data file is unchanged\n";
+  std::cout << "  " << programName << " list --timing        - Print a startup-phase timing breakdown to stderr\n";
+  std::cout << "\nArchive:\n";
+  std::cout << "  Archived days load like any other date (" << programName << " list 2023-06-01); saving one\n";
+  std::cout << "  in interactive mode writes a day file again, which takes precedence over the archive\n";
+  std::cout << "  Packed days (data/tasks_YYYY-MM.pack) load and show up in the file browser the same way;\n";
+  std::cout << "  a day is looked up as a day file first, then in its month's pack, then in the archive\n";
   std::cout << "\nFile Browser:\n";
   std::cout << "  Press 'f' in interactive mode to browse and select any JSON task file\n";
   std::cout << "  Auto-detects available tools: fzf (best) > fd > find > simple selection\n";
@@ -206,20 +289,853 @@ void printUsage(const char* programName) {
 
 // Helper function to list all tasks
 void listAllTasks(TaskManager& manager) {
-  auto tasks = manager.getTasks();
-  std::cout << "Today's Tasks:\n";
-  std::cout << "=============\n";
+  std::cout << Schedule(manager.getTasks()).describeList();
+}
+
+// Print now/next/list from the schedule sidecar of dataFilename, which was
+// resolved from target. Returns false when the sidecar is stale or missing,
+// in which case the caller falls back to loading the data file.
+bool runCachedCommand(const std::string& command, const std::string& target, const std::string& dataFilename,
+                      PhaseTimer& timer) {
+  Schedule schedule;
+  if (!ScheduleCache::load(dataFilename, schedule)) {
+    timer.mark("schedule cache miss");
+    return false;
+  }
+  timer.mark("schedule cache");
+
+  // Same messages as the full path
+  if (!target.empty()) {
+    if (isValidDateFormat(target)) {
+      std::cout << "Loaded data for " << target << ": " << dataFilename << std::endl;
+    } else {
+      std::cout << "Loaded data from " << target << ": " << dataFilename << std::endl;
+    }
+  }
+
+  if (command == "now") {
+    std::cout << schedule.describeCurrent(getCurrentTimeInMinutes()) << std::endl;
+  } else if (command == "next") {
+    std::cout << schedule.describeNext(getCurrentTimeInMinutes()) << std::endl;
+  } else {
+    std::cout << schedule.describeList();
+  }
+  timer.mark("output");
+  timer.report("schedule cache");
+  return true;
+}
+
+// Turn a date/filename argument (empty for today) into a data file path
+std::string resolveDataFilename(const std::string& arg, Config& config) {
+  TaskManager pathManager(&config);
+  if (arg.empty()) {
+    return pathManager.getConfiguredFilename();
+  }
+  if (isValidDateFormat(arg)) {
+    return pathManager.getConfiguredFilename(arg);
+  }
+  return resolveCustomFilename(arg, config);
+}
+
+// Data file for a date/filename argument (empty for today), reading only the
+// config keys that locate it
+std::string locateDataFile(const std::string& arg) {
+  std::string configPath = resolveConfigFilePath();
+  Config config(configPath);
+  if (std::filesystem::exists(configPath)) {
+    config.loadFromFile({"data-dir", "file-extension"});
+  }
+  return resolveDataFilename(arg, config);
+}
+
+// Computed schedule of a data file, from its sidecar when that is still valid
+Schedule loadScheduleForFile(const std::string& filename, Config& config) {
+  Schedule schedule;
+  if (ScheduleCache::load(filename, schedule)) {
+    return schedule;
+  }
+
+  // Quiet about a missing day: the daemon and `plan watch` print to stdout
+  TaskManager dayManager(&config);
+  if (!dayManager.loadExisting(filename)) {
+    addDefaultTasks(dayManager);
+  }
+  dayManager.calcActLen();
+  dayManager.calcStartTimes();
+  return Schedule(dayManager.getTasks());
+}
+
+// Task count and scheduled time of one day, or of a whole range summed up
+struct DayStats {
+  size_t days = 0;  // Days that had a data file
+  size_t tasks = 0;
+  size_t fixed = 0;
+  size_t rigid = 0;
+  long minutes = 0;
+
+  void add(const Schedule& schedule) {
+    days++;
+    for (const auto& entry : schedule.getEntries()) {
+      tasks++;
+      fixed += entry.fixed;
+      rigid += entry.rigid;
+      minutes += entry.actLength;
+    }
+  }
+
+  void add(const DayStats& other) {
+    days += other.days;
+    tasks += other.tasks;
+    fixed += other.fixed;
+    rigid += other.rigid;
+    minutes += other.minutes;
+  }
+
+  std::string describe() const {
+    std::ostringstream out;
+    out << tasks << " tasks (" << fixed << " fixed, " << rigid << " rigid), " << minutes / 60 << "h "
+        << minutes % 60 << "m scheduled";
+    return out.str();
+  }
+};
+
+// now/next/list/stats for every day of FIRST..LAST. Each day is loaded and
+// computed on the pool with its own TaskManager; results are written in date
+// order as soon as every earlier day is done. Days without a data file are
+// skipped.
+int runRangeCommand(const std::string& command, const DateRange& range, Config& config) {
+  struct DayResult {
+    bool found = false;
+    std::string text;
+    DayStats stats;
+  };
+
+  int minutes = getCurrentTimeInMinutes();
+  std::vector<std::string> days = range.days();
+
+  // Archived days of the range come out of one scan of the archive
+  std::map<std::string, std::string> archived;
+  ArchiveStore archive(TaskManager(&config).getArchivePath());
+  std::vector<std::pair<std::string, std::string>> scanned;
+  if (archive.open() && archive.scan(days.front(), days.back(), scanned)) {
+    archived.insert(scanned.begin(), scanned.end());
+  }
+
+  ThreadPool pool(std::min(static_cast<size_t>(std::max(config.getInt("range-threads", 0), 0)), days.size()));
+  std::vector<std::future<DayResult>> results;
+  results.reserve(days.size());
+  for (const std::string& day : days) {
+    results.push_back(pool.submit([&config, &command, &archived, day, minutes]() {
+      DayResult result;
+      std::string filename = resolveDataFilename(day, config);
+      Schedule schedule;
+      if (std::filesystem::exists(filename)) {
+        schedule = loadScheduleForFile(filename, config);
+      } else {
+        TaskManager dayManager(&config);
+        std::string content;
+        if (!dayManager.readPackedDay(filename, content)) {
+          auto archivedDay = archived.find(day);
+          if (archivedDay == archived.end()) {
+            return result;
+          }
+          content = archivedDay->second;
+        }
+        if (!dayManager.loadFromContent(content, filename)) {
+          return result;
+        }
+        dayManager.calcActLen();
+        dayManager.calcStartTimes();
+        schedule = Schedule(dayManager.getTasks());
+      }
+      result.found = true;
+      if (command == "now") {
+        result.text = day + ": " + schedule.describeCurrent(minutes) + "\n";
+      } else if (command == "next") {
+        result.text = day + ": " + schedule.describeNext(minutes) + "\n";
+      } else if (command == "list") {
+        result.text = schedule.describeList("Tasks for " + day) + "\n";
+      } else {
+        result.stats.add(schedule);
+        result.text = day + ": " + result.stats.describe() + "\n";
+      }
+      return result;
+    }));
+  }
+
+  BufferedWriter out(std::cout);
+  size_t found = 0;
+  DayStats total;
+  for (auto& pending : results) {
+    DayResult result = pending.get();
+    if (result.found) {
+      found++;
+      out.write(result.text);
+      total.add(result.stats);
+    }
+  }
+
+  if (found == 0) {
+    out.write("No data files between " + days.front() + " and " + days.back() + "\n");
+  } else if (command == "stats") {
+    out.write("Total over " + std::to_string(total.days) + " days: " + total.describe() + "\n");
+  }
+  return 0;
+}
+
+// Bring the column store of the data directory up to date with the day
+// files, packs and archive; returns the days that had to be read
+size_t refreshColumnStore(ColumnStore& store, Config& config) {
+  TaskManager pathManager(&config);
+  std::string dataDir = pathManager.getConfiguredDataDir();
+  auto extract = [&config](const std::string& content, const std::string& filename,
+                           std::vector<ColumnStore::Task>& tasks) {
+    TaskManager dayManager(&config);
+    if (!dayManager.loadFromContent(content, filename)) {
+      return false;
+    }
+    dayManager.calcActLen();
+    dayManager.calcStartTimes();
+    for (const auto& task : dayManager.getTasks()) {
+      tasks.push_back({task.getName(), task.getStartInt(), task.getLength(), task.getActLength(), task.isFixed(),
+                       task.isRigid()});
+    }
+    return true;
+  };
+  size_t daysRead = 0;
+  size_t threads = static_cast<size_t>(std::max(config.getInt("range-threads", 0), 0));
+  if (store.refresh(dataDir, config.getString("file-extension", ".json"), pathManager.getArchivePath(), extract,
+                    threads, daysRead)) {
+    store.save();
+  }
+  return daysRead;
+}
+
+// `stats --by-name` and `stats --name NAME`: per-name totals and length
+// distributions over every day on record (or FIRST..LAST, given as days
+// since 1970-01-01), from the column store brought up to date first
+int runNameStats(const std::string& name, int64_t firstDay, int64_t lastDay, Config& config, PhaseTimer& timer) {
+  TaskManager pathManager(&config);
+  ColumnStore store(ColumnStore::storePath(pathManager.getConfiguredDataDir()));
+  store.load();
+  timer.mark("load column store");
+  size_t daysRead = refreshColumnStore(store, config);
+  timer.mark("refresh: " + std::to_string(daysRead) + " days read");
+
+  std::vector<ColumnStore::NameSummary> summaries = store.summarize(firstDay, lastDay, name);
+  timer.mark("aggregate " + std::to_string(store.rowCount()) + " rows");
+  auto hoursAndMinutes = [](int64_t minutes) {
+    return std::to_string(minutes / 60) + "h " + std::to_string(minutes % 60) + "m";
+  };
+
+  BufferedWriter out(std::cout);
+  if (summaries.empty()) {
+    out.write(name.empty() ? "No tasks on record\n" : "No tasks named \"" + name + "\" on record\n");
+    return 0;
+  }
+  if (name.empty()) {
+    std::ostringstream table;
+    table << std::left << std::setw(24) << "Name" << std::right << std::setw(7) << "Times" << std::setw(7) << "Days"
+          << std::setw(11) << "Total" << std::setw(6) << "Avg" << std::setw(6) << "Min" << std::setw(6) << "Med"
+          << std::setw(6) << "P90" << std::setw(6) << "Max" << "\n";
+    for (const auto& summary : summaries) {
+      table << std::left << std::setw(24) << summary.name.substr(0, 23) << std::right << std::setw(7) << summary.count
+            << std::setw(7) << summary.days << std::setw(11) << hoursAndMinutes(summary.minutes) << std::setw(6)
+            << summary.minutes / static_cast<int64_t>(summary.count) << std::setw(6) << summary.shortest
+            << std::setw(6) << summary.median << std::setw(6) << summary.p90 << std::setw(6) << summary.longest
+            << "\n";
+    }
+    out.write(table.str());
+    return 0;
+  }
+
+  const auto& summary = summaries.front();
+  std::ostringstream detail;
+  detail << summary.name << ": " << summary.count << " times on " << summary.days << " days, "
+         << hoursAndMinutes(summary.minutes) << "\n";
+  detail << "  average " << summary.minutes / static_cast<int64_t>(summary.count) << "m, shortest " << summary.shortest
+         << "m, median " << summary.median << "m, p90 " << summary.p90 << "m, longest " << summary.longest << "m\n";
+  size_t widest = *std::max_element(summary.histogram.begin(), summary.histogram.end());
+  for (size_t bucket = 0; bucket < summary.histogram.size(); bucket++) {
+    if (summary.histogram[bucket] == 0) {
+      continue;
+    }
+    int low = static_cast<int>(bucket) * ColumnStore::HISTOGRAM_BUCKET;
+    detail << "  " << std::setw(4) << low << "-" << std::setw(4) << low + ColumnStore::HISTOGRAM_BUCKET - 1 << "m | "
+           << std::string(std::max<size_t>(summary.histogram[bucket] * 40 / widest, 1), '#') << " "
+           << summary.histogram[bucket] << "\n";
+  }
+  out.write(detail.str());
+  return 0;
+}
+
+std::string clockTime(int minutes) {
+  std::ostringstream time;
+  time << std::setfill('0') << std::setw(2) << (minutes / 60) % 24 << ":" << std::setw(2) << minutes % 60;
+  return time.str();
+}
+
+struct SearchResult {
+  std::string date;
+  uint32_t position;
+  ColumnStore::Task task;
+};
+
+// Tasks of every day on record whose names match query (see
+// SearchIndex::search), best first; the column store and the index are
+// brought up to date first. total counts every match, results holds at most
+// `limit` of them.
+std::vector<SearchResult> searchHistory(const std::string& query, size_t limit, Config& config, size_t& total,
+                                        size_t& days, PhaseTimer* timer = nullptr) {
+  TaskManager pathManager(&config);
+  std::string dataDir = pathManager.getConfiguredDataDir();
+  ColumnStore store(ColumnStore::storePath(dataDir));
+  store.load();
+  size_t daysRead = refreshColumnStore(store, config);
+  if (timer) {
+    timer->mark("refresh column store: " + std::to_string(daysRead) + " days read");
+  }
+
+  SearchIndex index(SearchIndex::indexPath(dataDir));
+  if (!index.load(store.generation())) {
+    index.build(store);
+    if (store.generation() != 0) {
+      index.save();
+    }
+    if (timer) {
+      timer->mark("rebuild index: " + std::to_string(index.termCount()) + " terms");
+    }
+  } else if (timer) {
+    timer->mark("load index");
+  }
+
+  std::vector<SearchIndex::Hit> hits = index.search(query, days);
+  total = hits.size();
+
+  std::vector<SearchResult> results;
+  for (const auto& hit : hits) {
+    if (results.size() == limit) {
+      break;
+    }
+    SearchResult result{DateRange::fromDayNumber(hit.day), hit.position, {}};
+    if (store.taskAt(hit.day, hit.position, result.task)) {
+      results.push_back(std::move(result));
+    }
+  }
+  if (timer) {
+    timer->mark("search");
+  }
+  return results;
+}
+
+// `search TERMS...`: the best matches among the tasks of every day on record
+int runSearch(const std::string& query, Config& config, PhaseTimer& timer) {
+  constexpr size_t SHOWN = 20;
+  size_t total = 0, days = 0;
+  std::vector<SearchResult> results = searchHistory(query, SHOWN, config, total, days, &timer);
+
+  std::ostringstream listing;
+  if (results.empty()) {
+    listing << "No tasks match \"" << query << "\"\n";
+  }
+  for (const auto& result : results) {
+    listing << result.date << "  " << clockTime(result.task.start) << "  " << std::left << std::setw(32)
+            << result.task.name << std::right << std::setw(5) << result.task.actLength << "m\n";
+  }
+  if (total > 0) {
+    listing << total << " matches on " << days << " days";
+    if (total > results.size()) {
+      listing << " (" << results.size() << " shown)";
+    }
+    listing << "\n";
+  }
+  BufferedWriter out(std::cout);
+  out.write(listing.str());
+  return 0;
+}
+
+// `query [--json] [--day DATE|FILE] EXPRESSION`: stream the tasks matching
+// EXPRESSION (see Query) as TSV or JSON lines, from every day on record or,
+// with --day, from one day's file as a task manager computes it
+int runQuery(const std::string& expression, bool json, bool oneDay, const std::string& dayArg, Config& config,
+             PhaseTimer& timer) {
+  Query query;
+  std::string error;
+  if (!Query::parse(expression, query, error)) {
+    std::cerr << "Invalid query: " << error << std::endl;
+    return 1;
+  }
+  timer.mark("parse");
+
+  BufferedWriter out(std::cout);
+  if (!json) {
+    out.write("date\tstart\tname\tlength\tactlength\tfixed\trigid\n");
+  }
+  size_t matches = 0;
+  int64_t lastDay = INT64_MIN;
+  std::string date;
+  auto emit = [&](const ColumnStore::Columns& columns, size_t row) {
+    matches++;
+    if (columns.dates[row] != lastDay) {  // Rows come in date order
+      lastDay = columns.dates[row];
+      date = DateRange::fromDayNumber(lastDay);
+    }
+    const std::string& name = (*columns.names)[columns.nameIds[row]];
+    bool fixed = (columns.flags[row] & ColumnStore::FIXED) != 0;
+    bool rigid = (columns.flags[row] & ColumnStore::RIGID) != 0;
+    if (json) {
+      // Only the name needs escaping; the rest is written as is
+      out.write("{\"date\":\"" + date + "\",\"startTime\":\"" + clockTime(columns.starts[row]) +
+                "\",\"name\":" + nlohmann::json(name).dump() + ",\"length\":" + std::to_string(columns.lengths[row]) +
+                ",\"actLength\":" + std::to_string(columns.actLengths[row]) + ",\"fixed\":" +
+                (fixed ? "true" : "false") + ",\"rigid\":" + (rigid ? "true" : "false") + "}\n");
+    } else {
+      out.write(date + "\t" + clockTime(columns.starts[row]) + "\t" + name + "\t" +
+                std::to_string(columns.lengths[row]) + "\t" + std::to_string(columns.actLengths[row]) + "\t" +
+                (fixed ? "yes" : "no") + "\t" + (rigid ? "yes" : "no") + "\n");
+    }
+  };
+
+  if (oneDay) {
+    std::string filename = resolveDataFilename(dayArg, config);
+    TaskManager manager(&config);
+    if (!manager.loadFromFile(filename)) {
+      std::cerr << "Could not load " << filename << std::endl;
+      return 1;
+    }
+    manager.calcActLen();
+    manager.calcStartTimes();
+    timer.mark("load " + filename);
+
+    // The day's own date when the file is named after one, today's otherwise
+    std::smatch dated;
+    std::string stem = std::filesystem::path(filename).filename().string();
+    int64_t day = 0;
+    if (!std::regex_search(stem, dated, std::regex("^tasks_(\\d{4}-\\d{2}-\\d{2})")) ||
+        !DateRange::toDayNumber(dated[1], day)) {
+      std::time_t now = std::time(nullptr);
+      std::ostringstream today;
+      today << std::put_time(std::localtime(&now), "%Y-%m-%d");
+      DateRange::toDayNumber(today.str(), day);
+    }
+
+    // One row per task, in the column store's layout
+    std::vector<std::string> names;
+    std::vector<int32_t> dates, starts, lengths, actLengths;
+    std::vector<uint32_t> nameIds;
+    std::vector<uint8_t> flags;
+    for (const auto& task : manager.getTasks()) {
+      nameIds.push_back(static_cast<uint32_t>(names.size()));
+      names.push_back(task.getName());
+      dates.push_back(static_cast<int32_t>(day));
+      starts.push_back(task.getStartInt());
+      lengths.push_back(task.getLength());
+      actLengths.push_back(task.getActLength());
+      flags.push_back(static_cast<uint8_t>((task.isFixed() ? ColumnStore::FIXED : 0) |
+                                           (task.isRigid() ? ColumnStore::RIGID : 0)));
+    }
+    ColumnStore::Columns columns{dates.data(), nameIds.data(), starts.data(), lengths.data(),
+                                 actLengths.data(), flags.data(), dates.size(), &names};
+    query.run(columns, [&](size_t row) { emit(columns, row); });
+  } else {
+    TaskManager pathManager(&config);
+    ColumnStore store(ColumnStore::storePath(pathManager.getConfiguredDataDir()));
+    store.load();
+    size_t daysRead = refreshColumnStore(store, config);
+    timer.mark("refresh column store: " + std::to_string(daysRead) + " days read");
+    ColumnStore::Columns columns = store.columns(query.firstDay(), query.lastDay());
+    query.run(columns, [&](size_t row) { emit(columns, row); });
+  }
+  timer.mark(std::to_string(matches) + " matches");
+  return 0;
+}
+
+// Date and minute of day of 2024-03-05T14:10 (or a space instead of T, with
+// optional seconds, which are dropped)
+bool parseDateTime(const std::string& text, std::string& date, int64_t& day, int& minutes) {
+  // Parsed by hand: batches run to many thousands of lines
+  auto digits = [&](size_t at, size_t count) {
+    if (at + count > text.size()) {
+      return -1;
+    }
+    int value = 0;
+    for (size_t i = at; i < at + count; i++) {
+      if (!std::isdigit(static_cast<unsigned char>(text[i]))) {
+        return -1;
+      }
+      value = value * 10 + (text[i] - '0');
+    }
+    return value;
+  };
+  if (text.size() < 15 || (text[10] != 'T' && text[10] != ' ') || !DateRange::toDayNumber(text.substr(0, 10), day)) {
+    return false;
+  }
+  size_t at = text[12] == ':' ? 12 : 13;  // H:MM or HH:MM
+  int hours = digits(11, at - 11);
+  int mins = at < text.size() && text[at] == ':' ? digits(at + 1, 2) : -1;
+  at += 3;
+  if (at < text.size()) {  // Seconds, then maybe a fraction of one
+    if (text[at] != ':' || digits(at + 1, 2) < 0) {
+      return false;
+    }
+    at += 3;
+    if (at < text.size() && (text[at] != '.' || at + 1 == text.size() ||
+                             text.find_first_not_of("0123456789", at + 1) != std::string::npos)) {
+      return false;
+    }
+  }
+  if (hours < 0 || hours > 23 || mins < 0 || mins > 59) {
+    return false;
+  }
+  date = text.substr(0, 10);
+  minutes = hours * 60 + mins;
+  return true;
+}
+
+// One day from its day file, pack or archive, with lengths and start times
+// computed; false if none holds the day
+bool loadDay(const std::string& date, Config& config, TaskManager& dayManager) {
+  if (!dayManager.loadExisting(resolveDataFilename(date, config))) {
+    return false;
+  }
+  dayManager.calcActLen();
+  dayManager.calcStartTimes();
+  return true;
+}
+
+// Computed schedule of one day: its sidecar while that is valid, otherwise
+// computed from its day file, pack or archive; false if none holds the day
+bool loadDaySchedule(const std::string& date, Config& config, Schedule& schedule) {
+  if (ScheduleCache::load(resolveDataFilename(date, config), schedule)) {
+    return true;
+  }
+  TaskManager dayManager(&config);
+  if (!loadDay(date, config, dayManager)) {
+    return false;
+  }
+  schedule = Schedule(dayManager.getTasks());
+  return true;
+}
+
+// `at DATETIME...`: the task scheduled at each time. `at -` reads one time
+// per line from stdin (anything after a tab or comma is ignored) and writes
+// TSV; a batch finds every day in the column store, so it costs one load
+// however many days it spans.
+int runAt(const std::vector<std::string>& times, bool batch, Config& config, PhaseTimer& timer) {
+  TaskManager pathManager(&config);
+  ColumnStore store(ColumnStore::storePath(pathManager.getConfiguredDataDir()));
+  if (batch) {
+    store.load();
+    size_t daysRead = refreshColumnStore(store, config);
+    timer.mark("refresh column store: " + std::to_string(daysRead) + " days read");
+  }
+  std::unordered_map<int64_t, std::pair<bool, Schedule>> schedules;  // Day -> (on record, schedule)
+
+  BufferedWriter out(std::cout);
+  if (batch) {
+    out.write("time\tstatus\ttask\tstart\tend\n");
+  }
+  int status = 0;
+  for (const auto& time : times) {
+    std::string date;
+    int64_t day = 0;
+    int minutes = 0;
+    if (!parseDateTime(time, date, day, minutes)) {
+      out.write(batch ? time + "\tinvalid\t\t\t\n" : time + ": not a date and time (YYYY-MM-DDTHH:MM)\n");
+      status = 1;
+      continue;
+    }
+
+    if (!batch) {
+      auto found = schedules.find(day);
+      if (found == schedules.end()) {
+        found = schedules.emplace(day, std::make_pair(false, Schedule())).first;
+        found->second.first = loadDaySchedule(date, config, found->second.second);
+      }
+      const auto& [onRecord, schedule] = found->second;
+      out.write(date + " " + minutesToTimeString(minutes) + "  " +
+                (onRecord ? schedule.describeCurrentSpan(minutes) : "No data for this day") + "\n");
+      continue;
+    }
+
+    // The day's rows are in task order, like the entries Schedule::entryAt scans
+    ColumnStore::Columns rows = store.columns(day, day);
+    size_t row = 0;
+    while (row < rows.count && !(minutes >= rows.starts[row] && minutes < rows.starts[row] + rows.actLengths[row])) {
+      row++;
+    }
+    if (rows.count == 0) {
+      out.write(time + "\tno-data\t\t\t\n");
+    } else if (row == rows.count) {
+      out.write(time + "\tidle\t\t\t\n");
+    } else {
+      out.write(time + "\ttask\t" + (*rows.names)[rows.nameIds[row]] + "\t" + minutesToTimeString(rows.starts[row]) +
+                "\t" + minutesToTimeString(rows.starts[row] + rows.actLengths[row]) + "\n");
+    }
+  }
+  timer.mark(std::to_string(times.size()) + " times");
+  return status;
+}
+
+// Free time of a loaded day, within its working window
+FreeSlots freeSlotsOf(TaskManager& manager) {
+  return FreeSlots(Schedule(manager.getTasks()).getEntries(), TaskManager::DAY_START,
+                   TaskManager::DAY_START + manager.getDayLength());
+}
+
+// `free MINUTES [RANGE|DATE]`: the earliest gap of at least MINUTES between
+// the fixed and rigid tasks of each day, the days worked out on the pool. A
+// day with no plan yet is free for its whole default length. Without a
+// range, the first such gap from now on, looking up to two weeks ahead.
+int runFree(int minutes, const DateRange* range, Config& config, PhaseTimer& timer) {
+  struct DayResult {
+    bool onRecord = false;
+    bool found = false;
+    FreeSlots::Span gap{};
+  };
+
+  std::time_t now = std::time(nullptr);
+  std::ostringstream formatted;
+  formatted << std::put_time(std::localtime(&now), "%Y-%m-%d");
+  std::string today = formatted.str();
+  int nowMinutes = getCurrentTimeInMinutes();
+  std::vector<std::string> days;
+  if (range) {
+    days = range->days();
+  } else {
+    int64_t day = 0;
+    DateRange::toDayNumber(today, day);
+    for (int64_t ahead = 0; ahead < 14; ahead++) {
+      days.push_back(DateRange::fromDayNumber(day + ahead));
+    }
+  }
+
+  ThreadPool pool(std::min(static_cast<size_t>(std::max(config.getInt("range-threads", 0), 0)), days.size()));
+  std::vector<std::future<DayResult>> results;
+  results.reserve(days.size());
+  for (const std::string& day : days) {
+    // The part of today that has passed is no use any more
+    int from = day == today ? nowMinutes : 0;
+    results.push_back(pool.submit([&config, day, minutes, from]() {
+      DayResult result;
+      TaskManager dayManager(&config);
+      result.onRecord = loadDay(day, config, dayManager);
+      TaskManager emptyDay(&config);
+      result.found = freeSlotsOf(result.onRecord ? dayManager : emptyDay).earliest(minutes, from, result.gap);
+      return result;
+    }));
+  }
+
+  BufferedWriter out(std::cout);
+  std::string wanted = std::to_string(minutes) + "-minute";
+  bool any = false;
+  for (size_t i = 0; i < days.size(); i++) {
+    DayResult result = results[i].get();
+    std::string note = result.onRecord ? "" : " (no plan yet)";
+    if (result.found) {
+      out.write(days[i] + "  " + minutesToTimeString(result.gap.start) + "  free until " +
+                minutesToTimeString(result.gap.end) + " (" + std::to_string(result.gap.length()) + "m)" + note + "\n");
+      any = true;
+      if (!range) {
+        break;
+      }
+    } else if (range) {
+      out.write(days[i] + "  no " + wanted + " gap" + note + "\n");
+    }
+  }
+  if (!range && !any) {
+    out.write("No " + wanted + " gap between " + days.front() + " and " + days.back() + "\n");
+  }
+  timer.mark(std::to_string(days.size()) + " days");
+  return 0;
+}
+
+// Move the data files of the days before `before` into the archive, keeping
+// what it already holds (a day file wins over its archived copy). Files and
+// their sidecars are only removed once the new archive is in place.
+int runArchive(const std::string& before, Config& config) {
+  TaskManager pathManager(&config);
+  std::string dataDir = pathManager.getConfiguredDataDir();
+  std::string extension = config.getString("file-extension", ".json");
+  std::string archivePath = pathManager.getArchivePath();
+
+  std::map<std::string, std::string> days;
+  ArchiveStore archive(archivePath);
+  if (std::filesystem::exists(archivePath)) {
+    std::vector<std::pair<std::string, std::string>> archived;
+    if (!archive.open() || !archive.scanIntact("0000-01-01", "9999-12-31", archived)) {
+      std::cerr << "Error: " << archivePath << " is damaged; leaving it and the day files alone" << std::endl;
+      return 1;
+    }
+    days.insert(archived.begin(), archived.end());
+  }
+  size_t alreadyArchived = days.size();
+
+  std::vector<std::string> files;
+  size_t unchanged = 0;  // Day files holding the same tasks as their archived copy
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(dataDir, ec)) {
+    std::string name = entry.path().filename().string();
+    int64_t day = 0;
+    if (!entry.is_regular_file() || name.size() != 16 + extension.size() || name.compare(0, 6, "tasks_") != 0 ||
+        name.compare(16, std::string::npos, extension) != 0 || !DateRange::toDayNumber(name.substr(6, 10), day) ||
+        name.substr(6, 10) >= before) {
+      continue;
+    }
+
+    // Only days that load cleanly; anything else stays a file to be looked at
+    std::ifstream file(entry.path(), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    TaskManager check(0);
+    if (!file || !check.loadFromContent(content, entry.path().string())) {
+      std::cerr << "Skipping " << entry.path().string() << ": not a valid data file" << std::endl;
+      continue;
+    }
+    uint64_t fileKey = 0, archivedKey = 0;
+    if (days.count(name.substr(6, 10)) && ContentStore::dayKey(content, fileKey) &&
+        archive.dayKey(name.substr(6, 10), archivedKey) && fileKey == archivedKey) {
+      unchanged++;
+    }
+    days[name.substr(6, 10)] = std::move(content);
+    files.push_back(entry.path().string());
+  }
+
+  if (files.empty()) {
+    std::cout << "No day files before " << before << " in " << dataDir << std::endl;
+    return 0;
+  }
+
+  ArchiveStore written(archivePath);
+  if (!ArchiveStore::write(archivePath, days) || !written.open() || written.size() != days.size()) {
+    std::cerr << "Error: Could not write " << archivePath << "; no day files were removed" << std::endl;
+    return 1;
+  }
+  for (const std::string& file : files) {
+    std::filesystem::remove(file, ec);
+    std::filesystem::remove(ScheduleCache::sidecarPath(file), ec);
+    std::filesystem::remove(UndoLog::sidecarPath(file), ec);
+  }
+
+  std::cout << "Archived " << files.size() << " days before " << before << " into " << archivePath << " ("
+            << days.size() << " days, " << days.size() - alreadyArchived << " new";
+  if (unchanged > 0) {
+    std::cout << ", " << unchanged << " unchanged";
+  }
+  std::cout << "; " << written.distinctDays() << " distinct days, " << written.distinctTasks() << " distinct tasks)"
+            << std::endl;
+  return 0;
+}
+
+// Compress the day files of a month (YYYY-MM), or of every month before the
+// current one when month is empty, into the month's pack. Days already in the
+// pack are kept unless a day file replaces them; files and their sidecars are
+// only removed once the new pack reads back in full.
+int runPack(const std::string& month, Config& config) {
+  TaskManager pathManager(&config);
+  std::string dataDir = pathManager.getConfiguredDataDir();
+  std::string extension = config.getString("file-extension", ".json");
+
+  std::string currentMonth;
+  {
+    auto now = std::time(nullptr);
+    std::ostringstream formatted;
+    formatted << std::put_time(std::localtime(&now), "%Y-%m");
+    currentMonth = formatted.str();
+  }
+
+  // Month -> day files to pack
+  std::map<std::string, std::vector<std::filesystem::path>> months;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(dataDir, ec)) {
+    std::string name = entry.path().filename().string();
+    int64_t day = 0;
+    if (!entry.is_regular_file() || name.size() != 16 + extension.size() || name.compare(0, 6, "tasks_") != 0 ||
+        name.compare(16, std::string::npos, extension) != 0 || !DateRange::toDayNumber(name.substr(6, 10), day)) {
+      continue;
+    }
+    std::string dayMonth = name.substr(6, 7);
+    if (month.empty() ? dayMonth < currentMonth : dayMonth == month) {
+      months[dayMonth].push_back(entry.path());
+    }
+  }
+
+  if (months.empty()) {
+    std::cout << "No day files to pack in " << dataDir << (month.empty() ? "" : " for " + month) << std::endl;
+    return 0;
+  }
+
+  int status = 0;
+  for (const auto& [packMonth, paths] : months) {
+    std::string packPath = PackStore::packPath(dataDir, packMonth);
+    std::map<std::string, std::string> days;
+    size_t bytesBefore = 0;
+    if (std::filesystem::exists(packPath)) {
+      PackStore pack(packPath);
+      if (!pack.open() || !pack.readAll(days)) {
+        std::cerr << "Error: " << packPath << " is damaged; leaving it and " << packMonth << "'s day files alone"
+                  << std::endl;
+        status = 1;
+        continue;
+      }
+      bytesBefore += std::filesystem::file_size(packPath, ec);
+    }
+
+    // Only days that load cleanly; anything else stays a file to be looked at
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+      std::ifstream file(path, std::ios::binary);
+      std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      TaskManager check(0);
+      if (!file || !check.loadFromContent(content, path.string())) {
+        std::cerr << "Skipping " << path.string() << ": not a valid data file" << std::endl;
+        continue;
+      }
+      bytesBefore += content.size();
+      days[path.filename().string().substr(6, 10)] = std::move(content);
+      files.push_back(path.string());
+    }
+    if (files.empty()) {
+      continue;
+    }
+
+    std::map<std::string, std::string> written;
+    PackStore pack(packPath);
+    if (!PackStore::write(packPath, days) || !pack.open() || !pack.readAll(written) || written != days) {
+      std::cerr << "Error: Could not write " << packPath << "; no day files were removed" << std::endl;
+      status = 1;
+      continue;
+    }
+    for (const std::string& file : files) {
+      std::filesystem::remove(file, ec);
+      std::filesystem::remove(ScheduleCache::sidecarPath(file), ec);
+      std::filesystem::remove(UndoLog::sidecarPath(file), ec);
+    }
+
+    std::cout << "Packed " << files.size() << " days into " << packPath << " (" << days.size() << " days, "
+              << bytesBefore << " -> " << std::filesystem::file_size(packPath, ec) << " bytes)" << std::endl;
+  }
+  return status;
+}
 
-  for (size_t i = 0; i < tasks.size(); i++) {
-    std::string startTime = minutesToTimeString(tasks[i].getStartInt());
-    std::string endTime = minutesToTimeString(tasks[i].getStartInt() + tasks[i].getActLength());
-    std::string status = tasks[i].isFixed() ? "[FIXED]" : "[FLEX]";
+// Run the status-bar daemon until it is interrupted
+int runDaemon(Config& config, const std::string& configPath) {
+  auto resolver = [&](const std::string& arg) { return resolveDataFilename(arg, config); };
+  auto loader = [&](const std::string& filename) { return loadScheduleForFile(filename, config); };
 
-    std::cout << (i + 1) << ". " << tasks[i].getName()
-              << " " << status
-              << " (" << startTime << " - " << endTime
-              << ", " << tasks[i].getActLength() << " min)\n";
+  ScheduleDaemon daemon(&config, configPath, getDaemonSocketPath(configPath), resolver, loader);
+  if (!daemon.start()) {
+    return 1;
   }
+  return daemon.run();
+}
+
+// Print the current task whenever it changes until interrupted
+int runWatch(Config& config, const std::string& configPath) {
+  auto resolver = [&](const std::string& arg) { return resolveDataFilename(arg, config); };
+  auto loader = [&](const std::string& filename) { return loadScheduleForFile(filename, config); };
+
+  ScheduleWatcher watcher(&config, configPath, resolver, loader);
+  return watcher.run();
 }
 
 // Helper function to convert hours (decimal) to minutes
@@ -246,6 +1162,21 @@ std::string trim(const std::string& str) {
   return str.substr(start, end - start + 1);
 }
 
+// Byte count for the status bar: 512B, 12.3K, 1.0M
+std::string formatBytes(size_t bytes) {
+  if (bytes < 1024) {
+    return std::to_string(bytes) + "B";
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1);
+  if (bytes < 1024 * 1024) {
+    out << bytes / 1024.0 << "K";
+  } else {
+    out << bytes / (1024.0 * 1024.0) << "M";
+  }
+  return out.str();
+}
+
 // Helper function to validate time format (HH:MM)
 bool isValidTimeFormat(const std::string& time) {
   std::string trimmed = trim(time);
@@ -264,6 +1195,24 @@ bool isValidNumber(const std::string& str) {
   return true;
 }
 
+// Whether a day still holds what was loaded: the same day length and tasks,
+// fixed ones at the same times
+bool sameDay(TaskManager& loaded, TaskManager& current) {
+  std::vector<Act> before = loaded.getTasks();
+  std::vector<Act> after = current.getTasks();
+  if (loaded.getDayLength() != current.getDayLength() || before.size() != after.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < before.size(); i++) {
+    if (before[i].getName() != after[i].getName() || before[i].getLength() != after[i].getLength() ||
+        before[i].isRigid() != after[i].isRigid() || before[i].isFixed() != after[i].isFixed() ||
+        (before[i].isFixed() && before[i].getStartStr() != after[i].getStartStr())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Helper function to get current attribute value as string
 std::string getCurrentAttributeValue(const std::vector<Act>& tasks, int task_idx, int col_idx) {
   if (task_idx < 0 || task_idx >= tasks.size()) return "";
@@ -294,7 +1243,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
     return false;
   }
 
-  auto& task = manager.getTaskRef(task_idx);
+  const auto& task = manager.getTaskView(task_idx);
   std::string trimmed_value = trim(value);
 
   try {
@@ -314,7 +1263,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
           }
 
           if (oldFixed != newFixed) {
-            auto command = std::make_unique<ToggleTaskFixedCommand>(&manager, task_idx, oldFixed);
+            auto command = manager.createCommand<ToggleTaskFixedCommand>(task_idx, oldFixed);
             manager.executeCommand(std::move(command));
           }
         }
@@ -335,7 +1284,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
           }
 
           if (oldRigid != newRigid) {
-            auto command = std::make_unique<ToggleTaskRigidCommand>(&manager, task_idx, oldRigid);
+            auto command = manager.createCommand<ToggleTaskRigidCommand>(task_idx, oldRigid);
             manager.executeCommand(std::move(command));
           }
         }
@@ -350,7 +1299,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
 
           std::string oldName = task.getName();
           if (oldName != trimmed_value) {
-            auto command = std::make_unique<EditTaskNameCommand>(&manager, task_idx, oldName, trimmed_value);
+            auto command = manager.createCommand<EditTaskNameCommand>(task_idx, oldName, trimmed_value);
             manager.executeCommand(std::move(command));
           }
         }
@@ -368,7 +1317,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
           bool newFixed = !trimmed_value.empty(); // Fixed if has start time, flexible if empty
 
           if (oldStartTime != trimmed_value || oldFixed != newFixed) {
-            auto command = std::make_unique<EditTaskStartTimeCommand>(&manager, task_idx, oldStartTime, trimmed_value, oldFixed, newFixed);
+            auto command = manager.createCommand<EditTaskStartTimeCommand>(task_idx, oldStartTime, trimmed_value, oldFixed, newFixed);
             manager.executeCommand(std::move(command));
           }
         }
@@ -385,7 +1334,7 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
           int newLength = std::stoi(trimmed_value);
 
           if (oldLength != newLength) {
-            auto command = std::make_unique<EditTaskLengthCommand>(&manager, task_idx, oldLength, newLength);
+            auto command = manager.createCommand<EditTaskLengthCommand>(task_idx, oldLength, newLength);
             manager.executeCommand(std::move(command));
           }
         }
@@ -405,9 +1354,226 @@ bool applyEditWithUndo(TaskManager& manager, int task_idx, int col_idx, const st
 }
 
 int main(int argc, char* argv[]) {
+  // Strip option flags so the positional date/filename handling below is unchanged
+  bool useShm = false;
+  bool showTiming = false;
+  std::vector<char*> args;
+  for (int i = 0; i < argc; i++) {
+    if (i > 0 && std::strcmp(argv[i], "--shm") == 0) {
+      useShm = true;
+      continue;
+    }
+    if (i > 0 && std::strcmp(argv[i], "--timing") == 0) {
+      showTiming = true;
+      continue;
+    }
+    args.push_back(argv[i]);
+  }
+  argc = static_cast<int>(args.size());
+  argv = args.data();
+
+  PhaseTimer timer(showTiming);
+  timer.mark("arguments");
+
+  // FIRST..LAST in place of a date runs the command for every day in it,
+  // which neither the daemon nor the schedule cache paths answer
+  bool rangeArgument = argc == 3 && DateRange::looksLikeRange(argv[2]);
+
+  // Fastest path: read the schedule published in shared memory, if it was
+  // computed from the file this directory's today resolves to
+  if (useShm && argc == 2) {
+    std::string command = argv[1];
+    ScheduleShmReader reader;
+    Schedule schedule;
+    std::string source;
+    if ((command == "now" || command == "next" || command == "list") &&
+        reader.open(getScheduleShmName(resolveConfigFilePath())) && reader.read(schedule, &source) &&
+        source == absolutePath(locateDataFile(""))) {
+      if (command == "now") {
+        std::cout << schedule.describeCurrent(getCurrentTimeInMinutes()) << std::endl;
+      } else if (command == "next") {
+        std::cout << schedule.describeNext(getCurrentTimeInMinutes()) << std::endl;
+      } else {
+        std::cout << schedule.describeList();
+      }
+      return 0;
+    }
+  }
+
+  // Fast path: let a running daemon answer now/next/list before the full
+  // config or any data file is read. The day goes by absolute path, so a
+  // daemon started in another directory still answers for this one's data.
+  if ((argc == 2 || argc == 3) && !rangeArgument) {
+    std::string command = argv[1];
+    if (command == "now" || command == "next" || command == "list") {
+      std::string target = argc == 3 ? argv[2] : "";
+      std::string dataFilename = locateDataFile(target);
+      timer.mark("locate data file");
+
+      std::string request = command + " " + absolutePath(dataFilename);
+      std::string response;
+      if (queryDaemon(getDaemonSocketPath(resolveConfigFilePath()), request, response)) {
+        timer.mark("daemon query");
+        std::cout << response;
+        timer.report("daemon");
+        return 0;
+      }
+      timer.mark("daemon probe");
+
+      // Next best: the schedule computed when the data file was last saved
+      if (runCachedCommand(command, target, dataFilename, timer)) {
+        return 0;
+      }
+    }
+  }
+
   // Load configuration
-  Config config(getConfigFilePath());
+  std::string configPath = getConfigFilePath();
+  Config config(configPath);
   config.loadFromFile();
+  timer.mark("config");
+
+  if (argc >= 2 && std::string(argv[1]) == "daemon") {
+    return runDaemon(config, configPath);
+  }
+  if (argc == 2 && std::string(argv[1]) == "watch") {
+    return runWatch(config, configPath);
+  }
+  if (argc >= 2 && std::string(argv[1]) == "archive") {
+    if (argc != 4 || std::string(argv[2]) != "--before" || !isValidDateFormat(argv[3])) {
+      std::cerr << "Usage: " << argv[0] << " archive --before YYYY-MM-DD" << std::endl;
+      return 1;
+    }
+    return runArchive(argv[3], config);
+  }
+  if (argc >= 2 && std::string(argv[1]) == "pack") {
+    std::string month = argc == 3 ? argv[2] : "";
+    int64_t day = 0;
+    if (argc > 3 || (argc == 3 && (month.size() != 7 || !DateRange::toDayNumber(month + "-01", day)))) {
+      std::cerr << "Usage: " << argv[0] << " pack [YYYY-MM]" << std::endl;
+      return 1;
+    }
+    return runPack(month, config);
+  }
+  if (argc >= 2 && std::string(argv[1]) == "query") {
+    bool json = false, oneDay = false, valid = true;
+    std::string dayArg, expression;
+    for (int i = 2; i < argc && valid; i++) {
+      std::string arg = argv[i];
+      if (arg == "--json" && expression.empty()) {
+        json = true;
+      } else if (arg == "--tsv" && expression.empty()) {
+        json = false;
+      } else if (arg == "--day" && expression.empty()) {
+        oneDay = true;
+        valid = i + 1 < argc;
+        if (valid) {
+          dayArg = argv[++i];
+          dayArg = dayArg == "today" ? "" : dayArg;
+        }
+      } else {
+        expression += (expression.empty() ? "" : " ") + arg;
+      }
+    }
+    if (!valid || expression.empty()) {
+      std::cerr << "Usage: " << argv[0] << " query [--json|--tsv] [--day DATE|FILE|today] EXPRESSION" << std::endl;
+      return 1;
+    }
+    int status = runQuery(expression, json, oneDay, dayArg, config, timer);
+    timer.report("query");
+    return status;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "at") {
+    bool batch = argc == 3 && std::string(argv[2]) == "-";
+    std::vector<std::string> times;
+    if (batch) {
+      std::string line;
+      while (std::getline(std::cin, line)) {
+        line = line.substr(0, line.find_first_of("\t,"));
+        line.erase(line.find_last_not_of(" \r") + 1);
+        if (!line.empty()) {
+          times.push_back(line);
+        }
+      }
+    } else {
+      times.assign(argv + 2, argv + argc);
+    }
+    if (argc < 3) {
+      std::cerr << "Usage: " << argv[0] << " at YYYY-MM-DDTHH:MM..." << std::endl;
+      std::cerr << "       " << argv[0] << " at - < times.txt" << std::endl;
+      return 1;
+    }
+    timer.mark(std::to_string(times.size()) + " times read");
+    int status = runAt(times, batch, config, timer);
+    timer.report("at");
+    return status;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "free") {
+    std::string minutes = argc >= 3 ? argv[2] : "";
+    bool ranged = argc == 4;
+    bool valid = (argc == 3 || argc == 4) && isValidNumber(minutes) && minutes.size() <= 4 && std::stoi(minutes) > 0 &&
+                 std::stoi(minutes) <= 24 * 60;
+    // A single date is a one-day range
+    DateRange range;
+    if (valid && ranged) {
+      valid = DateRange::parse(argv[3], range) || DateRange::parse(std::string(argv[3]) + ".." + argv[3], range);
+    }
+    if (!valid) {
+      std::cerr << "Usage: " << argv[0] << " free MINUTES [FIRST..LAST|YYYY-MM-DD]" << std::endl;
+      return 1;
+    }
+    int status = runFree(std::stoi(minutes), ranged ? &range : nullptr, config, timer);
+    timer.report("free");
+    return status;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "search") {
+    std::string query;
+    for (int i = 2; i < argc; i++) {
+      query += (i > 2 ? " " : "") + std::string(argv[i]);
+    }
+    if (SearchIndex::tokenize(query).empty()) {
+      std::cerr << "Usage: " << argv[0] << " search TERMS..." << std::endl;
+      return 1;
+    }
+    int status = runSearch(query, config, timer);
+    timer.report("search");
+    return status;
+  }
+  if (argc >= 3 && std::string(argv[1]) == "stats" &&
+      (std::string(argv[2]) == "--by-name" || std::string(argv[2]) == "--name")) {
+    bool byName = std::string(argv[2]) == "--by-name";
+    int rangeAt = byName ? 3 : 4;
+    DateRange range;
+    if ((!byName && argc < 4) || argc > rangeAt + 1 || (argc == rangeAt + 1 && !DateRange::parse(argv[rangeAt], range))) {
+      std::cerr << "Usage: " << argv[0] << " stats --by-name [FIRST..LAST]" << std::endl;
+      std::cerr << "       " << argv[0] << " stats --name NAME [FIRST..LAST]" << std::endl;
+      return 1;
+    }
+    int64_t firstDay = INT64_MIN, lastDay = INT64_MAX;
+    if (argc == rangeAt + 1) {
+      firstDay = range.first();
+      lastDay = range.last();
+    }
+    int status = runNameStats(byName ? "" : argv[3], firstDay, lastDay, config, timer);
+    timer.report("stats by name");
+    return status;
+  }
+  if (rangeArgument) {
+    std::string command = argv[1];
+    DateRange range;
+    if (command != "now" && command != "next" && command != "list" && command != "stats") {
+      std::cerr << "Date ranges work with now, next, list and stats" << std::endl;
+      return 1;
+    }
+    if (!DateRange::parse(argv[2], range)) {
+      std::cerr << "Invalid date range: " << argv[2] << " (expected YYYY-MM-DD..YYYY-MM-DD)" << std::endl;
+      return 1;
+    }
+    int status = runRangeCommand(command, range, config);
+    timer.mark("range of " + std::to_string(range.size()) + " days");
+    timer.report("date range");
+    return status;
+  }
 
   // Initialize TaskManager with config
   TaskManager manager(&config);
@@ -434,7 +1600,7 @@ int main(int argc, char* argv[]) {
       targetDate = arg;
       dataFilename = manager.getConfiguredFilename(targetDate);
       isInteractiveWithDate = true;
-    } else if (arg != "now" && arg != "next" && arg != "list" && arg != "help" && arg != "--help" && arg != "-h") {
+    } else if (arg != "now" && arg != "next" && arg != "list" && arg != "stats" && arg != "help" && arg != "--help" && arg != "-h") {
       // It's a custom filename for interactive mode
       customFilename = arg;
       dataFilename = resolveCustomFilename(customFilename, config);
@@ -470,6 +1636,7 @@ int main(int argc, char* argv[]) {
 
   // Try to load data from file
   bool dataLoaded = manager.loadFromFile(dataFilename);
+  timer.mark("load data file");
 
   // Show which file was loaded (for CLI commands and when status messages are enabled)
   if (argc > 1 || config.getBool("status-messages", true)) {
@@ -494,28 +1661,47 @@ int main(int argc, char* argv[]) {
 
   // If no data file exists, create default tasks for demonstration
   if (!dataLoaded) {
-    manager.addTask("A", "10:00", 60, false);
-    manager.addTask("B", "13:30", 10, false);
-    manager.addTask("C", 60, false);
-    manager.addTask("D", 15, false);
+    addDefaultTasks(manager);
   }
 
   // Calculate initial task properties
   manager.calcActLen();
   manager.calcStartTimes();
+  timer.mark("compute schedule");
 
   // Handle command-line arguments
   if (argc > 1 && !isInteractiveWithDate && !isInteractiveWithCustomFile) {
     std::string command = argv[1];
 
+    // Refresh the sidecar so the next invocation can take the cached path
+    // (an archived day has no file for it to stand next to)
+    if (dataLoaded && !manager.isLoadedFromArchive() && (command == "now" || command == "next" || command == "list" || command == "stats")) {
+      ScheduleCache::store(dataFilename, manager.getLoadedContentHash(), manager.getDayLength(),
+                           Schedule(manager.getTasks()));
+      timer.mark("store schedule cache");
+    }
+
     if (command == "now") {
       std::cout << getCurrentTask(manager) << std::endl;
+      timer.mark("output");
+      timer.report("data file");
       return 0;
     } else if (command == "next") {
       std::cout << getNextTask(manager) << std::endl;
+      timer.mark("output");
+      timer.report("data file");
       return 0;
     } else if (command == "list") {
       listAllTasks(manager);
+      timer.mark("output");
+      timer.report("data file");
+      return 0;
+    } else if (command == "stats") {
+      DayStats stats;
+      stats.add(Schedule(manager.getTasks()));
+      std::cout << stats.describe() << std::endl;
+      timer.mark("output");
+      timer.report("data file");
       return 0;
     } else if (command == "help" || command == "--help" || command == "-h") {
       printUsage(argv[0]);
@@ -548,6 +1734,39 @@ int main(int argc, char* argv[]) {
   std::vector<std::string> available_files;
   int selected_file_index = 0;
 
+  // History browser state
+  bool history_browser_mode = false;
+  std::vector<UndoManager::HistoryEntry> history_entries;
+  int selected_history_index = 0;
+
+  // Search state: `/` types a query, Enter lists the matching tasks of past days
+  const size_t SEARCH_RESULTS = 200;
+  bool search_input_mode = false;
+  bool search_results_mode = false;
+  std::string search_query = "";
+  std::vector<SearchResult> search_results;
+  size_t search_total = 0;
+  size_t search_days = 0;
+  int selected_result_index = 0;
+
+  // Free slot state: `F` asks for a length, Enter places a task in the day's earliest gap that fits
+  bool free_input_mode = false;
+  std::string free_minutes = "";
+
+  // Day flipping state: [ and ] move to the previous/next day, whose neighbours are loaded ahead
+  DayCache days(config, static_cast<size_t>(std::max(config.getInt("day-cache-size", 7), 1)));
+  auto prefetchAround = [&](const std::string& filename) {
+    std::string date;
+    int64_t day = 0;
+    if (manager.getFileDate(filename, date) && DateRange::toDayNumber(date, day)) {
+      // The open day too, as it was loaded, to tell whether it changed when it is left
+      days.prefetch(filename);
+      days.prefetch(manager.getConfiguredFilename(DateRange::fromDayNumber(day + 1)));
+      days.prefetch(manager.getConfiguredFilename(DateRange::fromDayNumber(day - 1)));
+    }
+  };
+  prefetchAround(dataFilename);
+
   // Deletion state for 'dd' command
   bool first_d_pressed = false;
 
@@ -708,12 +1927,119 @@ int main(int argc, char* argv[]) {
     }) | border;
   });
 
+  // Create history browser renderer: the undo tree, alternate branches indented
+  auto history_browser_renderer = Renderer([&] {
+    std::vector<Element> history_elements;
+    for (size_t i = 0; i < history_entries.size(); ++i) {
+      const auto& entry = history_entries[i];
+      std::string line = std::string(entry.branch * 2, ' ') + (entry.isCurrent ? "> " : "  ") +
+                         std::to_string(entry.depth) + ": " +
+                         (entry.description.empty() ? "Oldest kept state" : entry.description);
+
+      Element history_element = text(line);
+      if (!entry.isUndoable) {
+        history_element = history_element | dim;  // Redo steps and other branches
+      }
+      if (static_cast<int>(i) == selected_history_index) {
+        history_element = history_element | bgcolor(Color::Cyan) | color(Color::Black) | bold | focus;
+      }
+      history_elements.push_back(history_element);
+    }
+
+    return vbox({
+      text("Undo History - Select a state to jump to") | bold | hcenter,
+      separator(),
+      vbox(history_elements) | yframe | flex,
+      separator(),
+      text("j/k: Navigate | Enter: Jump | Esc: Cancel") | dim | hcenter,
+    }) | border;
+  });
+
+  // Create search renderer: the query being typed, then the matches best first
+  auto search_renderer = Renderer([&] {
+    if (search_input_mode) {
+      return vbox({
+        text("Search - Task names of every day on record") | bold | hcenter,
+        separator(),
+        hbox({text("/ "), text(search_query), text(" ") | inverted}),
+        separator(),
+        text("Type words to find | Enter: Search | Esc: Cancel") | dim | hcenter,
+      }) | border;
+    }
+
+    std::vector<Element> result_elements;
+    for (size_t i = 0; i < search_results.size(); ++i) {
+      const auto& result = search_results[i];
+      Element result_element = hbox({
+        text(result.date + "  " + clockTime(result.task.start) + "  "),
+        text(result.task.name) | flex,
+        text(std::to_string(result.task.actLength) + "m"),
+      });
+      if (static_cast<int>(i) == selected_result_index) {
+        result_element = result_element | bgcolor(Color::Cyan) | color(Color::Black) | bold | focus;
+      }
+      result_elements.push_back(result_element);
+    }
+    if (result_elements.empty()) {
+      result_elements.push_back(text("No tasks match \"" + search_query + "\"") | hcenter);
+    }
+
+    std::string summary = std::to_string(search_total) + " matches on " + std::to_string(search_days) + " days";
+    if (search_total > search_results.size()) {
+      summary += " (best " + std::to_string(search_results.size()) + " shown)";
+    }
+    return vbox({
+      text("Search: " + search_query + " - " + summary) | bold | hcenter,
+      separator(),
+      vbox(result_elements) | yframe | flex,
+      separator(),
+      text("j/k: Navigate | Enter: Open day | /: New search | Esc: Cancel") | dim | hcenter,
+    }) | border;
+  });
+
+  // Run hook-task-start/hook-task-end at the boundaries of the open file,
+  // unless a daemon is running: it runs them for every day it has loaded,
+  // and hooks run by both would fire twice. The daemon is asked on the
+  // notifier's thread when a boundary comes due, never on an edit.
+  BoundaryNotifier notifier(config);
+  std::string notifiedFile;
+  std::string daemonSocket = getDaemonSocketPath(configPath);
+  notifier.setSkipCheck([daemonSocket] { return isDaemonRunning(daemonSocket); });
+  auto updateHooks = [&](const Schedule& schedule) {
+    if (!notifiedFile.empty() && notifiedFile != dataFilename) {
+      notifier.removeSchedule(notifiedFile);
+    }
+    notifiedFile = dataFilename;
+    notifier.setSchedule(dataFilename, schedule);
+  };
+  if (notifier.hasHooks()) {
+    manager.setScheduleListener([&](const std::vector<Act>& tasks) { updateHooks(Schedule(tasks)); });
+    updateHooks(Schedule(manager.getTasks()));
+    notifier.start();
+  }
+
+  // Mirror the schedule into shared memory for status-bar widgets
+  SchedulePublisher publisher;
+  publisher.open(getScheduleShmName(configPath));
+
   // Create combined renderer
   auto table_renderer = Renderer([&] {
+    // Every change to the schedule is followed by a render, so publish here;
+    // the segment only ever shows today, like the daemon publishes it
+    if (dataFilename == manager.getConfiguredFilename()) {
+      publisher.publish(Schedule(manager.getTasks()), dataFilename);
+    }
+
     // If in file browser mode, show file browser instead
     if (file_browser_mode) {
       return file_browser_renderer->Render();
     }
+    if (history_browser_mode) {
+      return history_browser_renderer->Render();
+    }
+    if (search_input_mode || search_results_mode) {
+      return search_renderer->Render();
+    }
 
     auto tasks = manager.getTasks();
 
@@ -734,12 +2060,17 @@ int main(int argc, char* argv[]) {
         current_cell += " (rigid: fixed length)";
       }
     }
+    if (free_input_mode) {
+      current_cell = "Free slot - Length in minutes: " + free_minutes + "_";
+    }
 
     // Create undo/redo status info
     std::string undo_info = "";
     if (manager.canUndo() || manager.canRedo()) {
       undo_info = " | Undo: " + std::to_string(manager.getUndoStackSize()) +
-                  " | Redo: " + std::to_string(manager.getRedoStackSize());
+                  " | Redo: " + std::to_string(manager.getRedoStackSize()) +
+                  " | History: " + formatBytes(manager.getUndoMemoryUsage()) +
+                  "/" + formatBytes(manager.getUndoMemoryLimit());
     }
 
     return vbox({
@@ -755,7 +2086,7 @@ int main(int argc, char* argv[]) {
         text(current_cell) | dim,
         text(undo_info) | color(Color::Yellow) | dim,
       }),
-      text("hjkl: Navigate | Enter: Edit/Toggle | Tab: Next field | v: Visual | f: File Browser | Esc: Exit | i/o: Insert | dd/D: Delete | u: Undo | r/Ctrl+R: Redo | Alt+B: Start Timer | q: Quit") | dim | hcenter,
+      text("hjkl: Navigate | Enter: Edit/Toggle | Tab: Next field | v: Visual | f: File Browser | Esc: Exit | i/o: Insert | dd/D: Delete | u: Undo | r/Ctrl+R: Redo | H: History | /: Search | F: Free slot | [/]: Prev/Next day | Alt+B: Start Timer | q: Quit") | dim | hcenter,
     }) | border;
   });
 
@@ -766,8 +2097,11 @@ int main(int argc, char* argv[]) {
 
   // Add vim-like navigation and command handling
   main_renderer |= CatchEvent([&](Event event) {
-    // Handle quit
-    if (event == Event::Character('q')) {
+    // Commands applied by one key press share a single recalculation
+    TaskManager::RecalcScope recalc(manager);
+
+    // Handle quit ('q' is part of a search query being typed)
+    if (event == Event::Character('q') && !search_input_mode && !free_input_mode) {
       if (edit_mode) {
         // If in edit mode, close it instead of quitting
         edit_mode = false;
@@ -802,10 +2136,278 @@ int main(int argc, char* argv[]) {
         status_message = "File browser cancelled";
         show_success = false;
         return true;
+      } else if (history_browser_mode) {
+        history_browser_mode = false;
+        history_entries.clear();
+        selected_history_index = 0;
+        status_message = "History browser cancelled";
+        show_success = false;
+        return true;
+      } else if (search_input_mode || search_results_mode) {
+        search_input_mode = false;
+        search_results_mode = false;
+        search_results.clear();
+        selected_result_index = 0;
+        status_message = "Search cancelled";
+        show_success = false;
+        return true;
+      } else if (free_input_mode) {
+        free_input_mode = false;
+        free_minutes = "";
+        status_message = "Free slot cancelled";
+        show_success = false;
+        return true;
       }
       return false;
     }
 
+    // History browser takes every key until a state is picked or it is cancelled
+    if (history_browser_mode) {
+      if (event == Event::Character('j') || event == Event::ArrowDown) {
+        if (selected_history_index < static_cast<int>(history_entries.size()) - 1) {
+          selected_history_index++;
+        }
+      } else if (event == Event::Character('k') || event == Event::ArrowUp) {
+        if (selected_history_index > 0) {
+          selected_history_index--;
+        }
+      } else if (event == Event::Return) {
+        const auto& entry = history_entries[selected_history_index];
+        if (entry.isCurrent) {
+          status_message = "Already at this state";
+          show_success = false;
+        } else if (manager.jumpToHistory(entry.id)) {
+          status_message = "Jumped to: " + (entry.description.empty() ? "oldest kept state" : entry.description);
+          show_success = true;
+        } else {
+          status_message = "That state is no longer in the history";
+          show_success = false;
+        }
+        if (selected_task >= manager.taskSize()) {
+          selected_task = manager.taskSize() - 1;
+        }
+
+        history_browser_mode = false;
+        history_entries.clear();
+        selected_history_index = 0;
+      }
+      return true;
+    }
+
+    // Search query: typed like an edit, run on Enter
+    if (search_input_mode) {
+      if (event == Event::Return) {
+        if (SearchIndex::tokenize(search_query).empty()) {
+          status_message = "Type a word to search for";
+          show_success = false;
+          return true;
+        }
+        search_results = searchHistory(search_query, SEARCH_RESULTS, config, search_total, search_days);
+        search_input_mode = false;
+        search_results_mode = true;
+        selected_result_index = 0;
+        status_message = std::to_string(search_total) + " matches - Use j/k to navigate, Enter to open the day";
+        show_success = search_total > 0;
+      } else if (event == Event::Backspace) {
+        if (!search_query.empty()) {
+          search_query.pop_back();
+        }
+      } else if (event.is_character()) {
+        search_query += event.character();
+      }
+      return true;
+    }
+
+    // Search results take every key until one is opened or the search is cancelled
+    if (search_results_mode) {
+      if (event == Event::Character('j') || event == Event::ArrowDown) {
+        if (selected_result_index < static_cast<int>(search_results.size()) - 1) {
+          selected_result_index++;
+        }
+      } else if (event == Event::Character('k') || event == Event::ArrowUp) {
+        if (selected_result_index > 0) {
+          selected_result_index--;
+        }
+      } else if (event == Event::Character('/')) {
+        search_results_mode = false;
+        search_input_mode = true;
+        status_message = "Search - Type words to find, Enter to search";
+        show_success = false;
+      } else if (event == Event::Return && !search_results.empty()) {
+        const SearchResult& result = search_results[selected_result_index];
+        std::string resultFile = manager.getConfiguredFilename(result.date);
+        bool loaded = resultFile == dataFilename;
+        if (!loaded) {
+          // Save current data if auto-save is enabled, keeping its undo history with it
+          if (config.getBool("auto-save", true) && manager.saveToFile(dataFilename)) {
+            manager.saveHistory(dataFilename);
+          }
+          loaded = manager.loadFromFile(resultFile);
+          if (loaded) {
+            dataFilename = resultFile;
+            manager.calcActLen();
+            manager.calcStartTimes();
+            config.setLastOpenedFile(dataFilename);
+            config.saveSessionState();
+            prefetchAround(dataFilename);
+          }
+        }
+
+        if (loaded) {
+          selected_task = std::min(static_cast<int>(result.position), static_cast<int>(manager.taskSize()) - 1);
+          selected_column = 2;
+          visual_mode = false;
+          visual_selected_task = -1;
+          status_message = "Opened " + result.date + ": " + result.task.name;
+          show_success = true;
+          search_results_mode = false;
+          search_results.clear();
+          selected_result_index = 0;
+        } else {
+          status_message = "Failed to load file: " + resultFile;
+          show_success = false;
+        }
+      }
+      return true;
+    }
+
+    // Free slot length: digits, placed on Enter
+    if (free_input_mode) {
+      if (event == Event::Return) {
+        int minutes = free_minutes.empty() || free_minutes.size() > 4 ? 0 : std::stoi(free_minutes);
+        if (minutes <= 0 || minutes > 24 * 60) {
+          status_message = "Type a length in minutes";
+          show_success = false;
+          return true;
+        }
+        free_input_mode = false;
+        free_minutes = "";
+
+        // On today's file only the rest of the day is any use
+        int from = dataFilename == manager.getConfiguredFilename() ? getCurrentTimeInMinutes() : 0;
+        FreeSlots::Span gap{};
+        if (!freeSlotsOf(manager).earliest(minutes, from, gap)) {
+          status_message = "No " + std::to_string(minutes) + "-minute gap left in this day";
+          show_success = false;
+          return true;
+        }
+
+        // A rigid fixed-time task, kept in time order: after every task that starts before the gap
+        auto tasks = manager.getTasks();
+        int insert_position = 0;
+        while (insert_position < static_cast<int>(tasks.size()) && tasks[insert_position].getStartInt() < gap.start) {
+          insert_position++;
+        }
+        auto command = manager.createCommand<InsertTaskCommand>(insert_position, "", minutesToTimeString(gap.start), minutes, true);
+        manager.executeCommand(std::move(command));
+
+        // Recalculate task properties
+        bool hasWarnings = false;
+        auto warnings = manager.calcActLen(hasWarnings);
+        manager.calcStartTimes();
+
+        // Position cursor on the new task's Name field and enter edit mode
+        selected_task = insert_position;
+        selected_column = 2; // Name column
+        edit_mode = true;
+        edit_buffer = "";
+
+        if (hasWarnings && !warnings.empty()) {
+          status_message = "Warning: " + warnings[0];
+          show_success = false;
+        } else {
+          status_message = "Task placed at " + minutesToTimeString(gap.start) + " - Editing Name - Press Enter to apply, Esc to cancel";
+          show_success = false;
+        }
+      } else if (event == Event::Backspace) {
+        if (!free_minutes.empty()) {
+          free_minutes.pop_back();
+        }
+      } else if (event.is_character() && std::isdigit(static_cast<unsigned char>(event.character()[0]))) {
+        free_minutes += event.character();
+      }
+      return true;
+    }
+
+    // Previous/next day ([ and ] keys) - not in edit, visual or file browser mode
+    if ((event == Event::Character('[') || event == Event::Character(']')) && !edit_mode && !visual_mode &&
+        !file_browser_mode) {
+      std::string date;
+      int64_t day = 0;
+      if (!manager.getFileDate(dataFilename, date) || !DateRange::toDayNumber(date, day)) {
+        status_message = "[ and ] need a day file (tasks_YYYY-MM-DD)";
+        show_success = false;
+        return true;
+      }
+      std::string nextDate = DateRange::fromDayNumber(day + (event == Event::Character(']') ? 1 : -1));
+      std::string nextFile = manager.getConfiguredFilename(nextDate);
+
+      // Save the day left only if it changed, so flipping through days writes nothing
+      std::shared_ptr<TaskManager> left = days.get(dataFilename);
+      bool changed = left ? !sameDay(*left, manager) : manager.taskSize() > 0;
+      if (changed && config.getBool("auto-save", true) && manager.saveToFile(dataFilename)) {
+        manager.saveHistory(dataFilename);
+      }
+
+      // Usually loaded already; a day on record nowhere starts empty
+      std::shared_ptr<TaskManager> next = days.get(nextFile);
+      if (next) {
+        manager.adoptDay(*next, nextFile);
+      } else {
+        manager.adoptDay(TaskManager(&config), nextFile);
+      }
+      dataFilename = nextFile;
+      manager.calcActLen();
+      manager.calcStartTimes();
+      config.setLastOpenedFile(dataFilename);
+      config.saveSessionState();
+      prefetchAround(dataFilename);
+
+      selected_task = std::max(0, std::min(selected_task, manager.taskSize() - 1));
+      status_message = nextDate + (next ? "" : " - No tasks yet");
+      show_success = next != nullptr;
+      return true;
+    }
+
+    // Free slot (F key) - not in edit, visual or file browser mode
+    if (event == Event::Character('F') && !edit_mode && !visual_mode && !file_browser_mode) {
+      free_input_mode = true;
+      free_minutes = "";
+      status_message = "Free slot - Type a length in minutes, Enter to place a task";
+      show_success = false;
+      return true;
+    }
+
+    // Search (/ key) - not in edit, visual or file browser mode
+    if (event == Event::Character('/') && !edit_mode && !visual_mode && !file_browser_mode) {
+      search_input_mode = true;
+      search_query = "";
+      status_message = "Search - Type words to find, Enter to search";
+      show_success = false;
+      return true;
+    }
+
+    // Handle history browser (H key) - not in edit, visual or file browser mode
+    if (event == Event::Character('H') && !edit_mode && !visual_mode && !file_browser_mode) {
+      history_entries = manager.getHistoryTree();
+      if (history_entries.size() <= 1) {
+        history_entries.clear();
+        status_message = "No undo history";
+        show_success = false;
+      } else {
+        history_browser_mode = true;
+        selected_history_index = 0;
+        for (size_t i = 0; i < history_entries.size(); ++i) {
+          if (history_entries[i].isCurrent) {
+            selected_history_index = static_cast<int>(i);
+          }
+        }
+        status_message = "History browser - Use j/k to navigate, Enter to jump";
+        show_success = false;
+      }
+      return true;
+    }
+
     // Handle undo (u key) - not in edit mode or file browser mode
     if (event == Event::Character('u') && !edit_mode && !file_browser_mode) {
       if (manager.canUndo()) {
@@ -838,7 +2440,7 @@ int main(int argc, char* argv[]) {
     if (event == Event::AltB && !edit_mode && !file_browser_mode) {
       if (selected_task >= 0 && selected_task < manager.taskSize()) {
         // Create and execute the start timer command
-        auto command = std::make_unique<StartTaskTimerCommand>(&manager, selected_task);
+        auto command = manager.createCommand<StartTaskTimerCommand>(selected_task);
         std::string timerDesc = command->getDescription();
         manager.executeCommand(std::move(command));
 
@@ -949,15 +2551,16 @@ int main(int argc, char* argv[]) {
           // Move selected task down
           if (visual_selected_task >= 0 && visual_selected_task < manager.taskSize() - 1) {
             // Store if task was fixed before movement
-            auto& task = manager.getTaskRef(visual_selected_task);
-            bool wasFixed = task.isFixed();
+            bool wasFixed = manager.getTaskView(visual_selected_task).isFixed();
+            uint64_t movedId = manager.getTaskId(visual_selected_task);
 
             // Use undoable command for movement
-            auto command = std::make_unique<MoveTaskDownCommand>(&manager, visual_selected_task, wasFixed);
+            auto command = manager.createCommand<MoveTaskDownCommand>(visual_selected_task, wasFixed);
             manager.executeCommand(std::move(command));
 
-            visual_selected_task++;
-            selected_task = visual_selected_task; // Keep cursor on moved task
+            // Keep cursor on moved task, wherever it ended up
+            visual_selected_task = manager.getTaskIndex(movedId);
+            selected_task = visual_selected_task;
 
             status_message = "Task moved down (undo with 'u')";
             show_success = true;
@@ -972,15 +2575,16 @@ int main(int argc, char* argv[]) {
           // Move selected task up
           if (visual_selected_task > 0) {
             // Store if task was fixed before movement
-            auto& task = manager.getTaskRef(visual_selected_task);
-            bool wasFixed = task.isFixed();
+            bool wasFixed = manager.getTaskView(visual_selected_task).isFixed();
+            uint64_t movedId = manager.getTaskId(visual_selected_task);
 
             // Use undoable command for movement
-            auto command = std::make_unique<MoveTaskUpCommand>(&manager, visual_selected_task, wasFixed);
+            auto command = manager.createCommand<MoveTaskUpCommand>(visual_selected_task, wasFixed);
             manager.executeCommand(std::move(command));
 
-            visual_selected_task--;
-            selected_task = visual_selected_task; // Keep cursor on moved task
+            // Keep cursor on moved task, wherever it ended up
+            visual_selected_task = manager.getTaskIndex(movedId);
+            selected_task = visual_selected_task;
 
             status_message = "Task moved up (undo with 'u')";
             show_success = true;
@@ -1020,19 +2624,25 @@ int main(int argc, char* argv[]) {
           if (selected_file_index < available_files.size()) {
             std::string selectedFile = available_files[selected_file_index];
 
-            // Save current data if auto-save is enabled
-            if (config.getBool("auto-save", true)) {
-              manager.saveToFile(dataFilename);
+            // Save current data if auto-save is enabled, keeping its undo history with it
+            if (config.getBool("auto-save", true) && manager.saveToFile(dataFilename)) {
+              manager.saveHistory(dataFilename);
             }
 
             // Load the selected file
             if (manager.loadFromFile(selectedFile)) {
               dataFilename = selectedFile;
+              manager.calcActLen();
+              manager.calcStartTimes();
               // Update session state
               config.setLastOpenedFile(dataFilename);
               config.saveSessionState();
+              prefetchAround(dataFilename);
 
               status_message = "Loaded file: " + selectedFile;
+              if (manager.canUndo()) {
+                status_message += " (" + std::to_string(manager.getUndoStackSize()) + " undo steps)";
+              }
               show_success = true;
 
               // Reset navigation state
@@ -1105,17 +2715,17 @@ int main(int argc, char* argv[]) {
         } else if (isColumnEditable(selected_column) && selected_task >= 0 && selected_task < manager.taskSize()) {
           // For boolean columns (Fixed and Rigid), toggle directly using undoable commands
           if (selected_column == 0 || selected_column == 1) {
-            auto& task = manager.getTaskRef(selected_task);
+            // Commands snapshot the task list, so look the task up again afterwards
             if (selected_column == 0) { // Fixed (fixed-time)
-              bool oldFixed = task.isFixed();
-              auto command = std::make_unique<ToggleTaskFixedCommand>(&manager, selected_task, oldFixed);
+              bool oldFixed = manager.getTaskView(selected_task).isFixed();
+              auto command = manager.createCommand<ToggleTaskFixedCommand>(selected_task, oldFixed);
               manager.executeCommand(std::move(command));
-              status_message = "Fixed-time toggled to " + std::string(task.isFixed() ? "Yes" : "No");
+              status_message = "Fixed-time toggled to " + std::string(manager.getTaskView(selected_task).isFixed() ? "Yes" : "No");
             } else if (selected_column == 1) { // Rigid
-              bool oldRigid = task.isRigid();
-              auto command = std::make_unique<ToggleTaskRigidCommand>(&manager, selected_task, oldRigid);
+              bool oldRigid = manager.getTaskView(selected_task).isRigid();
+              auto command = manager.createCommand<ToggleTaskRigidCommand>(selected_task, oldRigid);
               manager.executeCommand(std::move(command));
-              status_message = "Rigid toggled to " + std::string(task.isRigid() ? "Yes" : "No");
+              status_message = "Rigid toggled to " + std::string(manager.getTaskView(selected_task).isRigid() ? "Yes" : "No");
             }
             show_success = true;
           } else {
@@ -1136,7 +2746,9 @@ int main(int argc, char* argv[]) {
       if (event == Event::Character('i') || event == Event::Character('O') && !visual_mode) {
         // Insert before current task
         int insert_position = selected_task;
-        manager.insertTask(insert_position, "", 0, false); // Empty task with default values
+        // Empty task with default values, undoable like every other change to the list
+        auto command = manager.createCommand<InsertTaskCommand>(insert_position, "", 0, false);
+        manager.executeCommand(std::move(command));
 
         // Recalculate task properties
         bool hasWarnings = false;
@@ -1163,7 +2775,9 @@ int main(int argc, char* argv[]) {
       if (event == Event::Character('o') && !visual_mode) {
         // Insert after current task
         int insert_position = selected_task + 1;
-        manager.insertTask(insert_position, "", 0, false); // Empty task with default values
+        // Empty task with default values, undoable like every other change to the list
+        auto command = manager.createCommand<InsertTaskCommand>(insert_position, "", 0, false);
+        manager.executeCommand(std::move(command));
 
         // Recalculate task properties
         bool hasWarnings = false;
@@ -1228,7 +2842,7 @@ int main(int argc, char* argv[]) {
           // Second 'd' pressed - execute deletion
           if (manager.taskSize() > 0 && selected_task >= 0 && selected_task < manager.taskSize()) {
             // Use undo-aware deletion
-            auto deleteCommand = std::make_unique<DeleteTaskCommand>(&manager, selected_task);
+            auto deleteCommand = manager.createCommand<DeleteTaskCommand>(selected_task);
             manager.executeCommand(std::move(deleteCommand));
 
             // Adjust cursor position
@@ -1259,7 +2873,7 @@ int main(int argc, char* argv[]) {
         // Capital D - immediate deletion
         if (manager.taskSize() > 0 && selected_task >= 0 && selected_task < manager.taskSize()) {
           // Use undo-aware deletion
-          auto deleteCommand = std::make_unique<DeleteTaskCommand>(&manager, selected_task);
+          auto deleteCommand = manager.createCommand<DeleteTaskCommand>(selected_task);
           manager.executeCommand(std::move(deleteCommand));
 
           // Adjust cursor position
@@ -1297,8 +2911,13 @@ int main(int argc, char* argv[]) {
   if (config.getBool("auto-save", true)) {
     if (!manager.saveToFile(dataFilename)) {
       std::cerr << "Warning: Failed to save data to " << dataFilename << std::endl;
-    } else if (config.getBool("status-messages", true)) {
-      std::cout << "Data saved to " << dataFilename << std::endl;
+    } else {
+      if (!manager.saveHistory(dataFilename)) {
+        std::cerr << "Warning: Failed to save undo history for " << dataFilename << std::endl;
+      }
+      if (config.getBool("status-messages", true)) {
+        std::cout << "Data saved to " << dataFilename << std::endl;
+      }
     }
 
     // Remember this file as the last opened for next session
@@ -0,0 +1,91 @@
+// The same routine saved on two days should be stored once. Each day numbers
+// its tasks itself, so the two files differ in their task ids as well as
+// their dates; splitting them must still give equal task and ordering keys,
+// and joining a day back must load the same tasks.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "ContentStore.h"
+#include "TaskManager.h"
+
+namespace {
+
+void addRoutine(TaskManager& manager) {
+  manager.addTask("Standup", "09:00", 15, true);
+  manager.addTask("Deep work", 180, false);
+  manager.addTask("Email", 30, false);
+}
+
+std::string saveDay(TaskManager& manager, const std::string& filename) {
+  manager.saveToFile(filename);
+  std::ifstream file(filename, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+int fail(const char* message) {
+  std::printf("FAIL: %s\n", message);
+  return 1;
+}
+
+}  // namespace
+
+int main() {
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "plan_content_store_test";
+  std::filesystem::create_directories(dir);
+
+  // The second day had a task deleted first, so its routine gets other ids
+  TaskManager first(420);
+  addRoutine(first);
+  TaskManager second(420);
+  second.addTask("Dentist", "14:00", 60, true);
+  second.deleteTask(0);
+  addRoutine(second);
+  if (first.getTaskId(0) == second.getTaskId(0)) {
+    return fail("the two days should number their tasks differently");
+  }
+
+  std::string firstContent = saveDay(first, (dir / "tasks_2024-01-15.json").string());
+  std::string secondContent = saveDay(second, (dir / "tasks_2024-01-16.json").string());
+  std::filesystem::remove_all(dir);
+  if (firstContent == secondContent || firstContent.find("\"id\"") == std::string::npos) {
+    return fail("the saved days should carry their own task ids");
+  }
+
+  DayObjects firstDay, secondDay;
+  if (!ContentStore::splitDay(firstContent, firstDay) || !ContentStore::splitDay(secondContent, secondDay)) {
+    return fail("could not split a saved day");
+  }
+  if (firstDay.taskKeys != secondDay.taskKeys || firstDay.orderingKey != secondDay.orderingKey) {
+    return fail("the same routine should get the same keys on both days");
+  }
+
+  ContentStore store;
+  for (const DayObjects* day : {&firstDay, &secondDay}) {
+    store.put(day->orderingKey, day->ordering);
+    for (size_t i = 0; i < day->tasks.size(); i++) {
+      store.put(day->taskKeys[i], day->tasks[i]);
+    }
+  }
+  if (store.objectCount() != firstDay.tasks.size() + 1) {
+    return fail("the routine should be stored once");
+  }
+
+  std::string joined;
+  TaskManager loaded(420);
+  if (!ContentStore::joinDay(secondDay, joined) || !loaded.loadFromContent(joined, "tasks_2024-01-16.json") ||
+      loaded.taskSize() != second.taskSize()) {
+    return fail("a joined day should load with the same tasks");
+  }
+  for (int i = 0; i < loaded.taskSize(); i++) {
+    if (loaded.getTaskView(i).getName() != second.getTaskView(i).getName() ||
+        loaded.getTaskView(i).getLength() != second.getTaskView(i).getLength() || loaded.getTaskId(i) == 0) {
+      return fail("a joined day should load with the same tasks");
+    }
+  }
+
+  std::printf("%zu objects for two days of %zu tasks\n", store.objectCount(), firstDay.tasks.size());
+  return 0;
+}
@@ -0,0 +1,135 @@
+// A TaskManager keeps one undo history per data file and sets it aside when
+// another file is loaded. Loading a file that turns out to be damaged must
+// leave the open file's tasks and history as they were, and going back to a
+// file that was left without saving must bring its history back.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "TaskManager.h"
+#include "UndoManager.h"
+
+namespace {
+
+int fail(const char* message) {
+  std::printf("FAIL: %s\n", message);
+  return 1;
+}
+
+// The open file's history, saved in its sidecar and not read back yet, must
+// survive a failed load of another file
+int failedLoadKeepsHistory(const std::filesystem::path& dir) {
+  std::string day = (dir / "tasks_2024-01-15.json").string();
+  std::string other = (dir / "tasks_2024-01-16.json").string();
+
+  TaskManager writer(420);
+  writer.addTask("Standup", "09:00", 15, true);
+  writer.addTask("Deep work", 180, false);
+  writer.saveToFile(day);
+  writer.loadFromFile(day);
+  writer.executeCommand(writer.createCommand<EditTaskLengthCommand>(1, 180, 120));
+  writer.saveToFile(day);
+  writer.saveHistory(day);
+
+  TaskManager manager(420);
+  if (!manager.loadFromFile(day) || !manager.canUndo()) {
+    return fail("the saved history should come back with the file");
+  }
+
+  const char* damaged[] = {
+    "{\"dayLength\": 420}",
+    "{\"dayLength\": 420, \"tasks\": [{\"name\": \"Email\", \"length\": \"long\", \"rigid\": false, \"fixed\": false}]}",
+    "{\"dayLength\": 420, \"tasks\": [",
+  };
+  for (const char* content : damaged) {
+    if (manager.loadFromContent(content, other)) {
+      return fail("a damaged file should not load");
+    }
+  }
+
+  if (manager.taskSize() != 2 || manager.getTaskView(1).getLength() != 120) {
+    return fail("a failed load should leave the open file's tasks alone");
+  }
+  if (!manager.canUndo()) {
+    return fail("a failed load should leave the open file's history alone");
+  }
+  manager.undo();
+  if (manager.getTaskView(1).getLength() != 180) {
+    return fail("undo should still work after a failed load");
+  }
+  return 0;
+}
+
+void writeFile(const std::string& filename, const std::string& content) {
+  std::ofstream file(filename, std::ios::trunc);
+  file << content;
+}
+
+// Flipping away from a day and back (the TUI's [ and ]) saves only if the
+// day changed. The files are written the way an older version or the archive
+// left them: another date, another layout, no task ids.
+int flipBackKeepsHistory(const std::filesystem::path& dir) {
+  std::string day = (dir / "tasks_2024-02-01.json").string();
+  std::string other = (dir / "tasks_2024-02-02.json").string();
+  writeFile(day, "{\"date\":\"2023-12-31\",\"dayLength\":420,\"tasks\":["
+                 "{\"name\":\"Standup\",\"startTime\":\"09:00\",\"length\":15,\"rigid\":true,\"fixed\":true},"
+                 "{\"name\":\"Deep work\",\"length\":180,\"rigid\":false,\"fixed\":false}]}");
+  writeFile(other, "{\"dayLength\":420,\"tasks\":[{\"name\":\"Email\",\"length\":30,\"rigid\":false,\"fixed\":false}]}");
+
+  // Edit then undo: nothing to save, the history has a redo entry
+  TaskManager manager(420);
+  manager.loadFromFile(day);
+  manager.executeCommand(manager.createCommand<EditTaskLengthCommand>(1, 180, 120));
+  manager.undo();
+  manager.loadFromFile(other);
+  manager.loadFromFile(day);
+  if (!manager.canRedo()) {
+    return fail("a day left unchanged and unsaved should get its history back");
+  }
+  manager.redo();
+  if (manager.getTaskView(1).getLength() != 120) {
+    return fail("redo should find the task again after flipping back");
+  }
+
+  // Saved before leaving: the history is keyed to what was written
+  manager.saveToFile(day);
+  manager.loadFromFile(other);
+  manager.loadFromFile(day);
+  if (!manager.canUndo()) {
+    return fail("a day saved before leaving should get its history back");
+  }
+  manager.undo();
+  if (manager.getTaskView(1).getLength() != 180) {
+    return fail("undo should work after flipping back to a saved day");
+  }
+
+  // Left with an unsaved edit: the file no longer holds where the history ends
+  manager.loadFromFile(day);
+  manager.executeCommand(manager.createCommand<EditTaskLengthCommand>(1, 120, 60));
+  manager.loadFromFile(other);
+  manager.loadFromFile(day);
+  if (manager.canUndo() || manager.getTaskView(1).getLength() != 120) {
+    return fail("a day left with unsaved edits should come back as saved, without its history");
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main() {
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "plan_history_switch_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+
+  int status = failedLoadKeepsHistory(dir);
+  if (status == 0) {
+    status = flipBackKeepsHistory(dir);
+  }
+
+  std::filesystem::remove_all(dir);
+  if (status == 0) {
+    std::printf("history kept across failed loads and day flips\n");
+  }
+  return status;
+}
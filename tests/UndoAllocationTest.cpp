@@ -0,0 +1,103 @@
+// Edits recorded in the undo history should not go back to the general heap
+// once the command pool is warm. Counts every operator new while editing a
+// day and fails if a command costs more than a fixed number of allocations.
+// Commands, their strings and the id index come from the pool; what is left
+// is the history node and the list of children it is added to.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "TaskManager.h"
+#include "UndoManager.h"
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+
+constexpr int TASKS = 40;
+constexpr int WARMUP_ROUNDS = 2 * static_cast<int>(UndoManager::DEFAULT_MAX_ENTRIES);
+constexpr int MEASURED_ROUNDS = 1000;
+constexpr int COMMANDS_PER_ROUND = 5;
+constexpr size_t MAX_ALLOCATIONS_PER_COMMAND = 2;
+
+// One of each Edit*/Move command, spread over the day
+void runRound(UndoManager& history, TaskManager& manager, int round) {
+  int index = 1 + round % (TASKS - 2);
+  const Act& task = manager.getTaskView(index);
+  int length = task.getLength();
+  std::string name = task.getName();
+
+  history.executeCommand(history.createCommand<EditTaskLengthCommand>(&manager, index, length, length % 50 + 10));
+  history.executeCommand(history.createCommand<EditTaskNameCommand>(&manager, index, name, round % 2 ? "Email" : "Review"));
+  history.executeCommand(history.createCommand<EditTaskStartTimeCommand>(&manager, index, "", "09:30", task.isFixed(), true));
+  history.executeCommand(history.createCommand<MoveTaskUpCommand>(&manager, index, manager.getTaskView(index).isFixed()));
+  history.executeCommand(history.createCommand<MoveTaskDownCommand>(&manager, index - 1, manager.getTaskView(index - 1).isFixed()));
+}
+
+}  // namespace
+
+int main() {
+  TaskManager manager(420);
+  for (int i = 0; i < TASKS; i++) {
+    manager.addTask("Task", 30, false);
+  }
+
+  // Every command its own entry, so the history fills up and evicts
+  UndoManager history;
+  history.setMergeWindow(std::chrono::milliseconds(0));
+
+  // Fill the history past its limit so the pool holds recycled blocks
+  for (int round = 0; round < WARMUP_ROUNDS; round++) {
+    runRound(history, manager, round);
+  }
+
+  // Only the commands are measured; the schedule is recomputed once, after
+  TaskManager::RecalcScope batch(manager);
+  size_t before = allocations.load();
+  for (int round = 0; round < MEASURED_ROUNDS; round++) {
+    runRound(history, manager, round);
+  }
+  size_t commands = MEASURED_ROUNDS * COMMANDS_PER_ROUND;
+  size_t counted = allocations.load() - before;
+
+  std::printf("%zu heap allocations for %zu commands\n", counted, commands);
+  if (counted > commands * MAX_ALLOCATIONS_PER_COMMAND) {
+    std::printf("FAIL: more than %zu per command\n", MAX_ALLOCATIONS_PER_COMMAND);
+    return 1;
+  }
+  return 0;
+}
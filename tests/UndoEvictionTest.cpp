@@ -0,0 +1,68 @@
+// Once the undo history is full every new entry evicts an old one. Eviction
+// should take a fixed amount of work however large the tree has grown, so
+// this fills a history with branches left behind by undo-then-edit and
+// fails if an eviction looks at more than a few nodes on average.
+
+#include <chrono>
+#include <cstdio>
+#include "TaskManager.h"
+#include "UndoManager.h"
+
+namespace {
+
+constexpr int TASKS = 20;
+constexpr size_t MAX_ENTRIES = 2000;
+constexpr int MEASURED_COMMANDS = 10000;
+constexpr size_t MAX_VISITS_PER_EVICTION = 4;
+
+// Edit lengths, and every so often undo a few and edit again, which leaves
+// the undone entries as an abandoned branch
+void runStep(UndoManager& history, TaskManager& manager, int step) {
+  if (step % 7 == 6) {
+    for (int i = 0; i < 3; i++) {
+      history.undo();
+    }
+  }
+  int index = step % TASKS;
+  int length = manager.getTaskView(index).getLength();
+  history.executeCommand(history.createCommand<EditTaskLengthCommand>(&manager, index, length, length % 50 + 10));
+}
+
+}  // namespace
+
+int main() {
+  TaskManager manager(420);
+  for (int i = 0; i < TASKS; i++) {
+    manager.addTask("Task", 30, false);
+  }
+  TaskManager::RecalcScope batch(manager);
+
+  UndoManager history(MAX_ENTRIES, SIZE_MAX);
+  history.setMergeWindow(std::chrono::milliseconds(0));
+
+  // Fill the history, then go past the limit so branches are being evicted
+  int step = 0;
+  for (; step < static_cast<int>(2 * MAX_ENTRIES); step++) {
+    runStep(history, manager, step);
+  }
+
+  size_t before = history.getEvictionVisits();
+  for (int i = 0; i < MEASURED_COMMANDS; i++, step++) {
+    runStep(history, manager, step);
+  }
+  size_t visits = history.getEvictionVisits() - before;
+
+  // Each new entry evicts one, so the history stays at the limit
+  size_t kept = history.getHistoryTree().size() - 1;
+  if (kept != MAX_ENTRIES) {
+    std::printf("FAIL: %zu entries kept, expected %zu\n", kept, MAX_ENTRIES);
+    return 1;
+  }
+
+  std::printf("%zu nodes visited for %d evictions\n", visits, MEASURED_COMMANDS);
+  if (visits > MEASURED_COMMANDS * MAX_VISITS_PER_EVICTION) {
+    std::printf("FAIL: more than %zu per eviction\n", MAX_VISITS_PER_EVICTION);
+    return 1;
+  }
+  return 0;
+}